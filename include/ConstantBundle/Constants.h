@@ -35,8 +35,35 @@ public:
 
     void add(Value *val);
     Value *get(uint32_t i);
+    Value *at(uint32_t i);
+    size_t size();
 
     static Constants *create();
 protected:
     Values values;
-};
\ No newline at end of file
+};
+
+ORM_TYPE_OF(Constants, OBJECT_TYPE_CONSTANTS)
+
+/**
+ * Get value without bounds check, index must be validated.
+ *
+ * @param i
+ * @return
+ */
+inline Value *
+Constants::at(uint32_t i)
+{
+    return this->values[i];
+}
+
+/**
+ * Get number of values.
+ *
+ * @return
+ */
+inline size_t
+Constants::size()
+{
+    return this->values.size();
+}
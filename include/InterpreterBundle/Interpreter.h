@@ -23,23 +23,20 @@
 #pragma once
 
 #include <ThreadBundle/Thread.h>
-#include <thread>
+#include <ThreadBundle/Scheduler.h>
 #include <ConstantBundle/Constants.h>
-
-using CircularThreads = std::map<uint32_t, std::thread>;
+#include <memory>
 
 class Interpreter : Object {
 public:
-    Interpreter(uint64_t id);
+    Interpreter(uint64_t id, size_t workers = 0);
 
     void run();
 
-    void addThread(Method *m);
-    void removeThread(uint32_t id);
+    bool addThread(Method *m);
 
     Constants *getConstants();
 protected:
-    CircularThreads threads;
+    std::unique_ptr<Scheduler> scheduler;
     uint32_t nextId;
-    void stop();
 };
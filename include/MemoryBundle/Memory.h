@@ -24,6 +24,7 @@
 
 #include <cstdint>
 #include "ORM/Object.h"
+#include "ORM/RepositoryIndex.h"
 
 /**
  * The memory object.
@@ -52,9 +53,14 @@ public:
     void operator-=(uint32_t size);
     void assign(uintptr_t address, uint32_t size);
     bool isReadyToRemove();
+    bool isFreezable() override;
+    size_t getFootprint() override;
 
     static Memory *create(uintptr_t address, uint32_t size);
+    static HashIndex<uintptr_t> *getAddressIndex();
 protected:
     uintptr_t address;
     uint32_t size;
-};
\ No newline at end of file
+};
+
+ORM_TYPE_OF(Memory, OBJECT_TYPE_MEMORY)
@@ -64,4 +64,6 @@ protected:
     uint32_t capacity;
     uintptr_t startAddress;
     std::vector<uint8_t> field;
-};
\ No newline at end of file
+};
+
+ORM_TYPE_OF(MemoryChunk, OBJECT_TYPE_MEMORY_CHUNK)
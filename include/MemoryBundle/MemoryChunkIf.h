@@ -37,6 +37,7 @@ public:
     void freeMemoryAdd(uintptr_t address, uint32_t size);
     void freeMemoryRemove(Memory *mem);
     Memory *freeMemoryFind(std::function<bool(Memory *)> foo);
+    Memory *freeMemoryAt(uintptr_t address);
     Memory *freeMemoryFront();
     uint32_t freeMemoryCount();
     void freeMemoryDeleteAll();
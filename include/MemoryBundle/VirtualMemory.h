@@ -56,4 +56,6 @@ protected:
     uint32_t allocatedTotal;
     uint32_t maxAllocatedBytes;
     Relationship *memoryChunkRelationship;
-};
\ No newline at end of file
+};
+
+ORM_TYPE_OF(VirtualMemory, OBJECT_TYPE_VIRTUAL_MEMORY)
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <MethodBundle/InstructionResult.h>
+#include <MethodBundle/Instruction/OpCode.h>
+#include <VariableBundle/TaggedValue.h>
+#include "ForwardDeclarations.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Constants;
+
+/*
+ * Number of falls back to generic form after which operation
+ * is not specialized anymore.
+ */
+#define BYTECODE_DEOPT_LIMIT (4)
+
+/**
+ * Instruction with pre-decoded operands.
+ * Arithmetic operations count falls back to generic form in b,
+ * c is used by superinstructions only.
+ */
+struct BytecodeOp {
+    eOpCode op;
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+};
+
+/**
+ * Counts of executed pairs of adjacent instructions.
+ * Can be shared by many methods.
+ */
+class BytecodeProfile {
+public:
+    BytecodeProfile();
+
+    void record(eOpCode first, eOpCode second);
+    uint64_t getCount(eOpCode first, eOpCode second) const;
+    bool isHot(const eOpCode *sequence, size_t length, uint64_t threshold) const;
+    void clear();
+protected:
+    std::vector<uint64_t> counts;
+};
+
+/**
+ * Execution mode of compiled method.
+ */
+enum eExecutionMode {
+    EXECUTION_MODE_STACK,
+    EXECUTION_MODE_REGISTER
+};
+
+/**
+ * Source of register instruction operand.
+ */
+enum eRegisterSource : uint32_t {
+    REGISTER_SOURCE_SLOT,
+    REGISTER_SOURCE_CONSTANT,
+    REGISTER_SOURCE_STACK
+};
+
+/**
+ * Register instruction, op codes keep their meaning.
+ * Destination is frame slot a, operand is addressed by source and b,
+ * CREATE keeps type in b. Arithmetic operations count falls back to
+ * generic form in deopts.
+ */
+struct RegisterOp {
+    eOpCode op;
+    uint32_t a;
+    uint32_t b;
+    eRegisterSource source;
+    uint32_t deopts;
+};
+
+/**
+ * Frame slot of compiled method.
+ * Scalar variable is held unboxed in value until it needs
+ * object identity, then it is held by var.
+ */
+struct FrameSlot {
+    Var *var;
+    TaggedValue value;
+};
+
+/*
+ * No frame slot.
+ */
+#define NO_FRAME_SLOT (UINT32_MAX)
+
+/**
+ * Method lowered to contiguous array of instructions.
+ *
+ * Operands are decoded once. Each variable name is resolved to frame
+ * slot, instructions address variables by slot, method keeps frame
+ * of variables indexed by slot. Scalars on stack and in frame are
+ * unboxed, they are boxed only when they escape into object.
+ */
+class Bytecode {
+public:
+    Bytecode();
+
+    void emit(eOpCode op, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0);
+    uint32_t addSlot(const std::wstring &name);
+    uint32_t findSlot(const std::string &name);
+    const std::string &getName(uint32_t slot);
+    size_t getSlotCount();
+
+    BytecodeOp &at(size_t pc);
+    RegisterOp &registerAt(size_t pc);
+    size_t size();
+
+    bool link(Constants *pool);
+    bool translate();
+    size_t fuse(const BytecodeProfile *profile = nullptr, uint64_t threshold = 1);
+    void setProfile(BytecodeProfile *profile);
+    bool setMode(eExecutionMode mode);
+    eExecutionMode getMode();
+
+    instruction_result execute(Method *m, size_t &pc, size_t budget);
+
+    size_t getQuickenCount();
+    size_t getDeoptCount();
+    size_t getExecutedCount();
+protected:
+    bool link(Thread *thread);
+    Var *resolve(Method *m, FrameSlot *frame, uint32_t slot);
+
+    bool create(Method *m, FrameSlot *frame, uint32_t slot, eObjectType type);
+    bool assign(Method *m, FrameSlot *frame, uint32_t slot, TaggedValue v);
+    bool arithmetic(Method *m, FrameSlot *frame, eOpCode &code, uint32_t &deopts, uint32_t slot, TaggedValue operand);
+    bool fetch(Method *m, FrameSlot *frame, Thread *&thread, RegisterOp &op, TaggedValue &v);
+
+    instruction_result executeStack(Method *m, size_t &pc, size_t budget);
+    instruction_result executeRegisters(Method *m, size_t &pc, size_t budget);
+
+    std::vector<BytecodeOp> code;
+
+    /*
+     * Register form of code, translated on demand.
+     */
+    std::vector<RegisterOp> registerCode;
+    eExecutionMode mode;
+
+    /*
+     * Profile of executed instructions, nullptr if not profiled.
+     */
+    BytecodeProfile *profile;
+    std::vector<std::string> slotNames;
+
+    /*
+     * Constant pool, resolved on first use.
+     */
+    Constants *constants;
+
+    /*
+     * Constant pool with scalars unboxed, indexed by constant number.
+     */
+    std::vector<TaggedValue> constantValues;
+
+    size_t quickenCount;
+    size_t deoptCount;
+    size_t executedCount;
+};
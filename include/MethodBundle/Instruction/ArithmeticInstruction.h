@@ -0,0 +1,44 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "Instruction.h"
+
+/**
+ * OP_CODE_ADD <name>
+ * OP_CODE_SUB <name>
+ * OP_CODE_MUL <name>
+ *
+ * Pop value and apply it to variable.
+ */
+class ArithmeticInstruction : public Instruction {
+public:
+    ArithmeticInstruction(eOpCode op, std::vector<std::wstring> &arg);
+    static ArithmeticInstruction *create(eOpCode op, std::wstring name);
+    Instruction *execute() override;
+    bool validate() override;
+    bool compile(Bytecode &bytecode) override;
+
+    static bool apply(eOpCode op, Value &target, Value &operand);
+};
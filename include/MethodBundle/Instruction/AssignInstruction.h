@@ -27,10 +27,11 @@
 /**
  * OP_CODE_POP_AND_STORE <name>
  */
-class AssignInstruction : Instruction {
+class AssignInstruction : public Instruction {
 public:
     explicit AssignInstruction(std::vector<std::wstring> &arg);
     static AssignInstruction *create(std::wstring name);
     Instruction *execute() override;
     bool validate() override;
+    bool compile(Bytecode &bytecode) override;
 };
\ No newline at end of file
@@ -33,4 +33,7 @@ public:
     static CreateInstruction *create(std::wstring name, std::wstring type);
     Instruction *execute() override;
     bool validate() override;
+    bool compile(Bytecode &bytecode) override;
+
+    static Var *createVar(Method *m, const std::string &name, eObjectType type);
 };
\ No newline at end of file
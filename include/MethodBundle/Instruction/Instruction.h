@@ -27,6 +27,7 @@
 #include "ForwardDeclarations.h"
 #include "VariableBundle/Primitive/DataType.h"
 #include "OpCode.h"
+#include <MethodBundle/Bytecode.h>
 
 /**
  * @brief The instruction class
@@ -39,6 +40,7 @@ public:
     eOpCode &getOpCode();
 
     Instruction *executeIt();
+    virtual bool compile(Bytecode &bytecode) = 0;
 protected:
     eOpCode op;
     std::vector<std::wstring> arg;
@@ -58,4 +60,6 @@ protected:
 
     virtual Instruction *execute() {};
     virtual bool validate() {};
-};
\ No newline at end of file
+};
+
+ORM_TYPE_OF(Instruction, OBJECT_TYPE_INSTRUCTION)
@@ -25,5 +25,27 @@
 typedef enum {
     OP_CODE_CREATE,
     OP_CODE_ASSIGN,
-    OP_CODE_PUSH_CONSTANT
-} eOpCode;
\ No newline at end of file
+    OP_CODE_PUSH_CONSTANT,
+    OP_CODE_ADD,
+    OP_CODE_SUB,
+    OP_CODE_MUL,
+
+    /*
+     * Type specialized forms, written into bytecode by quickening only.
+     */
+    OP_CODE_INT_ADD,
+    OP_CODE_INT_SUB,
+    OP_CODE_INT_MUL,
+    OP_CODE_FLOAT_ADD,
+    OP_CODE_FLOAT_SUB,
+    OP_CODE_FLOAT_MUL,
+    OP_CODE_STRING_CONCAT,
+
+    /*
+     * Superinstructions, written into bytecode by fusion only.
+     */
+    OP_CODE_ASSIGN_CONSTANT,
+    OP_CODE_CREATE_ASSIGN_CONSTANT
+} eOpCode;
+
+#define OP_CODE_COUNT (OP_CODE_CREATE_ASSIGN_CONSTANT + 1)
\ No newline at end of file
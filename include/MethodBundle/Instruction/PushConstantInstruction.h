@@ -32,4 +32,15 @@ public:
     explicit PushConstantInstruction(std::vector<std::wstring> &arg);
     static PushConstantInstruction *create(std::vector<std::wstring> &arg);
     Instruction *execute() override;
+    bool validate() override;
+    bool compile(Bytecode &bytecode) override;
+protected:
+    bool decode();
+
+    /*
+     * Operands decoded on validation.
+     */
+    uint32_t constNo;
+    Constants *constants;
+    Method *method;
 };
\ No newline at end of file
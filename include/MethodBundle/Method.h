@@ -23,14 +23,11 @@
 #pragma once
 
 #include <VariableBundle/Value.h>
+#include <MethodBundle/InstructionResult.h>
+#include <MethodBundle/Bytecode.h>
 #include "VariableBundle/Primitive/DataType.h"
 #include "ForwardDeclarations.h"
-
-typedef enum {
-    INSTRUCTION_OK,
-    INSTRUCTION_ERROR,
-    INSTRUCTION_FINISHED
-} instruction_result;
+#include <memory>
 
 /**
  * @brief The method class
@@ -43,11 +40,21 @@ public:
     eObjectType getObjectType() override;
     instruction_result step();
 
+    bool compile(bool fuse = true);
+    bool isCompiled();
+    Bytecode *getBytecode();
+    bool setMode(eExecutionMode mode);
+    bool fuse(const BytecodeProfile *profile = nullptr, uint64_t threshold = 1);
+    instruction_result run();
+    instruction_result execute(size_t budget);
+
     void push(Value *v);
-    Value *pop();
+    TaggedValue popTagged();
 
     void addVar(Var *v);
     Var *getVar(std::wstring id);
+    Var *getVar(const std::string &id);
+    FrameSlot *getFrame();
 
     void clear();
 
@@ -87,4 +94,17 @@ public:
 
 protected:
     Instruction *currentInstruction;
-};
\ No newline at end of file
+
+    /*
+     * Compiled instructions, nullptr if not compiled.
+     */
+    std::unique_ptr<Bytecode> bytecode;
+    size_t pc;
+
+    /*
+     * Variables of compiled method, indexed by frame slot.
+     */
+    std::vector<FrameSlot> frame;
+};
+
+ORM_TYPE_OF(Method, OBJECT_TYPE_METHOD)
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <ORM/FwDecl.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/*
+ * Maximum number of threads inside epoch at once.
+ */
+#define ORM_EPOCH_SLOTS (64)
+
+/**
+ * Concurrent ORM mode.
+ *
+ * Repositories are sharded by object address and locked per shard,
+ * so creating objects and looking them up by ID or type run in
+ * parallel. Edits of object graph are not: adding and removing
+ * relationships, cascades, sweep and VirtualMemory allocation are
+ * serialized by ORM::Lock, since a removal may orphan and cascade
+ * through any object. Swept objects are released only after no
+ * thread inside an epoch can reach them.
+ * In default mode none of this costs more than a flag check.
+ */
+namespace ORM {
+    extern std::atomic<bool> concurrent;
+
+    void setConcurrent(bool enabled);
+    bool isConcurrent();
+
+    void retire(std::vector<std::unique_ptr<Object>> &objects);
+    void reclaim();
+    size_t getRetiredCount();
+
+    /**
+     * Lock of object graph, held while relationships are edited
+     * and repositories are swept. Recursive, no-op in default mode.
+     */
+    class Lock {
+    public:
+        Lock();
+        ~Lock();
+    protected:
+        bool locked;
+    };
+
+    /**
+     * Epoch guard. Objects swept while any guard is held are
+     * released after all guards entered before the sweep are left.
+     */
+    class EpochGuard {
+    public:
+        EpochGuard();
+        ~EpochGuard();
+    protected:
+        bool entered;
+    };
+}
+
+/**
+ * Check if ORM runs in concurrent mode.
+ *
+ * @return true if concurrent, otherwise false.
+ */
+inline bool
+ORM::isConcurrent()
+{
+    return ORM::concurrent.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <ORM/FwDecl.h>
+#include <ORM/TypeOf.h>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Number of slots in one handle table page.
+ */
+#define HANDLE_PAGE_SLOTS (1024)
+
+/*
+ * Maximum number of handle table pages.
+ */
+#define HANDLE_PAGES (16384)
+
+/**
+ * Object handle, index of slot in handle table and generation
+ * of the slot when handle was taken. Slot generation changes
+ * when object is freed, so stale handle resolves to nullptr.
+ * Generation 0 is null handle.
+ */
+struct ObjectHandle {
+    uint32_t index;
+    uint32_t generation;
+
+    bool operator==(const ObjectHandle &h) const;
+    bool operator!=(const ObjectHandle &h) const;
+};
+
+namespace ORM {
+    ObjectHandle getHandle(Object *o);
+    Object *resolve(ObjectHandle handle);
+    void releaseHandle(Object *o);
+    size_t getHandleCount();
+
+    /**
+     * Typed object handle.
+     *
+     * Holds no pointer, resolving it is O(1) and never touches
+     * freed object. Objects that are destroyed but not yet swept
+     * resolve to nullptr too.
+     */
+    template<typename T>
+    class Handle {
+    public:
+        Handle();
+        explicit Handle(T *o);
+
+        T *get() const;
+        T *operator->() const;
+        explicit operator bool() const;
+        bool operator==(const Handle<T> &h) const;
+        bool operator!=(const Handle<T> &h) const;
+
+        ObjectHandle getRaw() const;
+    protected:
+        ObjectHandle handle;
+    };
+}
+
+/**
+ * Compare handles.
+ *
+ * @param h
+ * @return true if same, otherwise false.
+ */
+inline bool
+ObjectHandle::operator==(const ObjectHandle &h) const
+{
+    return (this->index == h.index) && (this->generation == h.generation);
+}
+
+/**
+ * Compare handles.
+ *
+ * @param h
+ * @return true if different, otherwise false.
+ */
+inline bool
+ObjectHandle::operator!=(const ObjectHandle &h) const
+{
+    return !(*this == h);
+}
+
+/**
+ * The constructor, null handle.
+ */
+template<typename T>
+ORM::Handle<T>::Handle()
+{
+    this->handle = ObjectHandle{0, 0};
+}
+
+/**
+ * The constructor.
+ *
+ * @param o - the object.
+ */
+template<typename T>
+ORM::Handle<T>::Handle(T *o)
+{
+    this->handle = ORM::getHandle(o);
+}
+
+/**
+ * Get object.
+ *
+ * @return object if alive, otherwise nullptr.
+ */
+template<typename T>
+T *
+ORM::Handle<T>::get() const
+{
+    return static_cast<T *>(ORM::resolve(this->handle));
+}
+
+/**
+ * Get object.
+ *
+ * @return object if alive, otherwise nullptr.
+ */
+template<typename T>
+T *
+ORM::Handle<T>::operator->() const
+{
+    return this->get();
+}
+
+/**
+ * Check if handle refers to alive object.
+ */
+template<typename T>
+ORM::Handle<T>::operator bool() const
+{
+    return this->get() != nullptr;
+}
+
+/**
+ * Compare handles.
+ *
+ * @param h
+ * @return true if same, otherwise false.
+ */
+template<typename T>
+bool
+ORM::Handle<T>::operator==(const Handle<T> &h) const
+{
+    return this->handle == h.handle;
+}
+
+/**
+ * Compare handles.
+ *
+ * @param h
+ * @return true if different, otherwise false.
+ */
+template<typename T>
+bool
+ORM::Handle<T>::operator!=(const Handle<T> &h) const
+{
+    return this->handle != h.handle;
+}
+
+/**
+ * Get untyped handle.
+ *
+ * @return handle.
+ */
+template<typename T>
+ObjectHandle
+ORM::Handle<T>::getRaw() const
+{
+    return this->handle;
+}
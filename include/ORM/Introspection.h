@@ -0,0 +1,96 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <ORM/FwDecl.h>
+#include <ORM/eObjectType.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Fan-out histogram buckets, bucket i counts objects holding
+ * [2^(i-1), 2^i) slaves, bucket 0 objects holding none.
+ */
+#define INTROSPECTION_FANOUT_BUCKETS (24)
+
+/*
+ * Number of largest retainers reported by default.
+ */
+#define INTROSPECTION_TOP_RETAINERS (16)
+
+#define HEAP_DUMP_MAGIC (0x48584f42u)
+#define HEAP_DUMP_VERSION (1)
+
+/**
+ * Statistics of one object type.
+ */
+struct TypeStats {
+    eObjectType type;
+    size_t objects;
+    size_t bytes;
+    size_t marked;
+    size_t frozen;
+    size_t edges;
+    size_t fanout[INTROSPECTION_FANOUT_BUCKETS];
+};
+
+/**
+ * Master object holding many slaves.
+ */
+struct Retainer {
+    Object *object;
+    eObjectType type;
+    std::string id;
+    size_t slaves;
+};
+
+/**
+ * Statistics of all repositories.
+ */
+struct HeapStats {
+    std::vector<TypeStats> types;
+    std::vector<Retainer> retainers;
+    size_t objects;
+    size_t bytes;
+    size_t marked;
+
+    const TypeStats *getType(eObjectType type) const;
+};
+
+/**
+ * Heap dump layout, integers in host byte order, strings u32 length prefixed:
+ *
+ *   u32 magic, u32 version, u64 object count,
+ *   per object: u64 address, u32 type, string id, u8 flags
+ *   (1 marked, 2 frozen), u64 bytes, u32 relationship count,
+ *   per master relationship: string name, u8 type, u32 slave count,
+ *   u64 address of each slave.
+ */
+namespace ORM {
+    HeapStats inspect(size_t topRetainers = INTROSPECTION_TOP_RETAINERS);
+    size_t getFanoutBucket(size_t slaves);
+    bool dumpHeap(const std::string &path);
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <ORM/FwDecl.h>
+#include <string>
+
+/**
+ * Observer of ORM changes.
+ *
+ * Operations done inside another journaled operation (cascades)
+ * are reported as nested.
+ */
+class Journal {
+public:
+    virtual void onCreate(Object *o) = 0;
+    virtual void onDestroy(Object *o) = 0;
+    virtual void onChangeId(Object *o, const std::string &newId) = 0;
+    virtual void onAdd(Object *master, Relationship *r, Object *slave, bool nested) = 0;
+    virtual void onRemove(Object *master, Relationship *r, Object *slave, bool nested) = 0;
+    virtual void onClear(Object *master, Relationship *r, bool nested) = 0;
+    virtual void onRelease(Object *o) = 0;
+
+    virtual ~Journal() = default;
+};
+
+namespace ORM {
+    void setJournal(Journal *journal);
+    Journal *getJournal();
+
+    /**
+     * Scope of a journaled operation.
+     */
+    class JournalScope {
+    public:
+        JournalScope();
+        ~JournalScope();
+
+        Journal *getJournal();
+        bool isNested();
+    protected:
+        Journal *journal;
+        bool nested;
+    };
+}
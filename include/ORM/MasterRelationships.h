@@ -23,15 +23,19 @@
 #pragma once
 
 #include <ORM/Relationships.h>
+#include <vector>
 
 class MasterRelationships : public Relationships {
 public:
     explicit MasterRelationships(Object *self);
 
     void add(std::string relationshipName, Object *o) override;
+    void addMany(const std::string &relationshipName, const std::vector<Object *> &objects);
     void remove(std::string relationshipName, Object *o) override;
     void clearObjects();
     void clearObjects(std::string relationshipName);
 
     ~MasterRelationships();
+protected:
+    bool claimObjects(Relationship *r);
 };
@@ -24,8 +24,10 @@
 
 #include <ORM/ObjectRepository.h>
 #include <ORM/eObjectType.h>
+#include <ORM/TypeOf.h>
 #include <string>
 #include <functional>
+#include <vector>
 
 /**
  * ORM interface.
@@ -34,14 +36,57 @@ namespace ORM {
     ObjectRepository *findObjectRepository(eObjectType type);
     void addObjectRepository(eObjectType type);
     Object *create(Object *o);
+    void createMany(std::vector<Object *> &objects);
     void changeId(Object *o, std::string new_id);
     void destroy(Object *o);
+    void destroyMany(const std::vector<Object *> &objects);
     void sweep();
     Object *select(eObjectType type, std::function<bool(Object *)> where);
     Object *select(eObjectType type, std::string id);
     Object *getFirst(eObjectType type);
+    Object *getSingleton(eObjectType type);
+    void registerSingleton(Object *o);
+    bool isSingleton(Object *o);
     void removeObjectRepository(eObjectType type);
     void removeAllRepositories();
+    void forEachRepository(const std::function<void(eObjectType, ObjectRepository *)> &func);
+
+    bool freeze(eObjectType type);
+    bool freeze(Object *root);
+    bool checkFrozen(Object *o);
+    bool canCreate(eObjectType type);
+    size_t getFrozenViolations();
+
+    template<typename T>
+    T *create(T *o);
+
+    template<typename T>
+    bool canCreate();
+}
+
+/**
+ * Add new object to repository, keeping its type.
+ *
+ * @param o - object.
+ * @return the object.
+ */
+template<typename T>
+T *
+ORM::create(T *o)
+{
+    return static_cast<T *>(ORM::create(static_cast<Object *>(o)));
+}
+
+/**
+ * Check repository of class before object is built.
+ *
+ * @return true if object can be created, otherwise false.
+ */
+template<typename T>
+bool
+ORM::canCreate()
+{
+    return ORM::canCreate(ORM::TypeOf<T>::value);
 }
 
 #define ORM_DESTROY(__OBJ__) \
@@ -25,26 +25,31 @@
 #include <ORM/FwDecl.h>
 #include <ORM/eRelationshipType.h>
 #include <ORM/eObjectType.h>
+#include <ORM/TypeOf.h>
 #include <ORM/MasterRelationships.h>
 #include <ORM/SlaveRelationships.h>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <map>
 #include <memory>
 #include <vector>
 #include <string>
 
-using MasterRelationshipsPtr = std::unique_ptr<MasterRelationships>;
-using SlaveRelationshipsPtr = std::unique_ptr<SlaveRelationships>;
-
 /**
  * The object class.
  * Each object can have relationship with another object.
  * Usage is to extend data as object base class.
+ *
+ * Objects are stored in object pool, relationships are
+ * stored within object.
  */
 class Object {
 public:
     explicit Object(uint64_t id);
     explicit Object(std::string id);
+    Object(const Object &) = delete;
+    Object &operator=(const Object &) = delete;
 
     std::string getId();
     void setId(std::string newId);
@@ -54,12 +59,33 @@ public:
     bool getMarked();
     void setMarked(bool marked);
 
+    bool isFrozen();
+    void setFrozen(bool frozen);
+    virtual bool isFreezable();
+    virtual size_t getFootprint();
+
     MasterRelationships *getMaster();
     SlaveRelationships *getSlave();
+
+    virtual bool hasObservableDestructor();
+
+    uint32_t getHandleIndex();
+    void setHandleIndex(uint32_t index);
+
+    static void *operator new(size_t size);
+    static void operator delete(void *p, size_t size);
+
+    virtual ~Object();
 protected:
     bool marked;
+    bool frozen;
+
+    /*
+     * Read without lock by ORM::getHandle, set under handle table lock.
+     */
+    std::atomic<uint32_t> handleIndex;
     std::string id;
 
-    MasterRelationshipsPtr masterRelationshipsPtr;
-    SlaveRelationshipsPtr slaveRelationshipsPtr;
+    MasterRelationships masterRelationships;
+    SlaveRelationships slaveRelationships;
 };
\ No newline at end of file
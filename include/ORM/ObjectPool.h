@@ -0,0 +1,56 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+
+/*
+ * Slot size granularity in bytes.
+ */
+#define OBJECT_POOL_GRANULARITY (16)
+
+/*
+ * Objects larger than this are not pooled.
+ */
+#define OBJECT_POOL_MAX_SIZE (1024)
+
+/*
+ * Number of slots allocated at once.
+ */
+#define OBJECT_POOL_SLAB_SLOTS (64)
+
+/**
+ * Object storage pools.
+ *
+ * Each object size has its own pool, so objects of same type
+ * share one. Released slots are kept on free list and reused
+ * by the next object of that size. In concurrent mode each
+ * pool has its own lock.
+ */
+namespace ObjectPool {
+    void *allocate(size_t size);
+    void release(void *p, size_t size);
+    size_t getFreeCount(size_t size);
+    void setConcurrent(bool enabled);
+}
@@ -20,16 +20,52 @@
  * THE SOFTWARE.
  */
 
+
 #pragma once
 
 #include "FwDecl.h"
+#include "RepositoryIndex.h"
+#include "Concurrency.h"
+#include <atomic>
 #include <map>
 #include <vector>
 #include <string>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <utility>
+
+/*
+ * Number of shards of a repository in concurrent mode.
+ */
+#define ORM_REPOSITORY_SHARDS (16)
+
+using ObjectPtr = std::unique_ptr<Object>;
 
-using ObjectPtr = std::shared_ptr<Object>;
+/**
+ * Part of object repository, objects are placed by hash of address,
+ * their ID index entries by hash of ID.
+ */
+struct ObjectRepositoryShard {
+    std::recursive_mutex mutex;
+
+    /*
+     * key    -> Object ID
+     * values -> Object array
+     */
+    std::map<std::string, std::vector<ObjectPtr>> objectMap;
+
+    /*
+     * All objects in insertion order, for typed scans.
+     */
+    std::vector<Object *> objects;
+
+    /*
+     * key    -> Object ID hashed to this shard
+     * values -> Objects of any shard in insertion order
+     */
+    std::map<std::string, std::vector<Object *>> idMap;
+};
 
 /**
  * The object_repository class.
@@ -39,17 +75,86 @@ using ObjectPtr = std::shared_ptr<Object>;
  */
 class ObjectRepository {
 public:
+    explicit ObjectRepository(size_t shardCount = 1);
+
     Object *find(const std::function<bool(Object *)> &func);
     Object *get(std::string &id);
     void add(Object *o);
+    void reserve(size_t count);
     void remove(Object *o);
     void changeId(Object *o, std::string &newId);
     void sweep();
+    void collect(std::vector<ObjectPtr> &swept);
+    size_t size();
+    size_t getShardCount();
+    size_t getShardSize(size_t index);
+    RepositoryIndex *addIndex(const std::string &name, RepositoryIndex *index);
+    RepositoryIndex *getIndex(const std::string &name);
+
+    void freeze();
+    void thaw();
+    bool isFrozen();
+
+    template<typename F>
+    bool scan(F &&func);
+
     ~ObjectRepository();
 protected:
+    ObjectRepositoryShard &getShard(Object *o);
+    ObjectRepositoryShard &getShard(const std::string &id);
+    void indexId(Object *o);
+    void unindexId(Object *o, const std::string &id);
+    Object *getFrozen(const std::string &id);
+
+    size_t shardCount;
+    std::unique_ptr<ObjectRepositoryShard[]> shards;
+
     /*
-     * key    -> Object ID
-     * values -> Object array
+     * key    -> Index name
+     * values -> Secondary index
      */
-    std::map<std::string, std::vector<ObjectPtr>> objectMap;
-};
\ No newline at end of file
+    std::map<std::string, RepositoryIndexPtr> indexes;
+    std::atomic<bool> indexed;
+
+    /*
+     * Frozen repository is read without locks, IDs are
+     * looked up in flat array sorted by ID.
+     */
+    std::atomic<bool> frozen;
+    std::vector<std::pair<std::string, Object *>> frozenObjects;
+};
+
+/**
+ * Call function for each object, shard by shard in insertion order.
+ *
+ * @param func - function taking Object *, returns true to stop.
+ * @return true if stopped, otherwise false.
+ */
+template<typename F>
+bool
+ObjectRepository::scan(F &&func)
+{
+    for (size_t i = 0; i < this->shardCount; i++)
+    {
+        ObjectRepositoryShard &shard = this->shards[i];
+        std::unique_lock<std::recursive_mutex> lock(shard.mutex, std::defer_lock);
+
+        if (ORM::isConcurrent() && !this->frozen.load(std::memory_order_acquire))
+        {
+            lock.lock();
+        }
+
+        /*
+         * Function may add objects, objects are visited by index.
+         */
+        for (size_t j = 0; j < shard.objects.size(); j++)
+        {
+            if (func(shard.objects[j]))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
@@ -28,6 +28,16 @@
 #include <string>
 #include <functional>
 #include <memory>
+#include <unordered_map>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Relationships smaller than this are searched linearly,
+ * bigger ones keep an object -> slot index.
+ */
+#define RELATIONSHIP_INDEX_THRESHOLD (16)
 
 typedef enum {
     FOREACH_CONTINUE,
@@ -35,17 +45,96 @@ typedef enum {
     FOREACH_IT1_REMOVED
 } eForEachResult;
 
-using ObjVector = std::vector<Object *>;
+/*
+ * Number of objects relationship holds without allocating.
+ */
+#define RELATIONSHIP_INLINE_OBJECTS (2)
+
+/**
+ * Relationship name and type. Declarations are interned,
+ * all relationships of the same name and type share one.
+ */
+struct RelationshipDecl {
+    std::string name;
+    eRelationshipType type;
+};
+
+using ObjIndex = std::unordered_multimap<Object *, size_t>;
+
+/**
+ * Vector of object slots, first RELATIONSHIP_INLINE_OBJECTS are held
+ * inline. Most relationships hold one or two objects and never allocate.
+ */
+class ObjSlots {
+public:
+    ObjSlots();
+    ObjSlots(const ObjSlots &) = delete;
+    ObjSlots &operator=(const ObjSlots &) = delete;
+    ~ObjSlots();
+
+    Object *&operator[](size_t pos) { return this->data[pos]; }
+    Object *operator[](size_t pos) const { return this->data[pos]; }
+    Object **begin() { return this->data; }
+    Object **end() { return this->data + this->length; }
+    Object *back() const { return this->data[this->length - 1]; }
+    size_t size() const { return this->length; }
+    size_t capacity() const { return this->allocated; }
+    bool isInline() const { return this->data == this->local; }
+
+    void push_back(Object *o);
+    void pop_back();
+    void erase(Object **first, Object **last);
+    void clear();
+    void reserve(size_t count);
+    void shrink_to_fit();
+protected:
+    void reallocate(size_t count);
+
+    Object **data;
+    uint32_t length;
+    uint32_t allocated;
+    Object *local[RELATIONSHIP_INLINE_OBJECTS];
+};
 
 /**
  * The relationship class.
  * Contains and manages all objects in relationship.
+ *
+ * Objects are kept in a dense slot vector in insertion order.
+ * Removed objects leave an empty slot behind, so removing is O(1)
+ * and iteration order stays stable. Empty slots are compacted
+ * on insertion and sort.
  */
-class Relationship : public ObjVector {
+class Relationship {
 public:
-    Relationship(std::string relationshipName, eRelationshipType type);
+    /**
+     * Iterator that skips empty slots.
+     */
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Object *;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Object **;
+        using reference = Object *;
+
+        Iterator(const ObjSlots *slots, size_t pos);
+
+        Object *operator*() const;
+        Iterator &operator++();
+        Iterator operator++(int);
+        bool operator==(const Iterator &it) const;
+        bool operator!=(const Iterator &it) const;
+    protected:
+        const ObjSlots *slots;
+        size_t pos;
+    };
 
-    std::string &getName();
+    explicit Relationship(const RelationshipDecl *decl);
+
+    static const RelationshipDecl *declare(const std::string &relationshipName, eRelationshipType type);
+
+    const std::string &getName();
     eRelationshipType getType();
 
     void sort(const std::function<bool(Object *, Object *)> &func);
@@ -57,7 +146,28 @@ public:
     Object *find(std::string id);
     Object *front();
     Object *back();
+
+    Iterator begin() const;
+    Iterator end() const;
+    size_t size() const;
+    bool empty() const;
+    void reserve(size_t count);
+    void shrink();
+    size_t getFootprint() const;
 protected:
-    std::string name;
-    eRelationshipType type;
+    size_t nextSlot(size_t pos) const;
+    size_t findSlot(Object *o);
+    void compact();
+    void buildIndex();
+    void reset();
+
+    const RelationshipDecl *decl;
+    ObjSlots slots;
+
+    /*
+     * Allocated once relationship outgrows the threshold.
+     */
+    std::unique_ptr<ObjIndex> index;
+    size_t head;
+    size_t count;
 };
@@ -24,24 +24,82 @@
 
 #include <ORM/FwDecl.h>
 #include <ORM/eRelationshipType.h>
+#include <ORM/Relationship.h>
+#include <atomic>
 #include <memory>
-#include <map>
+#include <vector>
+#include <string>
 
-using RelationshipPtr = std::shared_ptr<Relationship>;
+/*
+ * Number of relationships stored inline, without a table.
+ */
+#define RELATIONSHIPS_INLINE (2)
+
+/**
+ * Declared relationship, created on first use.
+ */
+struct RelationshipSlot {
+    RelationshipSlot();
+    RelationshipSlot(const RelationshipSlot &slot);
+
+    const RelationshipDecl *decl;
+    std::atomic<Relationship *> relationship;
+};
+
+using RelationshipTable = std::vector<RelationshipSlot>;
 
 class Relationships {
 public:
     explicit Relationships(Object *self);
+    virtual ~Relationships();
 
-    Relationship *get(std::string relationshipName);
-    void init(std::string relationshipName, eRelationshipType type);
+    Relationship *get(const std::string &relationshipName);
+    Relationship *find(const std::string &relationshipName);
+    void init(const std::string &relationshipName, eRelationshipType type);
     Object *front(std::string relationshipName);
     Object *back(std::string relationshipName);
     bool hasRelations();
+    size_t getFootprint();
 
     virtual void add(std::string relationshipName, Object *o) = 0;
     virtual void remove(std::string relationshipName, Object *o) = 0;
+
+    template<typename F>
+    void forEach(F &&func);
 protected:
+    RelationshipSlot *getSlot(const std::string &relationshipName);
+
     Object *self;
-    std::map<std::string, RelationshipPtr> relationships;
+
+    /*
+     * Relationships are only declared by init, the relationship
+     * itself is allocated when first asked for by get.
+     * Declarations are stored inline, table is allocated
+     * only for objects with more of them.
+     */
+    RelationshipSlot inlined[RELATIONSHIPS_INLINE];
+    std::unique_ptr<RelationshipTable> table;
 };
+
+/**
+ * Call function for each created relationship.
+ *
+ * @param func - function taking Relationship *.
+ */
+template<typename F>
+void
+Relationships::forEach(F &&func)
+{
+    RelationshipSlot *begin = this->table ? this->table->data() : this->inlined;
+    RelationshipSlot *end = this->table ? begin + this->table->size() : begin + RELATIONSHIPS_INLINE;
+
+    for (RelationshipSlot *slot = begin; slot != end; slot++)
+    {
+        Relationship *r = slot->relationship.load(std::memory_order_acquire);
+
+        if (r)
+        {
+            func(r);
+        }
+    }
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <ORM/ORM.h>
+#include <ORM/Object.h>
+#include <ORM/ObjectRepository.h>
+#include <ORM/TypeOf.h>
+#include <utility>
+
+namespace ORM {
+    /**
+     * Typed view of an object repository.
+     *
+     * Objects of the type are scanned in their dense array and
+     * predicates are inlined, no std::function nor dynamic_cast.
+     */
+    template<typename T>
+    class Repository {
+    public:
+        static ObjectRepository *get();
+
+        template<typename Pred>
+        static T *select(Pred &&where);
+
+        template<typename F>
+        static void forEach(F &&func);
+
+        static T *getFirst();
+        static size_t count();
+    };
+
+    template<typename T, typename Pred>
+    T *select(Pred &&where);
+
+    template<typename T, typename F>
+    void forEach(F &&func);
+}
+
+/**
+ * Get object repository of the type.
+ *
+ * @return object repository if exists, otherwise nullptr.
+ */
+template<typename T>
+ObjectRepository *
+ORM::Repository<T>::get()
+{
+    return ORM::findObjectRepository(ORM::TypeOf<T>::value);
+}
+
+/**
+ * Select first object matching the predicate.
+ *
+ * @param where - predicate taking T *.
+ * @return object if found, otherwise nullptr.
+ */
+template<typename T>
+template<typename Pred>
+T *
+ORM::Repository<T>::select(Pred &&where)
+{
+    ObjectRepository *repository = Repository<T>::get();
+
+    if (!repository)
+    {
+        return nullptr;
+    }
+
+    T *found = nullptr;
+
+    repository->scan([&](Object *o) {
+        if (o->getMarked())
+        {
+            return false;
+        }
+
+        T *t = static_cast<T *>(o);
+
+        if (where(t))
+        {
+            found = t;
+            return true;
+        }
+
+        return false;
+    });
+
+    return found;
+}
+
+/**
+ * Call function for each object that is not marked.
+ * Objects must not be swept from the function.
+ *
+ * @param func - function taking T *.
+ */
+template<typename T>
+template<typename F>
+void
+ORM::Repository<T>::forEach(F &&func)
+{
+    ObjectRepository *repository = Repository<T>::get();
+
+    if (!repository)
+    {
+        return;
+    }
+
+    repository->scan([&](Object *o) {
+        if (!o->getMarked())
+        {
+            func(static_cast<T *>(o));
+        }
+
+        return false;
+    });
+}
+
+/**
+ * Get first object that is not marked.
+ *
+ * @return object if exists, otherwise nullptr.
+ */
+template<typename T>
+T *
+ORM::Repository<T>::getFirst()
+{
+    return Repository<T>::select([](T *) {
+        return true;
+    });
+}
+
+/**
+ * Get number of objects in repository, including marked ones.
+ *
+ * @return number of objects.
+ */
+template<typename T>
+size_t
+ORM::Repository<T>::count()
+{
+    ObjectRepository *repository = Repository<T>::get();
+
+    return repository ? repository->size() : 0;
+}
+
+/**
+ * Select command.
+ *
+ * @param where - predicate taking T *.
+ * @return object if found, otherwise nullptr.
+ */
+template<typename T, typename Pred>
+T *
+ORM::select(Pred &&where)
+{
+    return ORM::Repository<T>::select(std::forward<Pred>(where));
+}
+
+/**
+ * Call function for each object of the type.
+ *
+ * @param func - function taking T *.
+ */
+template<typename T, typename F>
+void
+ORM::forEach(F &&func)
+{
+    ORM::Repository<T>::forEach(std::forward<F>(func));
+}
@@ -0,0 +1,358 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <ORM/FwDecl.h>
+#include <ORM/Object.h>
+#include <functional>
+#include <memory>
+#include <map>
+#include <unordered_map>
+
+/**
+ * Secondary index of an object repository.
+ * Repository keeps it up to date on add, changeId and sweep.
+ */
+class RepositoryIndex {
+public:
+    virtual void add(Object *o) = 0;
+    virtual void remove(Object *o) = 0;
+    void update(Object *o);
+
+    virtual ~RepositoryIndex() = default;
+};
+
+using RepositoryIndexPtr = std::unique_ptr<RepositoryIndex>;
+
+/**
+ * Hash index, for lookups by equal key.
+ */
+template<typename Key>
+class HashIndex : public RepositoryIndex {
+public:
+    explicit HashIndex(std::function<Key(Object *)> extractor);
+
+    void add(Object *o) override;
+    void remove(Object *o) override;
+
+    Object *find(const Key &key);
+
+    template<typename F>
+    void forEach(const Key &key, F &&func);
+
+    size_t size();
+protected:
+    std::function<Key(Object *)> extractor;
+    std::unordered_multimap<Key, Object *> entries;
+
+    /*
+     * Key under which object was added, key may change before update.
+     */
+    std::unordered_map<Object *, Key> keys;
+};
+
+/**
+ * Ordered index, for lookups by key range.
+ */
+template<typename Key>
+class OrderedIndex : public RepositoryIndex {
+public:
+    explicit OrderedIndex(std::function<Key(Object *)> extractor);
+
+    void add(Object *o) override;
+    void remove(Object *o) override;
+
+    Object *find(const Key &key);
+    Object *lowerBound(const Key &key);
+
+    template<typename F>
+    void range(const Key &from, const Key &to, F &&func);
+
+    size_t size();
+protected:
+    std::function<Key(Object *)> extractor;
+    std::multimap<Key, Object *> entries;
+    std::unordered_map<Object *, Key> keys;
+};
+
+/**
+ * Re-add object under its current key.
+ *
+ * @param o - the object.
+ */
+inline void
+RepositoryIndex::update(Object *o)
+{
+    this->remove(o);
+    this->add(o);
+}
+
+/**
+ * The constructor.
+ *
+ * @param extractor - function returning key of the object.
+ */
+template<typename Key>
+HashIndex<Key>::HashIndex(std::function<Key(Object *)> extractor)
+{
+    this->extractor = std::move(extractor);
+}
+
+/**
+ * @inherit
+ */
+template<typename Key>
+void
+HashIndex<Key>::add(Object *o)
+{
+    if (this->keys.find(o) != this->keys.end())
+    {
+        return;
+    }
+
+    Key key = this->extractor(o);
+
+    this->keys.emplace(o, key);
+    this->entries.emplace(key, o);
+}
+
+/**
+ * @inherit
+ */
+template<typename Key>
+void
+HashIndex<Key>::remove(Object *o)
+{
+    auto it = this->keys.find(o);
+
+    if (it == this->keys.end())
+    {
+        return;
+    }
+
+    auto range = this->entries.equal_range(it->second);
+
+    for (auto entry = range.first; entry != range.second; entry++)
+    {
+        if (entry->second == o)
+        {
+            this->entries.erase(entry);
+            break;
+        }
+    }
+
+    this->keys.erase(it);
+}
+
+/**
+ * Find object by key.
+ *
+ * @param key
+ * @return object that is not marked if found, otherwise nullptr.
+ */
+template<typename Key>
+Object *
+HashIndex<Key>::find(const Key &key)
+{
+    auto range = this->entries.equal_range(key);
+
+    for (auto entry = range.first; entry != range.second; entry++)
+    {
+        if (!entry->second->getMarked())
+        {
+            return entry->second;
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * Call function for each object with the key that is not marked.
+ *
+ * @param key
+ * @param func - function taking Object *, returns true to stop.
+ */
+template<typename Key>
+template<typename F>
+void
+HashIndex<Key>::forEach(const Key &key, F &&func)
+{
+    auto range = this->entries.equal_range(key);
+
+    for (auto entry = range.first; entry != range.second; entry++)
+    {
+        if (!entry->second->getMarked() && func(entry->second))
+        {
+            return;
+        }
+    }
+}
+
+/**
+ * Get number of indexed objects.
+ *
+ * @return number of objects.
+ */
+template<typename Key>
+size_t
+HashIndex<Key>::size()
+{
+    return this->keys.size();
+}
+
+/**
+ * The constructor.
+ *
+ * @param extractor - function returning key of the object.
+ */
+template<typename Key>
+OrderedIndex<Key>::OrderedIndex(std::function<Key(Object *)> extractor)
+{
+    this->extractor = std::move(extractor);
+}
+
+/**
+ * @inherit
+ */
+template<typename Key>
+void
+OrderedIndex<Key>::add(Object *o)
+{
+    if (this->keys.find(o) != this->keys.end())
+    {
+        return;
+    }
+
+    Key key = this->extractor(o);
+
+    this->keys.emplace(o, key);
+    this->entries.emplace(key, o);
+}
+
+/**
+ * @inherit
+ */
+template<typename Key>
+void
+OrderedIndex<Key>::remove(Object *o)
+{
+    auto it = this->keys.find(o);
+
+    if (it == this->keys.end())
+    {
+        return;
+    }
+
+    auto range = this->entries.equal_range(it->second);
+
+    for (auto entry = range.first; entry != range.second; entry++)
+    {
+        if (entry->second == o)
+        {
+            this->entries.erase(entry);
+            break;
+        }
+    }
+
+    this->keys.erase(it);
+}
+
+/**
+ * Find object by key.
+ *
+ * @param key
+ * @return object that is not marked if found, otherwise nullptr.
+ */
+template<typename Key>
+Object *
+OrderedIndex<Key>::find(const Key &key)
+{
+    auto range = this->entries.equal_range(key);
+
+    for (auto entry = range.first; entry != range.second; entry++)
+    {
+        if (!entry->second->getMarked())
+        {
+            return entry->second;
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * Find first object with key not less than given key.
+ *
+ * @param key
+ * @return object that is not marked if found, otherwise nullptr.
+ */
+template<typename Key>
+Object *
+OrderedIndex<Key>::lowerBound(const Key &key)
+{
+    for (auto entry = this->entries.lower_bound(key); entry != this->entries.end(); entry++)
+    {
+        if (!entry->second->getMarked())
+        {
+            return entry->second;
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * Call function for each object with key in [from, to) that is not marked.
+ *
+ * @param from - first key.
+ * @param to - key after last.
+ * @param func - function taking Object *, returns true to stop.
+ */
+template<typename Key>
+template<typename F>
+void
+OrderedIndex<Key>::range(const Key &from, const Key &to, F &&func)
+{
+    auto end = this->entries.lower_bound(to);
+
+    for (auto entry = this->entries.lower_bound(from); entry != end; entry++)
+    {
+        if (!entry->second->getMarked() && func(entry->second))
+        {
+            return;
+        }
+    }
+}
+
+/**
+ * Get number of indexed objects.
+ *
+ * @return number of objects.
+ */
+template<typename Key>
+size_t
+OrderedIndex<Key>::size()
+{
+    return this->keys.size();
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <ORM/FwDecl.h>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * Sweep worker pool.
+ *
+ * Sweep collects repositories in parallel, one task per repository.
+ * In concurrent mode reclaimed objects are destroyed by workers,
+ * except objects whose destructor has observable side effects.
+ * Without workers everything runs on the sweeping thread.
+ */
+namespace ORM {
+    void setSweepWorkers(size_t count);
+    size_t getSweepWorkers();
+
+    void parallelFor(size_t count, const std::function<void(size_t)> &task);
+    void offloadDestroy(std::vector<std::unique_ptr<Object>> &objects);
+    void waitDestroyed();
+    size_t getOffloadedCount();
+}
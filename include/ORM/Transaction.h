@@ -0,0 +1,155 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <ORM/FwDecl.h>
+#include <ORM/Concurrency.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Number of object version stripes used to detect conflicts.
+ */
+#define TRANSACTION_VERSION_STRIPES (4096)
+
+namespace ORM {
+    /**
+     * Undo record type.
+     */
+    enum eUndoType {
+        UNDO_ADD,
+        UNDO_REMOVE,
+        UNDO_CHANGE_ID,
+        UNDO_CREATE
+    };
+
+    /**
+     * Undo record, one relationship edit or id change.
+     */
+    struct UndoRecord {
+        eUndoType type;
+        Object *master;
+        Object *slave;
+        std::string name;
+    };
+
+    /**
+     * Transaction over ORM mutations.
+     *
+     * Relationship edits, id changes and creations done on this thread
+     * while transaction is open are recorded to undo log, rollback plays
+     * it backwards. Destroys and orphan sweeps are held until commit.
+     *
+     * Object written by transaction is claimed through its version
+     * stripe until commit or rollback, edit of object claimed by another
+     * transaction is refused and this transaction fails to commit.
+     * So no other transaction writes what undo restores. Objects read
+     * are validated against their version on commit. Commit and
+     * rollback don't take the graph lock.
+     *
+     * Transaction opened inside another one is a savepoint of it.
+     */
+    class Transaction {
+    public:
+        Transaction();
+        Transaction(const Transaction &) = delete;
+        Transaction &operator=(const Transaction &) = delete;
+
+        bool commit();
+        void rollback();
+        void read(Object *o);
+
+        bool isNested();
+        size_t getUndoCount();
+
+        ~Transaction();
+    protected:
+        /**
+         * Version of stripe seen by transaction, claimed
+         * stripe holds version with claim bit set.
+         */
+        struct Version {
+            uint32_t version;
+            bool written;
+        };
+
+        bool acquire(Object *o);
+        void touch(Object *o);
+        bool isIntact(Object *o);
+        void bumpUnclaimed(Object *o);
+        void undo(size_t savepoint, size_t destroyedSavepoint);
+        bool validate();
+        void publish();
+        void finish();
+
+        Transaction *root;
+        size_t savepoint;
+        size_t destroyedSavepoint;
+        bool finished;
+        bool rollingBack;
+        bool conflicted;
+
+        std::vector<UndoRecord> undoLog;
+        std::vector<Object *> orphans;
+        std::vector<Object *> destroyed;
+        std::unordered_map<size_t, Version> versions;
+        EpochGuard epoch;
+
+        friend bool claim(Object *master, Object *slave);
+
+        friend void logAdd(Object *master, const std::string &name, Object *slave);
+        friend void logRemove(Object *master, const std::string &name, Object *slave);
+        friend void logChangeId(Object *o, const std::string &oldId);
+        friend void logCreate(Object *o);
+        friend bool deferDestroy(Object *o);
+        friend bool deferOrphan(Object *o);
+    };
+
+    extern thread_local Transaction *transaction;
+
+    bool claim(Object *master, Object *slave);
+    void logAdd(Object *master, const std::string &name, Object *slave);
+    void logRemove(Object *master, const std::string &name, Object *slave);
+    void logChangeId(Object *o, const std::string &oldId);
+    void logCreate(Object *o);
+    bool deferDestroy(Object *o);
+    bool deferOrphan(Object *o);
+
+    bool inTransaction();
+    size_t getTransactionConflicts();
+}
+
+/**
+ * Check if transaction is open on this thread.
+ *
+ * @return true if open, otherwise false.
+ */
+inline bool
+ORM::inTransaction()
+{
+    return ORM::transaction != nullptr;
+}
@@ -38,5 +38,6 @@ typedef enum {
     OBJECT_TYPE_METHOD,
     OBJECT_TYPE_FILE,
     OBJECT_TYPE_THREAD,
-    OBJECT_TYPE_CONSTANTS
+    OBJECT_TYPE_CONSTANTS,
+    OBJECT_TYPE_COUNT
 } eObjectType;
\ No newline at end of file
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Appends values in host byte order to a byte buffer.
+ */
+class BinaryWriter {
+public:
+    explicit BinaryWriter(std::string &buffer);
+
+    void putU8(uint8_t value);
+    void putU32(uint32_t value);
+    void putU64(uint64_t value);
+    void putBytes(const void *data, size_t size);
+    void putString(const std::string &value);
+protected:
+    std::string &buffer;
+};
+
+/**
+ * Reads values written by binary writer.
+ * Once reading past the end fails, reader stays failed.
+ */
+class BinaryReader {
+public:
+    BinaryReader(const char *data, size_t size);
+
+    uint8_t getU8();
+    uint32_t getU32();
+    uint64_t getU64();
+    bool getBytes(void *data, size_t size);
+    std::string getString();
+
+    bool isOk();
+    bool isEnd();
+    size_t getPosition();
+protected:
+    const char *data;
+    size_t size;
+    size_t position;
+    bool ok;
+};
+
+uint32_t binaryChecksum(const char *data, size_t size);
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <ORM/eObjectType.h>
+#include <ORM/FwDecl.h>
+#include <PersistenceBundle/BinaryStream.h>
+
+class Persistence;
+
+/**
+ * Converts object state to binary payload and back.
+ * Relationships are persisted separately, codec keeps only
+ * state that is not a relationship.
+ */
+class Codec {
+public:
+    virtual void write(Object *o, BinaryWriter &writer, Persistence &persistence) = 0;
+    virtual Object *create(BinaryReader &reader) = 0;
+    virtual void restore(Object *o, BinaryReader &reader, Persistence &persistence) = 0;
+
+    virtual ~Codec() = default;
+};
+
+/**
+ * Codec of Bool, Char, Int, Float and String, payload is raw memory.
+ */
+class PrimitiveCodec : public Codec {
+public:
+    explicit PrimitiveCodec(eObjectType type);
+
+    void write(Object *o, BinaryWriter &writer, Persistence &persistence) override;
+    Object *create(BinaryReader &reader) override;
+    void restore(Object *o, BinaryReader &reader, Persistence &persistence) override;
+protected:
+    eObjectType type;
+};
+
+/**
+ * Codec of Collection, payload is element index -> element key.
+ */
+class CollectionCodec : public Codec {
+public:
+    void write(Object *o, BinaryWriter &writer, Persistence &persistence) override;
+    Object *create(BinaryReader &reader) override;
+    void restore(Object *o, BinaryReader &reader, Persistence &persistence) override;
+};
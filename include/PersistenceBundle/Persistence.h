@@ -0,0 +1,128 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <ORM/Journal.h>
+#include <ORM/eObjectType.h>
+#include <PersistenceBundle/Codec.h>
+#include <PersistenceBundle/ePersistenceRecord.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/*
+ * Log records buffered before commit is forced.
+ */
+#define PERSISTENCE_GROUP_COMMIT (256)
+
+#define PERSISTENCE_CHECKPOINT_FILE "checkpoint.bin"
+#define PERSISTENCE_LOG_FILE "wal.bin"
+
+/**
+ * Persists objects that have a codec into a directory.
+ *
+ * Changes are appended to write-ahead log and made durable
+ * by commit, many changes share one fsync. Checkpoint writes all
+ * objects and relationships and empties the log. Open loads last
+ * checkpoint and replays committed log records over it.
+ *
+ * Commits are numbered. Checkpoint stores number of last commit
+ * it contains and replay skips commits up to it, log that wasn't
+ * emptied before crash is not applied twice.
+ *
+ * Relationships are persisted only between persisted objects.
+ * Changes of primitive values are not seen by ORM, call update().
+ */
+class Persistence : public Journal {
+public:
+    explicit Persistence(std::string directory);
+
+    bool open();
+    bool commit();
+    bool checkpoint();
+    void close();
+
+    void track(Object *o);
+    void update(Object *o);
+    void registerCodec(eObjectType type, Codec *codec);
+
+    uint64_t getKey(Object *o);
+    Object *getObject(uint64_t key);
+    size_t getCommitCount();
+
+    void onCreate(Object *o) override;
+    void onDestroy(Object *o) override;
+    void onChangeId(Object *o, const std::string &newId) override;
+    void onAdd(Object *master, Relationship *r, Object *slave, bool nested) override;
+    void onRemove(Object *master, Relationship *r, Object *slave, bool nested) override;
+    void onClear(Object *master, Relationship *r, bool nested) override;
+    void onRelease(Object *o) override;
+
+    ~Persistence() override;
+protected:
+    Codec *getCodec(Object *o);
+    void bind(Object *o, uint64_t key);
+    void append(std::string &record);
+    void record(std::string &record);
+    void markDirty(Object *o);
+    void writeObject(Object *o, BinaryWriter &writer);
+    void logEdges(Object *o);
+    bool loadCheckpoint();
+    bool replayLog();
+    void applyRecord(BinaryReader &reader);
+    std::string getPath(const char *file);
+
+    std::string directory;
+    int fd;
+
+    /*
+     * Log size up to last durable commit.
+     */
+    size_t logSize;
+    std::string pending;
+    size_t pendingRecords;
+    size_t commits;
+    bool replaying;
+
+    /*
+     * Number of last commit, and of last commit in checkpoint.
+     */
+    uint64_t lsn;
+    uint64_t checkpointLsn;
+
+    uint64_t nextKey;
+    std::unordered_map<Object *, uint64_t> keys;
+    std::unordered_map<uint64_t, Object *> objects;
+
+    /*
+     * Objects whose payload is written on commit, by key.
+     */
+    std::map<uint64_t, Object *> dirty;
+
+    std::map<eObjectType, std::unique_ptr<Codec>> codecs;
+    std::recursive_mutex mutex;
+};
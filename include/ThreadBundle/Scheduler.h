@@ -0,0 +1,124 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <ForwardDeclarations.h>
+#include <ThreadBundle/Thread.h>
+#include <ThreadBundle/TimerWheel.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Number of takes a waiting priority is passed over before it goes first.
+ */
+#define SCHEDULER_AGING (8)
+
+/**
+ * Scheduler of interpreter threads.
+ *
+ * Threads are tasks run in quanta on fixed pool of workers, quantum
+ * is bounded by instruction budget and time slice of thread. Each
+ * worker has its own deque for each priority, it takes from the back
+ * of highest non-empty one and idle workers steal from the front of
+ * others. Lower priority passed over SCHEDULER_AGING times goes first
+ * once, so it does not starve. Preempted thread is requeued at the
+ * front so other threads of the worker run first. Worker without
+ * work sleeps until thread is spawned. Sleeping thread is parked in
+ * timer wheel, timer thread queues it again when it wakes.
+ *
+ * Threads running on more than one worker need ORM in concurrent mode.
+ */
+class Scheduler {
+public:
+    explicit Scheduler(size_t workers = 0);
+    ~Scheduler();
+
+    void spawn(Thread *thread);
+    void wait();
+    std::vector<Thread *> takeFinished();
+
+    size_t getWorkerCount();
+    size_t getSleepingCount();
+    size_t getStealCount();
+    size_t getFailedCount();
+    size_t getParkedCount();
+protected:
+    /**
+     * Worker with its deques of threads, indexed by priority.
+     * Skipped counts takes of higher priority while deque waited.
+     */
+    struct Worker {
+        std::deque<Thread *> deques[THREAD_PRIORITY_COUNT];
+        size_t skipped[THREAD_PRIORITY_COUNT] = {};
+        std::mutex mutex;
+        std::thread thread;
+    };
+
+    void workerLoop(size_t index);
+    void push(size_t index, Thread *thread, bool front);
+    Thread *take(size_t index);
+    void complete(Thread *thread, bool failed);
+    void park(Thread *thread);
+    void timerLoop();
+    uint64_t toTick(std::chrono::steady_clock::time_point time, bool roundUp);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    /*
+     * mutex - guards everything below except atomics, requeue does
+     *         not take it unless a worker sleeps.
+     * wake - idle workers wait for threads.
+     * idle - callers wait for all threads to finish.
+     */
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+
+    std::atomic<size_t> queued;
+    std::atomic<size_t> steals;
+    std::atomic<size_t> sleeping;
+    size_t pending;
+    size_t failed;
+    std::atomic<size_t> nextWorker;
+    bool stopping;
+    std::vector<Thread *> finished;
+
+    /*
+     * Sleeping threads, ticks are milliseconds since epoch.
+     * timerMutex guards wheel and timerStopping.
+     */
+    TimerWheel wheel;
+    std::mutex timerMutex;
+    std::condition_variable timerWake;
+    std::thread timer;
+    bool timerStopping;
+    std::chrono::steady_clock::time_point epoch;
+};
@@ -23,21 +23,72 @@
 #pragma once
 
 #include <ForwardDeclarations.h>
+#include <ErrorBundle/eErrorStatus.h>
 #include <ORM/Object.h>
+#include <VariableBundle/TaggedValue.h>
+#include <chrono>
 #include <stack>
+#include <vector>
+
+/*
+ * Default number of instructions thread executes before it yields.
+ */
+#define THREAD_BUDGET (1024)
+
+/*
+ * Default microseconds thread runs before it yields, 0 for no limit.
+ */
+#define THREAD_TIME_SLICE (1000)
+
+/*
+ * Number of instructions executed between reads of clock.
+ */
+#define THREAD_CLOCK_INTERVAL (128)
+
+/**
+ * Priority of thread, scheduler runs ready thread of higher priority first.
+ */
+enum eThreadPriority {
+    THREAD_PRIORITY_LOW,
+    THREAD_PRIORITY_NORMAL,
+    THREAD_PRIORITY_HIGH
+};
+
+#define THREAD_PRIORITY_COUNT (THREAD_PRIORITY_HIGH + 1)
+
+/**
+ * State of thread.
+ */
+enum eThreadState {
+    THREAD_STATE_READY,
+    THREAD_STATE_SLEEPING,
+    THREAD_STATE_FINISHED,
+    THREAD_STATE_ERROR
+};
 
 class Thread : public Object {
 public:
     Thread(uint64_t id, Method *m);
     bool step();
     void run();
+    eThreadState execute();
+    eThreadState getState();
+    eErrorStatus getError();
+    void setBudget(size_t instructions, uint64_t microseconds);
+    size_t getBudget();
+    uint64_t getTimeSlice();
+    void setPriority(eThreadPriority priority);
+    eThreadPriority getPriority();
     void sleep(uint64_t milliseconds);
+    void wake();
+    std::chrono::steady_clock::time_point getWakeTime();
 
     void pushMethod(Method *m);
     void popMethod();
 
     void pushStack(Value *v);
-    Value *popStack();
+    void pushTagged(TaggedValue v);
+    TaggedValue popTagged();
 
     Interpreter *getInterpreter();
 
@@ -45,7 +96,20 @@ public:
 
     static Thread *create(uint64_t id, Method *m);
 private:
-    bool pause;
+    void fail();
+
+    eThreadState state;
+    eErrorStatus error;
+    eThreadPriority priority;
+    size_t budget;
+    uint64_t timeSlice;
+    std::chrono::steady_clock::time_point wakeTime;
     std::stack<Method *> methodStack;
-    std::stack<Value *> valueStack;
-};
\ No newline at end of file
+
+    /*
+     * Scalars are held unboxed.
+     */
+    std::vector<TaggedValue> valueStack;
+};
+
+ORM_TYPE_OF(Thread, OBJECT_TYPE_THREAD)
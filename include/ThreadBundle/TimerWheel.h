@@ -0,0 +1,82 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <ForwardDeclarations.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define TIMER_WHEEL_BITS (8)
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_LEVELS (4)
+
+/*
+ * Timer further than this is placed here and placed again when it is reached.
+ */
+#define TIMER_WHEEL_RANGE ((1ULL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1)
+
+/*
+ * No timer.
+ */
+#define TIMER_WHEEL_NEVER (UINT64_MAX)
+
+/**
+ * Hierarchical timer wheel of sleeping threads.
+ *
+ * Time is counted in ticks. Level 0 has slot for each of next 256 ticks,
+ * each next level has slot for 256 slots of level below. When level 0
+ * wraps, slot of level above is moved down. Adding and expiring
+ * a timer is constant time.
+ */
+class TimerWheel {
+public:
+    explicit TimerWheel(uint64_t now = 0);
+
+    void add(Thread *thread, uint64_t deadline);
+    void advance(uint64_t now, std::vector<Thread *> &expired);
+    uint64_t nextExpiry();
+    uint64_t getCurrent();
+    size_t size();
+protected:
+    /**
+     * Thread with tick it wakes at.
+     */
+    struct Timer {
+        Thread *thread;
+        uint64_t deadline;
+    };
+
+    void place(const Timer &timer);
+    void cascade(size_t level);
+
+    std::vector<Timer> slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+
+    /*
+     * Last processed tick.
+     */
+    uint64_t current;
+    size_t count;
+};
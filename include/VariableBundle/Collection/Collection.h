@@ -92,4 +92,8 @@ protected:
     void removeData(Value *o);
     void insertData(std::string index, Value *o);
     std::map<std::string, Value *> data_cache;
-};
\ No newline at end of file
+
+    friend class CollectionCodec;
+};
+
+ORM_TYPE_OF(Collection, OBJECT_TYPE_COLLECTION)
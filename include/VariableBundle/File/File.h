@@ -77,6 +77,7 @@ public:
     bool scan() override;
 
     std::wstring getString() override;
+    bool hasObservableDestructor() override;
     ~File();
 protected:
     void readIntoBuffer();
@@ -86,4 +87,6 @@ protected:
     std::string fileName;
     std::wstring buffer;
     eFileMode mode;
-};
\ No newline at end of file
+};
+
+ORM_TYPE_OF(File, OBJECT_TYPE_FILE)
@@ -0,0 +1 @@
+/root/repo/test/include/VariableBundle/File/file_test.h
\ No newline at end of file
@@ -63,4 +63,6 @@ public:
 
     std::wstring getString() override;
     static Null *create();
-};
\ No newline at end of file
+};
+
+ORM_TYPE_OF(Null, OBJECT_TYPE_NULL)
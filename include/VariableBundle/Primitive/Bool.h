@@ -73,4 +73,6 @@ public:
     std::wstring getString() override;
 
     static bool parse(std::wstring str);
-};
\ No newline at end of file
+};
+
+ORM_TYPE_OF(Bool, OBJECT_TYPE_BOOL)
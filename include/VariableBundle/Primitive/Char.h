@@ -67,4 +67,6 @@ public:
     bool scan() override;
 
     std::wstring getString() override;
-};
\ No newline at end of file
+};
+
+ORM_TYPE_OF(Char, OBJECT_TYPE_CHAR)
@@ -70,4 +70,6 @@ public:
 
     std::wstring getString() override;
     static double parse(std::wstring str);
-};
\ No newline at end of file
+};
+
+ORM_TYPE_OF(Float, OBJECT_TYPE_FLOAT)
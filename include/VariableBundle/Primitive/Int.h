@@ -70,4 +70,6 @@ public:
 
     std::wstring getString() override;
     static int parse(std::wstring str);
-};
\ No newline at end of file
+};
+
+ORM_TYPE_OF(Int, OBJECT_TYPE_INT)
@@ -68,4 +68,6 @@ public:
     bool scan() override;
 
     std::wstring getString() override;
-};
\ No newline at end of file
+};
+
+ORM_TYPE_OF(String, OBJECT_TYPE_STRING)
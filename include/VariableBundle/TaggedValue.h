@@ -0,0 +1,217 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <ORM/eObjectType.h>
+#include "ForwardDeclarations.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+/*
+ * Tags live in negative quiet NaN space, doubles are stored as
+ * they are with NaN canonicalized outside of it.
+ */
+#define TAGGED_VALUE_TAG_MASK (0xFFFF000000000000ULL)
+#define TAGGED_VALUE_PAYLOAD_MASK (0x0000FFFFFFFFFFFFULL)
+#define TAGGED_VALUE_TAG_EMPTY (0xFFF8000000000000ULL)
+#define TAGGED_VALUE_TAG_INT (0xFFF9000000000000ULL)
+#define TAGGED_VALUE_TAG_BOOL (0xFFFA000000000000ULL)
+#define TAGGED_VALUE_TAG_CHAR (0xFFFB000000000000ULL)
+#define TAGGED_VALUE_TAG_OBJECT (0xFFFC000000000000ULL)
+#define TAGGED_VALUE_CANONICAL_NAN (0x7FF8000000000000ULL)
+
+static_assert(sizeof(uintptr_t) <= sizeof(uint64_t), "Pointer must fit into tagged value.");
+
+/**
+ * Unboxed value, NaN boxed into 64 bits.
+ *
+ * Holds int, float, bool and char without heap object,
+ * any other value is held by pointer to its object.
+ */
+class TaggedValue {
+public:
+    TaggedValue();
+
+    static TaggedValue fromInt(int32_t value);
+    static TaggedValue fromFloat(double value);
+    static TaggedValue fromBool(bool value);
+    static TaggedValue fromChar(wchar_t value);
+    static TaggedValue fromObject(Value *value);
+    static TaggedValue unbox(Value *value);
+
+    bool isEmpty() const;
+    bool isInt() const;
+    bool isFloat() const;
+    bool isBool() const;
+    bool isChar() const;
+    bool isObject() const;
+    bool isScalar() const;
+
+    int32_t asInt() const;
+    double asFloat() const;
+    bool asBool() const;
+    wchar_t asChar() const;
+    Value *asObject() const;
+
+    eObjectType getType() const;
+    Value *box() const;
+protected:
+    explicit TaggedValue(uint64_t bits);
+
+    uint64_t bits;
+};
+
+inline
+TaggedValue::TaggedValue() : bits(TAGGED_VALUE_TAG_EMPTY)
+{
+}
+
+inline
+TaggedValue::TaggedValue(uint64_t bits) : bits(bits)
+{
+}
+
+inline TaggedValue
+TaggedValue::fromInt(int32_t value)
+{
+    return TaggedValue(TAGGED_VALUE_TAG_INT | (uint32_t) value);
+}
+
+inline TaggedValue
+TaggedValue::fromFloat(double value)
+{
+    uint64_t bits = TAGGED_VALUE_CANONICAL_NAN;
+
+    if (!std::isnan(value))
+    {
+        memcpy(&bits, &value, sizeof(bits));
+    }
+
+    return TaggedValue(bits);
+}
+
+inline TaggedValue
+TaggedValue::fromBool(bool value)
+{
+    return TaggedValue(TAGGED_VALUE_TAG_BOOL | (uint64_t) value);
+}
+
+inline TaggedValue
+TaggedValue::fromChar(wchar_t value)
+{
+    return TaggedValue(TAGGED_VALUE_TAG_CHAR | (uint32_t) value);
+}
+
+inline TaggedValue
+TaggedValue::fromObject(Value *value)
+{
+    /*
+     * Payload holds 48 bit address. Wider or top byte tagged pointer
+     * would be truncated into another address, stop instead.
+     */
+    if (((uintptr_t) value & ~TAGGED_VALUE_PAYLOAD_MASK) != 0)
+    {
+        std::abort();
+    }
+
+    return TaggedValue(TAGGED_VALUE_TAG_OBJECT | (uintptr_t) value);
+}
+
+inline bool
+TaggedValue::isEmpty() const
+{
+    return this->bits == TAGGED_VALUE_TAG_EMPTY;
+}
+
+inline bool
+TaggedValue::isInt() const
+{
+    return (this->bits & TAGGED_VALUE_TAG_MASK) == TAGGED_VALUE_TAG_INT;
+}
+
+inline bool
+TaggedValue::isFloat() const
+{
+    return this->bits < TAGGED_VALUE_TAG_EMPTY;
+}
+
+inline bool
+TaggedValue::isBool() const
+{
+    return (this->bits & TAGGED_VALUE_TAG_MASK) == TAGGED_VALUE_TAG_BOOL;
+}
+
+inline bool
+TaggedValue::isChar() const
+{
+    return (this->bits & TAGGED_VALUE_TAG_MASK) == TAGGED_VALUE_TAG_CHAR;
+}
+
+inline bool
+TaggedValue::isObject() const
+{
+    return (this->bits & TAGGED_VALUE_TAG_MASK) == TAGGED_VALUE_TAG_OBJECT;
+}
+
+inline bool
+TaggedValue::isScalar() const
+{
+    return !this->isEmpty() && !this->isObject();
+}
+
+inline int32_t
+TaggedValue::asInt() const
+{
+    return (int32_t) (uint32_t) this->bits;
+}
+
+inline double
+TaggedValue::asFloat() const
+{
+    double value;
+
+    memcpy(&value, &this->bits, sizeof(value));
+
+    return value;
+}
+
+inline bool
+TaggedValue::asBool() const
+{
+    return (this->bits & 1) != 0;
+}
+
+inline wchar_t
+TaggedValue::asChar() const
+{
+    return (wchar_t) (uint32_t) this->bits;
+}
+
+inline Value *
+TaggedValue::asObject() const
+{
+    return (Value *) (uintptr_t) (this->bits & TAGGED_VALUE_PAYLOAD_MASK);
+}
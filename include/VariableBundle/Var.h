@@ -37,4 +37,6 @@ public:
 
     Value *get();
     void set(Value *v = nullptr);
-};
\ No newline at end of file
+};
+
+ORM_TYPE_OF(Var, OBJECT_TYPE_VARIABLE)
@@ -61,7 +61,7 @@ Constants::get(uint32_t i)
     }
 
     ERROR_LOG_ADD(ERROR_CONSTANT_UNDEFINED);
-    return (Value *)ORM::getFirst(OBJECT_TYPE_NULL);
+    return (Value *)ORM::getSingleton(OBJECT_TYPE_NULL);
 }
 
 /**
@@ -71,7 +71,7 @@ Constants::get(uint32_t i)
 Constants *
 Constants::create()
 {
-    return (Constants *)ORM::create(new Constants());
+    return ORM::create(new Constants());
 }
 
 eObjectType
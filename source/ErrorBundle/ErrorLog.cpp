@@ -27,7 +27,12 @@
 #define MAX_BOX_ERROR_QUEUE (32)
 
 using error_info_p = std::shared_ptr<ErrorInfo>;
-static std::queue<error_info_p> error_queue;
+
+/*
+ * Each OS thread has its own log, so interpreter threads
+ * running on different workers do not see errors of each other.
+ */
+static thread_local std::queue<error_info_p> error_queue;
 
 /**
  * Add error.
@@ -24,60 +24,74 @@
 #include <ErrorBundle/ErrorLog.h>
 #include <InterpreterBundle/Interpreter.h>
 #include <ConstantBundle/Constants.h>
+#include <MethodBundle/Method.h>
 
-Interpreter::Interpreter(uint64_t id) : Object(id)
+/**
+ * The constructor.
+ *
+ * @param id - interpreter id.
+ * @param workers - number of scheduler workers, 0 for one per core.
+ */
+Interpreter::Interpreter(uint64_t id, size_t workers) : Object(id)
 {
     MasterRelationships *master = this->getMaster();
 
     master->init("InterpreterThreads", ONE_TO_MANY);
     master->init("InterpreterConstants", ONE_TO_ONE);
     master->add("InterpreterConstants", Constants::create());
+
+    this->scheduler.reset(new Scheduler(workers));
+    this->nextId = 0;
 }
 
-void
+/**
+ * Add thread executing method, it is scheduled right away.
+ * Method that does not compile gets no thread, its error
+ * is followed by ERROR_THREAD_INSTRUCTION_ERROR.
+ *
+ * @param m - the method.
+ * @return true if thread is added, otherwise false.
+ */
+bool
 Interpreter::addThread(Method *m)
 {
+    /*
+     * Threads execute compiled bytecode.
+     */
+    if (!m->compile())
+    {
+        ERROR_LOG_ADD(ERROR_THREAD_INSTRUCTION_ERROR);
+        return false;
+    }
+
     auto id = this->nextId++;
     Thread *thread = Thread::create(id, m);
     this->getMaster()->add("InterpreterThreads", thread);
 
-    this->threads[id] = std::thread([&]() {
-        thread->run();
-
-        if (ERROR_LOG_IS_EMPTY)
-        {
-            this->removeThread(id);
-        }
-        else
-        {
-            this->stop();
-        }
+    this->scheduler->spawn(thread);
 
-        ORM::destroy(thread);
-    });
-
-    this->threads[id].join();
+    return true;
 }
 
+/**
+ * Wait until all threads are finished, finished threads are destroyed.
+ * Sleeps while waiting. Error of failed thread is logged after
+ * ERROR_THREAD_INSTRUCTION_ERROR, so it is the last error.
+ */
 void
 Interpreter::run()
 {
-    while (!this->threads.empty())
-    {}
-}
+    this->scheduler->wait();
 
-void
-Interpreter::removeThread(uint32_t id)
-{
-    this->threads.erase(id);
-}
+    for (Thread *thread : this->scheduler->takeFinished())
+    {
+        if (thread->getState() == THREAD_STATE_ERROR)
+        {
+            ERROR_LOG_ADD(ERROR_THREAD_INSTRUCTION_ERROR);
+            ERROR_LOG_ADD(thread->getError());
+        }
 
-void
-Interpreter::stop()
-{
-    for (auto &t : this->threads) {
-        //TOOO: do something here
-        t.second.detach();
+        ORM::destroy(thread);
     }
 }
 
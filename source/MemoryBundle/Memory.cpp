@@ -21,6 +21,7 @@
  */
 
 #include <ORM/ORM.h>
+#include <ORM/ObjectRepository.h>
 #include <ORM/Relationship.h>
 #include <ORM/SlaveRelationships.h>
 #include <MemoryBundle/Memory.h>
@@ -145,13 +146,38 @@ Memory::assign(uintptr_t address, uint32_t size)
 {
     std::string newId = std::to_string(address);
 
+    this->address = address;
+    this->size = size;
+
+    /*
+     * Repository indexes read the new address on change ID.
+     */
     if (newId != this->id)
     {
         ORM::changeId(this, newId);
     }
+}
 
-    this->address = address;
-    this->size = size;
+/**
+ * Memory is moved by chunk defragmentation, it is never frozen.
+ *
+ * @return false.
+ */
+bool
+Memory::isFreezable()
+{
+    return false;
+}
+
+/**
+ * Memory holds its bytes in chunk.
+ *
+ * @return number of bytes.
+ */
+size_t
+Memory::getFootprint()
+{
+    return sizeof(Memory) - sizeof(Object) + Object::getFootprint() + this->size;
 }
 
 /**
@@ -176,7 +202,7 @@ Memory::isReadyToRemove()
 Memory *
 Memory::create(uintptr_t address, uint32_t size)
 {
-    return (Memory *) ORM::create(new Memory(address, size));
+    return ORM::create(new Memory(address, size));
 }
 
 /**
@@ -216,3 +242,30 @@ template int32_t *Memory::getPointer();
 template int64_t *Memory::getPointer();
 
 template double *Memory::getPointer();
+
+/**
+ * Get memory address index. Index is built on first use.
+ *
+ * @return index if memory repository exists, otherwise nullptr.
+ */
+HashIndex<uintptr_t> *
+Memory::getAddressIndex()
+{
+    ObjectRepository *repository = ORM::findObjectRepository(OBJECT_TYPE_MEMORY);
+
+    if (!repository)
+    {
+        return nullptr;
+    }
+
+    RepositoryIndex *index = repository->getIndex("address");
+
+    if (!index)
+    {
+        index = repository->addIndex("address", new HashIndex<uintptr_t>([](Object *o) {
+            return ((Memory *) o)->getAddress();
+        }));
+    }
+
+    return static_cast<HashIndex<uintptr_t> *>(index);
+}
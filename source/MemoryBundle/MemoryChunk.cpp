@@ -177,9 +177,7 @@ MemoryChunk::resize(Memory *mem, uint32_t newSize)
     else if (newSize < mem->getSize())
     {
         /* Find free Memory after requested Memory */
-        Memory *freeMemory = this->freeMemoryFind([&](Memory *m) {
-            return m->getAddress() == (mem->getAddress() + mem->getSize());
-        });
+        Memory *freeMemory = this->freeMemoryAt(mem->getAddress() + mem->getSize());
 
         if (freeMemory)
         {
@@ -210,9 +208,7 @@ MemoryChunk::resize(Memory *mem, uint32_t newSize)
             return MEMORY_CHUNK_RESIZE_NO_MEMORY;
         }
 
-        auto freeMemory = this->freeMemoryFind([&](Memory *m) {
-            return m->getAddress() == (mem->getAddress() + mem->getSize());
-        });
+        auto freeMemory = this->freeMemoryAt(mem->getAddress() + mem->getSize());
 
         if (!freeMemory)
         {
@@ -435,5 +431,5 @@ MemoryChunk::getFree()
 MemoryChunk *
 MemoryChunk::create(uint32_t capacity)
 {
-    return (MemoryChunk *) ORM::create(new MemoryChunk(capacity));
+    return ORM::create(new MemoryChunk(capacity));
 }
@@ -22,6 +22,7 @@
 
 #include <ORM/Relationship.h>
 #include <ORM/MasterRelationships.h>
+#include <ORM/SlaveRelationships.h>
 #include <MemoryBundle/Memory.h>
 #include <MemoryBundle/MemoryChunkIf.h>
 
@@ -77,6 +78,41 @@ MemoryChunkIf::freeMemoryFind(std::function<bool(Memory *)> foo)
     });
 }
 
+/**
+ * Find free memory starting at address.
+ *
+ * @param address
+ * @return free memory if found, otherwise nullptr.
+ */
+Memory *
+MemoryChunkIf::freeMemoryAt(uintptr_t address)
+{
+    HashIndex<uintptr_t> *index = Memory::getAddressIndex();
+
+    if (!index)
+    {
+        return this->freeMemoryFind([&](Memory *m) {
+            return m->getAddress() == address;
+        });
+    }
+
+    Memory *found = nullptr;
+
+    index->forEach(address, [&](Object *o) {
+        Relationship *r = o->getSlave()->get("freeMemory");
+
+        if (r && (r->front() == this))
+        {
+            found = (Memory *) o;
+            return true;
+        }
+
+        return false;
+    });
+
+    return found;
+}
+
 /**
  * Get first free memory.
  *
@@ -109,11 +145,7 @@ MemoryChunkIf::freeMemoryCount()
 void
 MemoryChunkIf::freeMemoryDeleteAll()
 {
-    while (this->freeMemoryCount())
-    {
-        Memory *m = this->freeMemoryFront();
-        this->freeMemoryRemove(m);
-    }
+    this->getMaster()->clearObjects("freeMemory");
 }
 
 /**
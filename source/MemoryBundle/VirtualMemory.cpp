@@ -230,6 +230,8 @@ VirtualMemory::solveDefragmentationAndAlloc(uint32_t size)
 Memory *
 VirtualMemory::alloc(uint32_t size)
 {
+    ORM::Lock lock;
+
     if ((size == 0) || (size == UINT32_MAX))
     {
         return nullptr;
@@ -256,6 +258,8 @@ VirtualMemory::alloc(uint32_t size)
 Memory *
 VirtualMemory::realloc(Memory *mem, uint32_t newSize)
 {
+    ORM::Lock lock;
+
     if (!mem)
     {
         /*
@@ -357,6 +361,8 @@ VirtualMemory::realloc(Memory *mem, uint32_t newSize)
 void
 VirtualMemory::free(Memory *mem)
 {
+    ORM::Lock lock;
+
     if (!mem)
     {
         return;
@@ -404,7 +410,10 @@ VirtualMemory::getAllocatedTotal()
 VirtualMemory *
 VirtualMemory::create(uint32_t initCapacity)
 {
-    return (VirtualMemory *) ORM::create(new VirtualMemory(initCapacity));
+    auto *vm = ORM::create(new VirtualMemory(initCapacity));
+    ORM::registerSingleton(vm);
+
+    return vm;
 }
 
 /**
@@ -0,0 +1,1288 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <MethodBundle/Bytecode.h>
+#include <MethodBundle/Method.h>
+#include <MethodBundle/Instruction/CreateInstruction.h>
+#include <ThreadBundle/Thread.h>
+#include <InterpreterBundle/Interpreter.h>
+#include <ConstantBundle/Constants.h>
+#include <MethodBundle/Instruction/ArithmeticInstruction.h>
+#include <VariableBundle/Var.h>
+#include <VariableBundle/Primitive/Primitive.h>
+#include <VariableBundle/Primitive/String.h>
+#include <MemoryBundle/Memory.h>
+#include <ORM/ORM.h>
+#include <ErrorBundle/ErrorLog.h>
+#include <algorithm>
+#include <codecvt>
+#include <locale>
+
+/**
+ * The constructor.
+ */
+Bytecode::Bytecode()
+{
+    this->constants = nullptr;
+    this->quickenCount = 0;
+    this->deoptCount = 0;
+    this->executedCount = 0;
+    this->mode = EXECUTION_MODE_STACK;
+    this->profile = nullptr;
+}
+
+/**
+ * Append instruction.
+ *
+ * @param op - op code.
+ * @param a - first operand.
+ * @param b - second operand.
+ * @param c - third operand.
+ */
+void
+Bytecode::emit(eOpCode op, uint32_t a, uint32_t b, uint32_t c)
+{
+    this->code.push_back(BytecodeOp{op, a, b, c});
+}
+
+/**
+ * Resolve variable name to frame slot, new slot is added if not found.
+ *
+ * @param name - variable name.
+ * @return frame slot.
+ */
+uint32_t
+Bytecode::addSlot(const std::wstring &name)
+{
+    using convert_type = std::codecvt_utf8<wchar_t>;
+    std::wstring_convert<convert_type, wchar_t> converter;
+    std::string utf8 = converter.to_bytes(name);
+    uint32_t slot = this->findSlot(utf8);
+
+    if (slot != NO_FRAME_SLOT)
+    {
+        return slot;
+    }
+
+    this->slotNames.push_back(utf8);
+
+    return (uint32_t) (this->slotNames.size() - 1);
+}
+
+/**
+ * Find frame slot of variable.
+ *
+ * @param name - variable name.
+ * @return frame slot if found, otherwise NO_FRAME_SLOT.
+ */
+uint32_t
+Bytecode::findSlot(const std::string &name)
+{
+    for (uint32_t i = 0; i < this->slotNames.size(); i++)
+    {
+        if (this->slotNames[i] == name)
+        {
+            return i;
+        }
+    }
+
+    return NO_FRAME_SLOT;
+}
+
+/**
+ * Get variable name of frame slot.
+ *
+ * @param slot - frame slot.
+ * @return variable name.
+ */
+const std::string &
+Bytecode::getName(uint32_t slot)
+{
+    return this->slotNames[slot];
+}
+
+/**
+ * Get number of frame slots.
+ *
+ * @return number of frame slots.
+ */
+size_t
+Bytecode::getSlotCount()
+{
+    return this->slotNames.size();
+}
+
+/**
+ * Get instruction.
+ *
+ * @param pc - instruction index.
+ * @return instruction.
+ */
+BytecodeOp &
+Bytecode::at(size_t pc)
+{
+    return this->code[pc];
+}
+
+/**
+ * Get number of instructions in current execution mode.
+ *
+ * @return number of instructions.
+ */
+size_t
+Bytecode::size()
+{
+    if (this->mode == EXECUTION_MODE_REGISTER)
+    {
+        return this->registerCode.size();
+    }
+
+    return this->code.size();
+}
+
+/**
+ * Resolve constant pool of thread and check constant numbers against it.
+ *
+ * @param thread - thread executing the method.
+ * @return true if linked, otherwise false.
+ */
+bool
+Bytecode::link(Thread *thread)
+{
+    if (!thread->getInterpreter())
+    {
+        ERROR_LOG_ADD(ERROR_METHOD_NOT_PART_OF_THREAD);
+        return false;
+    }
+
+    return this->link(thread->getInterpreter()->getConstants());
+}
+
+/**
+ * Resolve constant pool and check constant numbers against it.
+ *
+ * @param pool - constant pool.
+ * @return true if linked, otherwise false.
+ */
+bool
+Bytecode::link(Constants *pool)
+{
+    for (auto &op : this->code)
+    {
+        if ((op.op == OP_CODE_PUSH_CONSTANT) && (op.a >= pool->size()))
+        {
+            ERROR_LOG_ADD(ERROR_CONSTANT_UNDEFINED);
+            return false;
+        }
+    }
+
+    /*
+     * Scalar constants are pushed unboxed.
+     */
+    this->constantValues.clear();
+    this->constantValues.reserve(pool->size());
+
+    for (size_t i = 0; i < pool->size(); i++)
+    {
+        this->constantValues.push_back(TaggedValue::unbox(pool->at(i)));
+    }
+
+    this->constants = pool;
+
+    return true;
+}
+
+/**
+ * Get variable of frame slot, variable not created by
+ * this method is resolved by name once.
+ *
+ * @param m - method being executed.
+ * @param frame - frame of method.
+ * @param slot - frame slot.
+ * Unboxed scalar in slot is boxed into variable.
+ *
+ * @return variable if exists, otherwise nullptr.
+ */
+Var *
+Bytecode::resolve(Method *m, FrameSlot *frame, uint32_t slot)
+{
+    Var *var = frame[slot].var;
+
+    if (!var)
+    {
+        var = m->getVar(this->slotNames[slot]);
+        frame[slot].var = var;
+    }
+
+    if (!var)
+    {
+        ERROR_LOG_ADD(ERROR_INSTRUCTION_OBJECT_DOES_NOT_EXIST);
+    }
+
+    return var;
+}
+
+/**
+ * Get type specialized form of generic operation.
+ *
+ * @param op - generic op code.
+ * @param target - type of target value.
+ * @param operand - type of operand.
+ * @return specialized op code, or op if there is none.
+ */
+static eOpCode
+specialize(eOpCode op, eObjectType target, eObjectType operand)
+{
+    if ((target == OBJECT_TYPE_INT) && (operand == OBJECT_TYPE_INT))
+    {
+        return (eOpCode) (OP_CODE_INT_ADD + (op - OP_CODE_ADD));
+    }
+
+    if ((target == OBJECT_TYPE_FLOAT) && (operand == OBJECT_TYPE_FLOAT))
+    {
+        return (eOpCode) (OP_CODE_FLOAT_ADD + (op - OP_CODE_ADD));
+    }
+
+    if ((target == OBJECT_TYPE_STRING) && (operand == OBJECT_TYPE_STRING) && (op == OP_CODE_ADD))
+    {
+        return OP_CODE_STRING_CONCAT;
+    }
+
+    return op;
+}
+
+/**
+ * Get generic form of specialized operation.
+ *
+ * @param op - specialized op code.
+ * @return generic op code.
+ */
+static eOpCode
+generalize(eOpCode op)
+{
+    switch (op)
+    {
+        case OP_CODE_INT_ADD:
+        case OP_CODE_INT_SUB:
+        case OP_CODE_INT_MUL:
+            return (eOpCode) (OP_CODE_ADD + (op - OP_CODE_INT_ADD));
+        case OP_CODE_FLOAT_ADD:
+        case OP_CODE_FLOAT_SUB:
+        case OP_CODE_FLOAT_MUL:
+            return (eOpCode) (OP_CODE_ADD + (op - OP_CODE_FLOAT_ADD));
+        case OP_CODE_STRING_CONCAT:
+            return OP_CODE_ADD;
+        default:
+            return op;
+    }
+}
+
+/**
+ * Apply numeric operation.
+ *
+ * @param op - generic op code.
+ * @param a - target value.
+ * @param b - operand.
+ */
+template<typename T>
+static void
+applyNumeric(eOpCode op, T &a, T b)
+{
+    switch (op)
+    {
+        case OP_CODE_ADD:
+            a += b;
+            break;
+        case OP_CODE_SUB:
+            a -= b;
+            break;
+        default:
+            a *= b;
+            break;
+    }
+}
+
+/**
+ * Apply int operation. Signed overflow is undefined, result
+ * is computed unsigned and wraps around like boxed Int.
+ *
+ * @param op - generic op code.
+ * @param a - target value.
+ * @param b - operand.
+ */
+template<>
+void
+applyNumeric<int32_t>(eOpCode op, int32_t &a, int32_t b)
+{
+    uint32_t result = (uint32_t) a;
+
+    applyNumeric<uint32_t>(op, result, (uint32_t) b);
+    a = (int32_t) result;
+}
+
+/**
+ * Apply operation on unboxed scalars, int and float without boxing.
+ *
+ * @param op - generic op code.
+ * @param target - target value, replaced by result.
+ * @param operand - operand.
+ * @return true if applied, otherwise false.
+ */
+static bool
+applyUnboxed(eOpCode op, TaggedValue &target, TaggedValue operand)
+{
+    if (target.isInt() && (operand.isInt() || operand.isFloat()))
+    {
+        int32_t a = target.asInt();
+
+        applyNumeric<int32_t>(op, a, operand.isInt() ? operand.asInt() : (int32_t) operand.asFloat());
+        target = TaggedValue::fromInt(a);
+
+        return true;
+    }
+
+    if (target.isFloat() && (operand.isInt() || operand.isFloat()))
+    {
+        double a = target.asFloat();
+
+        applyNumeric<double>(op, a, operand.isFloat() ? operand.asFloat() : (double) operand.asInt());
+        target = TaggedValue::fromFloat(a);
+
+        return true;
+    }
+
+    /*
+     * Rest has semantics of value objects.
+     */
+    Value *a = target.box();
+    Value *b = operand.box();
+    bool result = ArithmeticInstruction::apply(op, *a, *b);
+
+    target = TaggedValue::unbox(a);
+    ORM::destroy(a);
+
+    if (operand.isScalar())
+    {
+        ORM::destroy(b);
+    }
+
+    return result;
+}
+
+/**
+ * Get unboxed default value of scalar type.
+ *
+ * @param type - variable type.
+ * @return default value, empty if type is not scalar.
+ */
+static TaggedValue
+defaultValue(eObjectType type)
+{
+    switch (type)
+    {
+        case OBJECT_TYPE_INT:
+            return TaggedValue::fromInt(0);
+        case OBJECT_TYPE_FLOAT:
+            return TaggedValue::fromFloat(0.0);
+        case OBJECT_TYPE_BOOL:
+            return TaggedValue::fromBool(false);
+        case OBJECT_TYPE_CHAR:
+            return TaggedValue::fromChar(L'\0');
+        default:
+            return TaggedValue();
+    }
+}
+
+/**
+ * Unbox scalar held by object, scalars have value semantics.
+ *
+ * @param v - value from stack.
+ * @return unboxed value.
+ */
+static TaggedValue
+unboxScalar(TaggedValue v)
+{
+    if (v.isObject())
+    {
+        return TaggedValue::unbox(v.asObject());
+    }
+
+    return v;
+}
+
+/**
+ * Assign unboxed scalar to variable.
+ *
+ * @param var - the variable.
+ * @param v - unboxed scalar.
+ */
+static void
+assignScalar(Var *var, TaggedValue v)
+{
+    Value *current = var->get();
+
+    /*
+     * Same type is written in place.
+     */
+    if (current->getObjectType() == v.getType())
+    {
+        int32_t i = v.asInt();
+        double f = v.asFloat();
+        bool b = v.asBool();
+        wchar_t c = v.asChar();
+
+        switch (v.getType())
+        {
+            case OBJECT_TYPE_INT:
+                *current = (const void *) &i;
+                return;
+            case OBJECT_TYPE_FLOAT:
+                *current = (const void *) &f;
+                return;
+            case OBJECT_TYPE_BOOL:
+                *current = (const void *) &b;
+                return;
+            default:
+                *current = (const void *) &c;
+                return;
+        }
+    }
+
+    Value *boxed = v.box();
+
+    var->set(boxed);
+    ORM::destroy(boxed);
+}
+
+/**
+ * Apply specialized operation, guard on types already holds.
+ *
+ * @param op - specialized op code.
+ * @param generic - generic op code.
+ * @param slot - frame slot of target.
+ * @param target - boxed target, nullptr if target is unboxed in slot.
+ * @param operand - operand.
+ * @return true if applied, otherwise false.
+ */
+static bool
+applySpecialized(eOpCode op, eOpCode generic, FrameSlot &slot, Value *target, TaggedValue operand)
+{
+    if (op == OP_CODE_STRING_CONCAT)
+    {
+        return ((String *) target)->String::operator+=(*operand.asObject());
+    }
+
+    if (!target)
+    {
+        return applyUnboxed(generic, slot.value, operand);
+    }
+
+    Memory *memory = ((Primitive *) target)->getMemory();
+
+    if (!memory)
+    {
+        return false;
+    }
+
+    if ((op >= OP_CODE_INT_ADD) && (op <= OP_CODE_INT_MUL))
+    {
+        applyNumeric<int32_t>(generic, memory->getElement<int32_t>(), operand.asInt());
+    }
+    else
+    {
+        applyNumeric<double>(generic, memory->getElement<double>(), operand.asFloat());
+    }
+
+    return true;
+}
+
+/**
+ * Get number of operations rewritten to specialized form.
+ *
+ * @return number of quickenings.
+ */
+size_t
+Bytecode::getQuickenCount()
+{
+    return this->quickenCount;
+}
+
+/**
+ * Get number of specialized operations rewritten back to generic form.
+ *
+ * @return number of deoptimizations.
+ */
+size_t
+Bytecode::getDeoptCount()
+{
+    return this->deoptCount;
+}
+
+/**
+ * Get number of executed instructions.
+ *
+ * @return number of executed instructions.
+ */
+size_t
+Bytecode::getExecutedCount()
+{
+    return this->executedCount;
+}
+
+/**
+ * Get execution mode.
+ *
+ * @return execution mode.
+ */
+eExecutionMode
+Bytecode::getMode()
+{
+    return this->mode;
+}
+
+/**
+ * Set execution mode, register code is translated on first use.
+ *
+ * @param mode - execution mode.
+ * @return true if set, otherwise false.
+ */
+bool
+Bytecode::setMode(eExecutionMode mode)
+{
+    if ((mode == EXECUTION_MODE_REGISTER) && this->registerCode.empty() && !this->translate())
+    {
+        return false;
+    }
+
+    this->mode = mode;
+
+    return true;
+}
+
+/**
+ * Get register instruction.
+ *
+ * @param pc - instruction index.
+ * @return register instruction.
+ */
+RegisterOp &
+Bytecode::registerAt(size_t pc)
+{
+    return this->registerCode[pc];
+}
+
+/**
+ * Translate stack instructions to register instructions.
+ *
+ * Constant pushes are not emitted, they are tracked while translating
+ * and become operand of instruction that pops them. Instruction that
+ * pops value pushed before method started reads it from stack,
+ * constants left on stack at the end are pushed.
+ *
+ * @return true if translated, otherwise false.
+ */
+bool
+Bytecode::translate()
+{
+    std::vector<RegisterOp> out;
+    std::vector<uint32_t> pending;
+
+    out.reserve(this->code.size());
+
+    for (auto &op : this->code)
+    {
+        switch (op.op)
+        {
+            case OP_CODE_PUSH_CONSTANT:
+                pending.push_back(op.a);
+                break;
+            case OP_CODE_CREATE:
+                out.push_back(RegisterOp{OP_CODE_CREATE, op.a, op.b, REGISTER_SOURCE_SLOT, 0});
+                break;
+            case OP_CODE_ASSIGN_CONSTANT:
+                out.push_back(RegisterOp{OP_CODE_ASSIGN, op.a, op.b, REGISTER_SOURCE_CONSTANT, 0});
+                break;
+            case OP_CODE_CREATE_ASSIGN_CONSTANT:
+                out.push_back(RegisterOp{OP_CODE_CREATE, op.a, op.b, REGISTER_SOURCE_SLOT, 0});
+                out.push_back(RegisterOp{OP_CODE_ASSIGN, op.a, op.c, REGISTER_SOURCE_CONSTANT, 0});
+                break;
+            case OP_CODE_ASSIGN:
+            case OP_CODE_ADD:
+            case OP_CODE_SUB:
+            case OP_CODE_MUL:
+            case OP_CODE_INT_ADD:
+            case OP_CODE_INT_SUB:
+            case OP_CODE_INT_MUL:
+            case OP_CODE_FLOAT_ADD:
+            case OP_CODE_FLOAT_SUB:
+            case OP_CODE_FLOAT_MUL:
+            case OP_CODE_STRING_CONCAT:
+            {
+                RegisterOp reg{generalize(op.op), op.a, 0, REGISTER_SOURCE_STACK, 0};
+
+                if (!pending.empty())
+                {
+                    reg.b = pending.back();
+                    reg.source = REGISTER_SOURCE_CONSTANT;
+                    pending.pop_back();
+                }
+
+                out.push_back(reg);
+                break;
+            }
+            default:
+                ERROR_LOG_ADD(ERROR_METHOD_INVALID_OPERATION);
+                return false;
+        }
+    }
+
+    for (uint32_t constNo : pending)
+    {
+        out.push_back(RegisterOp{OP_CODE_PUSH_CONSTANT, 0, constNo, REGISTER_SOURCE_CONSTANT, 0});
+    }
+
+    this->registerCode = std::move(out);
+
+    return true;
+}
+
+/**
+ * The constructor.
+ */
+BytecodeProfile::BytecodeProfile() : counts(OP_CODE_COUNT * OP_CODE_COUNT, 0)
+{
+}
+
+/**
+ * Record executed pair of instructions.
+ *
+ * @param first - op code of first instruction.
+ * @param second - op code of instruction executed after it.
+ */
+void
+BytecodeProfile::record(eOpCode first, eOpCode second)
+{
+    this->counts[first * OP_CODE_COUNT + second]++;
+}
+
+/**
+ * Get number of times pair of instructions was executed.
+ *
+ * @param first - op code of first instruction.
+ * @param second - op code of instruction executed after it.
+ * @return number of executions.
+ */
+uint64_t
+BytecodeProfile::getCount(eOpCode first, eOpCode second) const
+{
+    return this->counts[first * OP_CODE_COUNT + second];
+}
+
+/**
+ * Check if every pair of sequence was executed at least threshold times.
+ *
+ * @param sequence - op codes.
+ * @param length - number of op codes.
+ * @param threshold - minimum number of executions.
+ * @return true if hot, otherwise false.
+ */
+bool
+BytecodeProfile::isHot(const eOpCode *sequence, size_t length, uint64_t threshold) const
+{
+    for (size_t i = 1; i < length; i++)
+    {
+        if (this->getCount(sequence[i - 1], sequence[i]) < threshold)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Clear counts.
+ */
+void
+BytecodeProfile::clear()
+{
+    std::fill(this->counts.begin(), this->counts.end(), 0);
+}
+
+#define FUSION_MAX_LENGTH (3)
+
+/**
+ * Sequence of instructions replaced by superinstruction.
+ */
+struct FusionRule {
+    eOpCode sequence[FUSION_MAX_LENGTH];
+    size_t length;
+    eOpCode fused;
+};
+
+/*
+ * Longer sequences first, so they win over their prefixes and suffixes.
+ */
+static const FusionRule fusionRules[] = {
+    {{OP_CODE_CREATE, OP_CODE_PUSH_CONSTANT, OP_CODE_ASSIGN}, 3, OP_CODE_CREATE_ASSIGN_CONSTANT},
+    {{OP_CODE_PUSH_CONSTANT, OP_CODE_ASSIGN}, 2, OP_CODE_ASSIGN_CONSTANT},
+};
+
+/**
+ * Build superinstruction from sequence.
+ *
+ * @param rule - fusion rule.
+ * @param ops - matched instructions.
+ * @param fused - superinstruction.
+ * @return true if operands allow fusion, otherwise false.
+ */
+static bool
+fuseOperands(const FusionRule &rule, const BytecodeOp *ops, BytecodeOp &fused)
+{
+    switch (rule.fused)
+    {
+        case OP_CODE_CREATE_ASSIGN_CONSTANT:
+            if (ops[0].a != ops[2].a)
+            {
+                return false;
+            }
+
+            fused = BytecodeOp{rule.fused, ops[0].a, ops[0].b, ops[1].a};
+            return true;
+        case OP_CODE_ASSIGN_CONSTANT:
+            fused = BytecodeOp{rule.fused, ops[1].a, ops[0].a, 0};
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Fuse frequent sequences of instructions into superinstructions.
+ * Must be done before method starts, register code is translated again.
+ *
+ * @param profile - execution profile, if set only sequences executed
+ *                  at least threshold times are fused.
+ * @param threshold - minimum number of executions.
+ * @return number of superinstructions written.
+ */
+size_t
+Bytecode::fuse(const BytecodeProfile *profile, uint64_t threshold)
+{
+    std::vector<BytecodeOp> out;
+    size_t fusions = 0;
+
+    out.reserve(this->code.size());
+
+    for (size_t pc = 0; pc < this->code.size();)
+    {
+        const FusionRule *applied = nullptr;
+        BytecodeOp fused{};
+
+        for (const FusionRule &rule : fusionRules)
+        {
+            if (pc + rule.length > this->code.size())
+            {
+                continue;
+            }
+
+            bool match = true;
+
+            for (size_t i = 0; match && (i < rule.length); i++)
+            {
+                match = generalize(this->code[pc + i].op) == rule.sequence[i];
+            }
+
+            if (!match || (profile && !profile->isHot(rule.sequence, rule.length, threshold)))
+            {
+                continue;
+            }
+
+            if (fuseOperands(rule, &this->code[pc], fused))
+            {
+                applied = &rule;
+                break;
+            }
+        }
+
+        if (!applied)
+        {
+            out.push_back(this->code[pc++]);
+            continue;
+        }
+
+        out.push_back(fused);
+        pc += applied->length;
+        fusions++;
+    }
+
+    this->code = std::move(out);
+    this->registerCode.clear();
+
+    if (this->mode == EXECUTION_MODE_REGISTER)
+    {
+        this->translate();
+    }
+
+    return fusions;
+}
+
+/**
+ * Set profile recording executed instructions.
+ *
+ * @param profile - execution profile, nullptr stops recording.
+ */
+void
+Bytecode::setProfile(BytecodeProfile *profile)
+{
+    this->profile = profile;
+}
+
+/**
+ * Get thread of method, cached for one execution.
+ *
+ * @param m - method being executed.
+ * @param thread - cached thread.
+ * @return true if method has thread, otherwise false.
+ */
+static bool
+threadOf(Method *m, Thread *&thread)
+{
+    return thread || (thread = m->getThread());
+}
+
+/**
+ * Create variable in frame slot, scalar is held unboxed.
+ *
+ * @param m - method being executed.
+ * @param frame - frame of method.
+ * @param slot - frame slot.
+ * @param type - variable type.
+ * @return true if created, otherwise false.
+ */
+bool
+Bytecode::create(Method *m, FrameSlot *frame, uint32_t slot, eObjectType type)
+{
+    FrameSlot &frameSlot = frame[slot];
+    TaggedValue value = defaultValue(type);
+
+    if (value.isEmpty())
+    {
+        Var *var = CreateInstruction::createVar(m, this->slotNames[slot], type);
+
+        if (!var || !ERROR_LOG_IS_EMPTY)
+        {
+            return false;
+        }
+
+        frameSlot.var = var;
+        return true;
+    }
+
+    if (frameSlot.var || !frameSlot.value.isEmpty() || m->getVar(this->slotNames[slot]))
+    {
+        ERROR_LOG_ADD(ERROR_METHOD_ADD_OBJECTS_OF_SAME_NAME);
+        return false;
+    }
+
+    frameSlot.value = value;
+
+    return true;
+}
+
+/**
+ * Assign value to frame slot.
+ *
+ * @param m - method being executed.
+ * @param frame - frame of method.
+ * @param slot - frame slot.
+ * @param v - value.
+ * @return true if assigned, otherwise false.
+ */
+bool
+Bytecode::assign(Method *m, FrameSlot *frame, uint32_t slot, TaggedValue v)
+{
+    FrameSlot &frameSlot = frame[slot];
+
+    v = unboxScalar(v);
+
+    if (!frameSlot.value.isEmpty() && v.isScalar())
+    {
+        frameSlot.value = v;
+        return true;
+    }
+
+    Var *var = this->resolve(m, frame, slot);
+
+    if (!var)
+    {
+        return false;
+    }
+
+    if (v.isObject())
+    {
+        var->set(v.asObject());
+        return true;
+    }
+
+    assignScalar(var, v);
+
+    return true;
+}
+
+/**
+ * Apply arithmetic operation on frame slot.
+ *
+ * Generic operation rewrites itself to specialized form for operand
+ * types it has seen. Specialized form guards operand types and falls
+ * back to generic form when they differ, operation that keeps falling
+ * back stays generic.
+ *
+ * @param m - method being executed.
+ * @param frame - frame of method.
+ * @param code - op code, rewritten.
+ * @param deopts - number of falls back to generic form.
+ * @param slot - frame slot of target.
+ * @param operand - operand.
+ * @return true if applied, otherwise false.
+ */
+bool
+Bytecode::arithmetic(Method *m, FrameSlot *frame, eOpCode &code, uint32_t &deopts, uint32_t slot, TaggedValue operand)
+{
+    FrameSlot &frameSlot = frame[slot];
+    eOpCode generic = generalize(code);
+    Value *target = nullptr;
+    eObjectType targetType;
+
+    operand = unboxScalar(operand);
+
+    if (frameSlot.value.isEmpty())
+    {
+        Var *var = this->resolve(m, frame, slot);
+
+        if (!var)
+        {
+            return false;
+        }
+
+        target = var->get();
+        targetType = target->getObjectType();
+    }
+    else
+    {
+        targetType = frameSlot.value.getType();
+    }
+
+    if (code != generic)
+    {
+        /*
+         * Guard, specialized form was chosen for these types.
+         */
+        if (specialize(generic, targetType, operand.getType()) == code)
+        {
+            if (applySpecialized(code, generic, frameSlot, target, operand))
+            {
+                return true;
+            }
+
+            if (!ERROR_LOG_IS_EMPTY)
+            {
+                return false;
+            }
+        }
+
+        code = generic;
+        deopts++;
+        this->deoptCount++;
+    }
+
+    if (!target)
+    {
+        if (!applyUnboxed(generic, frameSlot.value, operand))
+        {
+            return false;
+        }
+
+        targetType = frameSlot.value.getType();
+    }
+    else
+    {
+        Value *v = operand.box();
+        bool result = ArithmeticInstruction::apply(generic, *target, *v);
+
+        if (operand.isScalar())
+        {
+            ORM::destroy(v);
+        }
+
+        if (!result)
+        {
+            return false;
+        }
+
+        targetType = target->getObjectType();
+    }
+
+    if (deopts < BYTECODE_DEOPT_LIMIT)
+    {
+        eOpCode specialized = specialize(generic, targetType, operand.getType());
+
+        if (specialized != generic)
+        {
+            code = specialized;
+            this->quickenCount++;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Read operand of register instruction.
+ *
+ * @param m - method being executed.
+ * @param frame - frame of method.
+ * @param thread - thread of method, cached.
+ * @param op - register instruction.
+ * @param v - read value.
+ * @return true if read, otherwise false.
+ */
+bool
+Bytecode::fetch(Method *m, FrameSlot *frame, Thread *&thread, RegisterOp &op, TaggedValue &v)
+{
+    switch (op.source)
+    {
+        case REGISTER_SOURCE_SLOT:
+        {
+            if (!frame[op.b].value.isEmpty())
+            {
+                v = frame[op.b].value;
+                return true;
+            }
+
+            Var *var = this->resolve(m, frame, op.b);
+
+            if (!var)
+            {
+                return false;
+            }
+
+            v = TaggedValue::fromObject(var->get());
+            return true;
+        }
+        case REGISTER_SOURCE_CONSTANT:
+            if (!threadOf(m, thread) || (!this->constants && !this->link(thread)))
+            {
+                return false;
+            }
+
+            v = this->constantValues[op.b];
+            return true;
+        default:
+            if (!threadOf(m, thread))
+            {
+                return false;
+            }
+
+            v = thread->popTagged();
+            return true;
+    }
+}
+
+/**
+ * Execute instructions from pc until end, error or budget runs out.
+ *
+ * @param m - method being executed.
+ * @param pc - index of next instruction, advanced.
+ * @param budget - maximum number of instructions to execute.
+ * @return INSTRUCTION_FINISHED if end is reached, INSTRUCTION_OK if budget ran out,
+ *         otherwise INSTRUCTION_ERROR.
+ */
+instruction_result
+Bytecode::execute(Method *m, size_t &pc, size_t budget)
+{
+    if (this->mode == EXECUTION_MODE_REGISTER)
+    {
+        return this->executeRegisters(m, pc, budget);
+    }
+
+    return this->executeStack(m, pc, budget);
+}
+
+/**
+ * Execute stack instructions.
+ *
+ * @param m - method being executed.
+ * @param pc - index of next instruction, advanced.
+ * @param budget - maximum number of instructions to execute.
+ * @return instruction result.
+ */
+instruction_result
+Bytecode::executeStack(Method *m, size_t &pc, size_t budget)
+{
+    BytecodeOp *code = this->code.data();
+    const size_t end = this->code.size();
+    FrameSlot *frame = m->getFrame();
+    Thread *thread = nullptr;
+
+    while (budget-- > 0)
+    {
+        if (pc >= end)
+        {
+            return INSTRUCTION_FINISHED;
+        }
+
+        BytecodeOp &op = code[pc++];
+        bool result = true;
+
+        this->executedCount++;
+
+        if (this->profile && (pc >= 2))
+        {
+            this->profile->record(generalize(code[pc - 2].op), generalize(op.op));
+        }
+
+        switch (op.op)
+        {
+            case OP_CODE_CREATE:
+                result = this->create(m, frame, op.a, (eObjectType) op.b);
+                break;
+            case OP_CODE_ASSIGN:
+                result = threadOf(m, thread) && this->assign(m, frame, op.a, thread->popTagged());
+                break;
+            case OP_CODE_PUSH_CONSTANT:
+                result = threadOf(m, thread) && (this->constants || this->link(thread));
+
+                if (result)
+                {
+                    thread->pushTagged(this->constantValues[op.a]);
+                }
+
+                break;
+            case OP_CODE_ADD:
+            case OP_CODE_SUB:
+            case OP_CODE_MUL:
+            case OP_CODE_INT_ADD:
+            case OP_CODE_INT_SUB:
+            case OP_CODE_INT_MUL:
+            case OP_CODE_FLOAT_ADD:
+            case OP_CODE_FLOAT_SUB:
+            case OP_CODE_FLOAT_MUL:
+            case OP_CODE_STRING_CONCAT:
+                result = threadOf(m, thread) &&
+                         this->arithmetic(m, frame, op.op, op.b, op.a, thread->popTagged());
+                break;
+            case OP_CODE_CREATE_ASSIGN_CONSTANT:
+                result = this->create(m, frame, op.a, (eObjectType) op.b) &&
+                         threadOf(m, thread) && (this->constants || this->link(thread)) &&
+                         this->assign(m, frame, op.a, this->constantValues[op.c]);
+                break;
+            case OP_CODE_ASSIGN_CONSTANT:
+                result = threadOf(m, thread) && (this->constants || this->link(thread)) &&
+                         this->assign(m, frame, op.a, this->constantValues[op.b]);
+                break;
+        }
+
+        if (!result || !ERROR_LOG_IS_EMPTY)
+        {
+            return INSTRUCTION_ERROR;
+        }
+    }
+
+    return (pc >= end) ? INSTRUCTION_FINISHED : INSTRUCTION_OK;
+}
+
+/**
+ * Execute register instructions, operands are read from frame slots
+ * and constant pool without going through stack.
+ *
+ * @param m - method being executed.
+ * @param pc - index of next instruction, advanced.
+ * @param budget - maximum number of instructions to execute.
+ * @return instruction result.
+ */
+instruction_result
+Bytecode::executeRegisters(Method *m, size_t &pc, size_t budget)
+{
+    RegisterOp *code = this->registerCode.data();
+    const size_t end = this->registerCode.size();
+    FrameSlot *frame = m->getFrame();
+    Thread *thread = nullptr;
+    TaggedValue v;
+
+    while (budget-- > 0)
+    {
+        if (pc >= end)
+        {
+            return INSTRUCTION_FINISHED;
+        }
+
+        RegisterOp &op = code[pc++];
+        bool result = true;
+
+        this->executedCount++;
+
+        switch (op.op)
+        {
+            case OP_CODE_CREATE:
+                result = this->create(m, frame, op.a, (eObjectType) op.b);
+                break;
+            case OP_CODE_ASSIGN:
+                result = this->fetch(m, frame, thread, op, v) && this->assign(m, frame, op.a, v);
+                break;
+            case OP_CODE_PUSH_CONSTANT:
+                result = this->fetch(m, frame, thread, op, v);
+
+                if (result)
+                {
+                    thread->pushTagged(v);
+                }
+
+                break;
+            case OP_CODE_ADD:
+            case OP_CODE_SUB:
+            case OP_CODE_MUL:
+            case OP_CODE_INT_ADD:
+            case OP_CODE_INT_SUB:
+            case OP_CODE_INT_MUL:
+            case OP_CODE_FLOAT_ADD:
+            case OP_CODE_FLOAT_SUB:
+            case OP_CODE_FLOAT_MUL:
+            case OP_CODE_STRING_CONCAT:
+                result = this->fetch(m, frame, thread, op, v) &&
+                         this->arithmetic(m, frame, op.op, op.deopts, op.a, v);
+                break;
+            default:
+                ERROR_LOG_ADD(ERROR_METHOD_INVALID_OPERATION);
+                result = false;
+                break;
+        }
+
+        if (!result || !ERROR_LOG_IS_EMPTY)
+        {
+            return INSTRUCTION_ERROR;
+        }
+    }
+
+    return (pc >= end) ? INSTRUCTION_FINISHED : INSTRUCTION_OK;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <ORM/ORM.h>
+#include <ErrorBundle/ErrorLog.h>
+#include <VariableBundle/Var.h>
+#include <VariableBundle/Value.h>
+#include <MethodBundle/Method.h>
+#include <MethodBundle/Instruction/ArithmeticInstruction.h>
+
+/**
+ * @inherit
+ */
+ArithmeticInstruction::ArithmeticInstruction(eOpCode op, std::vector<std::wstring> &arg)
+    : Instruction(op, arg)
+{
+}
+
+/**
+ * @inherit
+ */
+Instruction *
+ArithmeticInstruction::execute()
+{
+    auto *m = this->getMethod();
+    TaggedValue operand = m->popTagged();
+    Var *var = m->getVar(this->arg[0]);
+
+    if (!var)
+    {
+        ERROR_LOG_ADD(ERROR_INSTRUCTION_OBJECT_DOES_NOT_EXIST);
+        return nullptr;
+    }
+
+    Value *v = operand.box();
+    bool result = ArithmeticInstruction::apply(this->op, *var->get(), *v);
+
+    if (operand.isScalar())
+    {
+        ORM::destroy(v);
+    }
+
+    return result ? this->getNext() : nullptr;
+}
+
+/**
+ * Apply generic arithmetic operation.
+ *
+ * @param op - OP_CODE_ADD, OP_CODE_SUB or OP_CODE_MUL.
+ * @param target - value to change.
+ * @param operand - value to apply.
+ * @return true if success, otherwise false.
+ */
+bool
+ArithmeticInstruction::apply(eOpCode op, Value &target, Value &operand)
+{
+    switch (op)
+    {
+        case OP_CODE_ADD:
+            return target += operand;
+        case OP_CODE_SUB:
+            return target -= operand;
+        case OP_CODE_MUL:
+            return target *= operand;
+        default:
+            ERROR_LOG_ADD(ERROR_METHOD_INVALID_OPERATION);
+            return false;
+    }
+}
+
+/**
+ * @inherit
+ */
+ArithmeticInstruction *
+ArithmeticInstruction::create(eOpCode op, std::wstring name)
+{
+    std::vector<std::wstring> arg;
+    arg.emplace_back(name);
+
+    return ORM::create(new ArithmeticInstruction(op, arg));
+}
+
+/**
+ * @inherit
+ */
+bool
+ArithmeticInstruction::validate()
+{
+    auto *m = this->getMethod();
+
+    if (!m)
+    {
+        return false;
+    }
+
+    if (this->arg.size() != 1)
+    {
+        ERROR_LOG_ADD(ERROR_INSTRUCTION_INVALID_NO_OF_ARGS);
+        return false;
+    }
+
+    this->validated = true;
+    return true;
+}
+
+/**
+ * @inherit
+ */
+bool
+ArithmeticInstruction::compile(Bytecode &bytecode)
+{
+    if (this->arg.size() != 1)
+    {
+        ERROR_LOG_ADD(ERROR_INSTRUCTION_INVALID_NO_OF_ARGS);
+        return false;
+    }
+
+    bytecode.emit(this->op, bytecode.addSlot(this->arg[0]));
+
+    return true;
+}
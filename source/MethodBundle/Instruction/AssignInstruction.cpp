@@ -46,10 +46,20 @@ Instruction *
 AssignInstruction::execute()
 {
     auto *m = this->getMethod();
-    auto *data2 = m->pop();
+    TaggedValue data2 = m->popTagged();
 
     Var *var = m->getVar(this->arg[0]);
-    var->set(data2);
+    Value *v = data2.box();
+
+    var->set(v);
+
+    /*
+     * Var copies scalar, box is not needed after.
+     */
+    if (data2.isScalar())
+    {
+        ORM::destroy(v);
+    }
 
     return this->getNext();
 }
@@ -63,9 +73,7 @@ AssignInstruction::create(std::wstring name)
     std::vector<std::wstring> arg;
     arg.emplace_back(name);
 
-    return dynamic_cast<AssignInstruction *>(ORM::create(
-        new AssignInstruction(arg)
-    ));
+    return ORM::create(new AssignInstruction(arg));
 }
 
 /**
@@ -81,9 +89,7 @@ AssignInstruction::validate()
         return false;
     }
 
-    auto *data2 = m->pop();
-
-    if (!data2)
+    if (m->popTagged().isEmpty())
     {
         ERROR_LOG_ADD(ERROR_INSTRUCTION_OBJECT_DOES_NOT_EXIST);
 
@@ -102,3 +108,20 @@ AssignInstruction::validate()
     this->validated = true;
     return true;
 }
+
+/**
+ * @inherit
+ */
+bool
+AssignInstruction::compile(Bytecode &bytecode)
+{
+    if (this->arg.size() != 1)
+    {
+        ERROR_LOG_ADD(ERROR_INSTRUCTION_INVALID_NO_OF_ARGS);
+        return false;
+    }
+
+    bytecode.emit(OP_CODE_ASSIGN, bytecode.addSlot(this->arg[0]));
+
+    return true;
+}
@@ -47,20 +47,42 @@ CreateInstruction::execute()
 {
     auto &name_w = this->arg[0];
     auto &type = this->arg[1];
-    Var *data = nullptr;
 
     using convert_type = std::codecvt_utf8<wchar_t>;
     std::wstring_convert<convert_type, wchar_t> converter;
     std::string name = converter.to_bytes(name_w);
 
-    if (type == L"Collection")
+    eObjectType objectType = (type == L"Collection") ? OBJECT_TYPE_COLLECTION : DataType::getFromToken(type);
+
+    if (!CreateInstruction::createVar(this->getMethod(), name, objectType))
+    {
+        return nullptr;
+    }
+
+    return this->getNext();
+}
+
+/**
+ * Create variable and add it to method.
+ *
+ * @param m - method.
+ * @param name - variable name.
+ * @param type - variable type.
+ * @return variable if created, otherwise nullptr.
+ */
+Var *
+CreateInstruction::createVar(Method *m, const std::string &name, eObjectType type)
+{
+    Var *data = nullptr;
+
+    if (type == OBJECT_TYPE_COLLECTION)
     {
         data = Var::create(name, Collection::create());
     }
     /* TODO add for a Method or Clazz */
     else
     {
-        data = Var::create(name, Primitive::create(DataType::getFromToken(type)));
+        data = Var::create(name, Primitive::create(type));
     }
 
     if (!data)
@@ -68,10 +90,9 @@ CreateInstruction::execute()
         return nullptr;
     }
 
-    auto *m = this->getMethod();
     m->addVar(data);
 
-    return this->getNext();
+    return data;
 }
 
 /**
@@ -84,7 +105,7 @@ CreateInstruction::create(std::wstring name, std::wstring type)
     arg.emplace_back(name);
     arg.emplace_back(type);
 
-    return dynamic_cast<CreateInstruction *>(ORM::create(new CreateInstruction(arg)));
+    return ORM::create(new CreateInstruction(arg));
 }
 
 /**
@@ -118,3 +139,31 @@ CreateInstruction::validate()
 
     return true;
 }
+
+/**
+ * @inherit
+ */
+bool
+CreateInstruction::compile(Bytecode &bytecode)
+{
+    if (this->arg.size() != 2)
+    {
+        ERROR_LOG_ADD(ERROR_INSTRUCTION_INVALID_NO_OF_ARGS);
+        return false;
+    }
+
+    auto &name = this->arg[0];
+    auto &type = this->arg[1];
+
+    if (!this->objectNameIsValid(name))
+    {
+        ERROR_LOG_ADD(ERROR_INSTRUCTION_INVALID_OBJECT_NAME);
+        return false;
+    }
+
+    eObjectType objectType = (type == L"Collection") ? OBJECT_TYPE_COLLECTION : DataType::getFromToken(type);
+
+    bytecode.emit(OP_CODE_CREATE, bytecode.addSlot(name), objectType);
+
+    return true;
+}
@@ -122,7 +122,7 @@ Instruction::executeIt()
         }
     }
 
-    this->execute();
+    return this->execute();
 }
 
 /**
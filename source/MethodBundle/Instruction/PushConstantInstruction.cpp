@@ -25,6 +25,8 @@
 #include <MethodBundle/Method.h>
 #include <ThreadBundle/Thread.h>
 #include <InterpreterBundle/Interpreter.h>
+#include <ErrorBundle/ErrorLog.h>
+#include <cwchar>
 
 /**
  * The constructor.
@@ -33,6 +35,9 @@
  */
 PushConstantInstruction::PushConstantInstruction(std::vector<std::wstring> &arg) : Instruction(OP_CODE_PUSH_CONSTANT, arg)
 {
+    this->constNo = 0;
+    this->constants = nullptr;
+    this->method = nullptr;
 }
 
 /**
@@ -44,7 +49,7 @@ PushConstantInstruction::PushConstantInstruction(std::vector<std::wstring> &arg)
 PushConstantInstruction *
 PushConstantInstruction::create(std::vector<std::wstring> &arg)
 {
-    return (PushConstantInstruction *)ORM::create(new PushConstantInstruction(arg));
+    return ORM::create(new PushConstantInstruction(arg));
 }
 
 /**
@@ -53,21 +58,85 @@ PushConstantInstruction::create(std::vector<std::wstring> &arg)
 Instruction *
 PushConstantInstruction::execute()
 {
-    uint32_t constNo = 0;
-    wscanf(this->arg[0].c_str(), "%d", &constNo);
-
-    Value *val = this->getMethod()
-            ->getThread()
-            ->getInterpreter()
-            ->getConstants()
-            ->get(constNo);
+    Value *val = this->constants->get(this->constNo);
 
     if (!val)
     {
         return nullptr;
     }
 
-    this->getMethod()->push(val);
+    this->method->push(val);
 
     return this->getNext();
-}
\ No newline at end of file
+}
+
+/**
+ * Decode constant number.
+ *
+ * @return true if valid, otherwise false.
+ */
+bool
+PushConstantInstruction::decode()
+{
+    if (this->arg.size() != 1)
+    {
+        ERROR_LOG_ADD(ERROR_INSTRUCTION_INVALID_NO_OF_ARGS);
+        return false;
+    }
+
+    wchar_t *end = nullptr;
+    unsigned long constNo = wcstoul(this->arg[0].c_str(), &end, 10);
+
+    if (this->arg[0].empty() || (*end != L'\0') || (constNo > UINT32_MAX))
+    {
+        ERROR_LOG_ADD(ERROR_CONSTANT_UNDEFINED);
+        return false;
+    }
+
+    this->constNo = (uint32_t) constNo;
+
+    return true;
+}
+
+/**
+ * @inherit
+ */
+bool
+PushConstantInstruction::validate()
+{
+    this->method = this->getMethod();
+
+    if (!this->method || !this->decode())
+    {
+        return false;
+    }
+
+    Thread *thread = this->method->getThread();
+
+    if (!thread || !thread->getInterpreter())
+    {
+        ERROR_LOG_ADD(ERROR_METHOD_NOT_PART_OF_THREAD);
+        return false;
+    }
+
+    this->constants = thread->getInterpreter()->getConstants();
+    this->validated = true;
+
+    return true;
+}
+
+/**
+ * @inherit
+ */
+bool
+PushConstantInstruction::compile(Bytecode &bytecode)
+{
+    if (!this->decode())
+    {
+        return false;
+    }
+
+    bytecode.emit(OP_CODE_PUSH_CONSTANT, this->constNo);
+
+    return true;
+}
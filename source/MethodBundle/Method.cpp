@@ -33,6 +33,8 @@
 #include <codecvt>
 #include <VariableBundle/Primitive/String.h>
 #include <iostream>
+#include <cstdint>
+#include <algorithm>
 
 /**
  * The constructor.
@@ -43,6 +45,7 @@
 Method::Method(std::string id, std::vector<Instruction *> &instructions) : Value::Value()
 {
     this->setId(id);
+    this->pc = 0;
 
     MasterRelationships *master = this->getMaster();
 
@@ -87,6 +90,16 @@ Method::Method(std::string id, std::vector<Instruction *> &instructions) : Value
 instruction_result
 Method::step()
 {
+    if (this->bytecode)
+    {
+        if (this->pc >= this->bytecode->size())
+        {
+            return INSTRUCTION_ERROR;
+        }
+
+        return this->bytecode->execute(this, this->pc, 1);
+    }
+
     if (!this->currentInstruction)
     {
         return INSTRUCTION_ERROR;
@@ -107,6 +120,151 @@ Method::step()
     return INSTRUCTION_OK;
 }
 
+/**
+ * Lower instructions to bytecode. Afterwards step() and run()
+ * execute bytecode instead of instruction objects.
+ *
+ * @param fuse - fuse sequences into superinstructions.
+ * @return true if compiled, otherwise false.
+ */
+bool
+Method::compile(bool fuse)
+{
+    if (this->bytecode)
+    {
+        return true;
+    }
+
+    std::unique_ptr<Bytecode> code(new Bytecode());
+    Relationship *r = this->getMaster()->get("method_instructions");
+
+    for (Object *o : *r)
+    {
+        if (!((Instruction *) o)->compile(*code))
+        {
+            return false;
+        }
+    }
+
+    if (fuse)
+    {
+        code->fuse();
+    }
+
+    this->bytecode = std::move(code);
+    this->frame.assign(this->bytecode->getSlotCount(), FrameSlot{nullptr, TaggedValue()});
+    this->pc = 0;
+
+    return true;
+}
+
+/**
+ * Check if method is compiled.
+ *
+ * @return true if compiled, otherwise false.
+ */
+bool
+Method::isCompiled()
+{
+    return this->bytecode != nullptr;
+}
+
+/**
+ * Get compiled instructions.
+ *
+ * @return bytecode if compiled, otherwise nullptr.
+ */
+Bytecode *
+Method::getBytecode()
+{
+    return this->bytecode.get();
+}
+
+/**
+ * Set execution mode of compiled method, compiled first if needed.
+ * Mode can be changed only before method starts or after it is cleared.
+ *
+ * @param mode - execution mode.
+ * @return true if set, otherwise false.
+ */
+bool
+Method::setMode(eExecutionMode mode)
+{
+    if (!this->compile())
+    {
+        return false;
+    }
+
+    if (this->pc != 0)
+    {
+        ERROR_LOG_ADD(ERROR_METHOD_INVALID_OPERATION);
+        return false;
+    }
+
+    return this->bytecode->setMode(mode);
+}
+
+/**
+ * Fuse sequences of compiled method into superinstructions.
+ * Can be done only before method starts or after it is cleared.
+ *
+ * @param profile - execution profile, if set only hot sequences are fused.
+ * @param threshold - minimum number of executions of hot sequence.
+ * @return true if fused, otherwise false.
+ */
+bool
+Method::fuse(const BytecodeProfile *profile, uint64_t threshold)
+{
+    if (!this->compile())
+    {
+        return false;
+    }
+
+    if (this->pc != 0)
+    {
+        ERROR_LOG_ADD(ERROR_METHOD_INVALID_OPERATION);
+        return false;
+    }
+
+    this->bytecode->fuse(profile, threshold);
+
+    return true;
+}
+
+/**
+ * Execute method to the end, compiled first if needed.
+ *
+ * @return INSTRUCTION_FINISHED if finished, otherwise INSTRUCTION_ERROR.
+ */
+instruction_result
+Method::run()
+{
+    return this->execute(SIZE_MAX);
+}
+
+/**
+ * Execute at most budget instructions, compiled first if needed.
+ *
+ * @param budget - maximum number of instructions.
+ * @return INSTRUCTION_FINISHED if finished, INSTRUCTION_OK if budget ran out,
+ *         otherwise INSTRUCTION_ERROR.
+ */
+instruction_result
+Method::execute(size_t budget)
+{
+    if (!this->compile())
+    {
+        return INSTRUCTION_ERROR;
+    }
+
+    if (this->pc >= this->bytecode->size())
+    {
+        return INSTRUCTION_ERROR;
+    }
+
+    return this->bytecode->execute(this, this->pc, budget);
+}
+
 /**
  * Push value to stack.
  *
@@ -126,21 +284,21 @@ Method::push(Value *v)
 }
 
 /**
- * Pop value from stack.
+ * Pop value from stack without boxing.
  *
- * @return value.
+ * @return value, scalar stays unboxed.
  */
-Value *
-Method::pop()
+TaggedValue
+Method::popTagged()
 {
     Thread *thread = this->getThread();
 
     if (!thread)
     {
-        return (Value *) ORM::getFirst(OBJECT_TYPE_NULL);
+        return TaggedValue::fromObject((Value *) ORM::getSingleton(OBJECT_TYPE_NULL));
     }
 
-    return thread->popStack();
+    return thread->popTagged();
 }
 
 /**
@@ -153,7 +311,7 @@ Method::pop()
 Method *
 Method::create(std::string id, std::vector<Instruction *> &instructions)
 {
-    return (Method *) ORM::create(new Method(std::move(id), instructions));
+    return ORM::create(new Method(std::move(id), instructions));
 }
 
 /**
@@ -171,6 +329,8 @@ Method::clear()
     MasterRelationships *master = this->getMaster();
 
     this->currentInstruction = (Instruction *) master->front("method_instructions");
+    this->pc = 0;
+    std::fill(this->frame.begin(), this->frame.end(), FrameSlot{nullptr, TaggedValue()});
     master->clearObjects("method_vars");
 }
 
@@ -194,13 +354,59 @@ Method::addVar(Var *v)
 Var *
 Method::getVar(std::wstring id)
 {
+    using convert_type = std::codecvt_utf8<wchar_t>;
+    static thread_local std::wstring_convert<convert_type, wchar_t> converter;
+
+    return this->getVar(converter.to_bytes(id));
+}
+
+Var *
+Method::getVar(const std::string &id)
+{
+    /*
+     * Compiled method has variables resolved to frame slots,
+     * unboxed scalar gets boxed into variable once it is needed.
+     */
+    if (this->bytecode)
+    {
+        uint32_t slot = this->bytecode->findSlot(id);
+
+        if (slot != NO_FRAME_SLOT)
+        {
+            FrameSlot &frameSlot = this->frame[slot];
+
+            if (frameSlot.var)
+            {
+                return frameSlot.var;
+            }
+
+            if (!frameSlot.value.isEmpty())
+            {
+                Var *var = Var::create(id, frameSlot.value.box());
+
+                this->addVar(var);
+                frameSlot.var = var;
+                frameSlot.value = TaggedValue();
+
+                return var;
+            }
+        }
+    }
+
     Relationship *r = this->getMaster()->get("method_vars");
 
-    using convert_type = std::codecvt_utf8<wchar_t>;
-    std::wstring_convert<convert_type, wchar_t> converter;
-    std::string name = converter.to_bytes(id);
+    return (Var *) r->find(id);
+}
 
-    return (Var *) r->find(name);
+/**
+ * Get frame of compiled method.
+ *
+ * @return variables indexed by frame slot.
+ */
+FrameSlot *
+Method::getFrame()
+{
+    return this->frame.data();
 }
 
 /**
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <ORM/Cascade.h>
+#include <ORM/Object.h>
+#include <ORM/Relationship.h>
+#include <ORM/MasterRelationships.h>
+#include <vector>
+
+/*
+ * Worklist of cascade running on this thread, nullptr if none.
+ */
+static thread_local std::vector<Object *> *worklist = nullptr;
+static thread_local ORM::CascadeStats lastCascade = {0, 0, 0};
+static thread_local size_t cascadeCount = 0;
+
+/**
+ * Release master relationships of marked object and of every object
+ * orphaned by it.
+ *
+ * Objects orphaned while cascade runs are queued instead of being
+ * cleared recursively, so stack depth does not grow with graph depth
+ * and each object is cleared once.
+ *
+ * @param o - marked object.
+ */
+void
+ORM::cascade(Object *o)
+{
+    if (worklist)
+    {
+        worklist->push_back(o);
+        return;
+    }
+
+    std::vector<Object *> pending;
+    CascadeStats stats = {0, 0, 0};
+
+    worklist = &pending;
+    pending.push_back(o);
+
+    while (!pending.empty())
+    {
+        if (pending.size() > stats.peakWorklist)
+        {
+            stats.peakWorklist = pending.size();
+        }
+
+        Object *e = pending.back();
+        pending.pop_back();
+
+        MasterRelationships *master = e->getMaster();
+
+        master->forEach([&](Relationship *r) {
+            stats.edges += r->size();
+        });
+
+        master->clearObjects();
+        stats.objects++;
+    }
+
+    worklist = nullptr;
+    lastCascade = stats;
+    cascadeCount++;
+}
+
+/**
+ * Get statistics of last cascade on this thread.
+ *
+ * @return statistics.
+ */
+ORM::CascadeStats
+ORM::getLastCascade()
+{
+    return lastCascade;
+}
+
+/**
+ * Get number of cascades run on this thread.
+ *
+ * @return number of cascades.
+ */
+size_t
+ORM::getCascadeCount()
+{
+    return cascadeCount;
+}
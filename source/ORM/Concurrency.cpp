@@ -0,0 +1,333 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <ORM/Concurrency.h>
+#include <ORM/ObjectPool.h>
+#include <ORM/Object.h>
+#include <ORM/SweepPool.h>
+#include <mutex>
+
+/**
+ * Objects swept in the same epoch.
+ */
+struct RetiredBatch {
+    uint64_t epoch;
+    std::vector<std::unique_ptr<Object>> objects;
+};
+
+/**
+ * Epoch slot claimed by a thread, released when thread exits.
+ */
+struct EpochSlot {
+    size_t index = ORM_EPOCH_SLOTS;
+    size_t depth = 0;
+
+    ~EpochSlot();
+};
+
+std::atomic<bool> ORM::concurrent(false);
+
+/**
+ * @brief graphMutex - serializes edits of object graph.
+ */
+static std::recursive_mutex graphMutex;
+
+/**
+ * @brief globalEpoch - advanced on each retire.
+ */
+static std::atomic<uint64_t> globalEpoch(1);
+
+/**
+ * @brief epochs - epoch of each thread inside guard, 0 if idle.
+ */
+static std::atomic<uint64_t> epochs[ORM_EPOCH_SLOTS];
+static std::atomic<bool> slotOwned[ORM_EPOCH_SLOTS];
+
+/**
+ * @brief overflow - threads inside guard without a slot, reclaim waits for them.
+ */
+static std::atomic<size_t> overflow(0);
+
+static std::mutex retiredMutex;
+static std::vector<RetiredBatch> retired;
+
+static thread_local EpochSlot epochSlot;
+
+/**
+ * The destructor.
+ */
+EpochSlot::~EpochSlot()
+{
+    if (this->index < ORM_EPOCH_SLOTS)
+    {
+        epochs[this->index].store(0);
+        slotOwned[this->index].store(false);
+    }
+}
+
+/**
+ * Claim epoch slot for calling thread.
+ *
+ * @return true if thread has a slot, otherwise false.
+ */
+static bool
+claimEpochSlot()
+{
+    if (epochSlot.index < ORM_EPOCH_SLOTS)
+    {
+        return true;
+    }
+
+    for (size_t i = 0; i < ORM_EPOCH_SLOTS; i++)
+    {
+        bool expected = false;
+
+        if (slotOwned[i].compare_exchange_strong(expected, true))
+        {
+            epochSlot.index = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Enable or disable concurrent mode.
+ * Must be switched while no other thread uses ORM.
+ *
+ * @param enabled
+ */
+void
+ORM::setConcurrent(bool enabled)
+{
+    /*
+     * Object storage is released thread safe only in concurrent mode.
+     */
+    if (!enabled)
+    {
+        ORM::waitDestroyed();
+    }
+
+    ORM::concurrent.store(enabled);
+    ObjectPool::setConcurrent(enabled);
+
+    if (!enabled)
+    {
+        std::vector<RetiredBatch> batches;
+
+        {
+            std::lock_guard<std::mutex> lock(retiredMutex);
+            batches.swap(retired);
+        }
+    }
+}
+
+/**
+ * Retire swept objects, they are released once no thread can reach them.
+ *
+ * @param objects - swept objects, ownership is taken.
+ */
+void
+ORM::retire(std::vector<std::unique_ptr<Object>> &objects)
+{
+    if (objects.empty())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(retiredMutex);
+
+    RetiredBatch batch;
+
+    batch.epoch = globalEpoch.fetch_add(1);
+    batch.objects = std::move(objects);
+
+    retired.push_back(std::move(batch));
+}
+
+/**
+ * Release retired objects that are older than every active epoch.
+ */
+void
+ORM::reclaim()
+{
+    if (overflow.load() > 0)
+    {
+        return;
+    }
+
+    uint64_t oldest = UINT64_MAX;
+
+    for (auto &epoch : epochs)
+    {
+        uint64_t e = epoch.load();
+
+        if ((e != 0) && (e < oldest))
+        {
+            oldest = e;
+        }
+    }
+
+    std::vector<RetiredBatch> released;
+
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+
+        auto it = retired.begin();
+
+        while ((it != retired.end()) && (it->epoch < oldest))
+        {
+            released.push_back(std::move(*it));
+            it++;
+        }
+
+        retired.erase(retired.begin(), it);
+    }
+
+    if (released.empty() || (ORM::getSweepWorkers() == 0))
+    {
+        return;
+    }
+
+    /*
+     * Objects without observable destructor side effects are
+     * destroyed by sweep workers, the rest right here.
+     */
+    std::vector<std::unique_ptr<Object>> offloaded;
+
+    for (auto &batch : released)
+    {
+        for (auto &op : batch.objects)
+        {
+            if (!op->hasObservableDestructor())
+            {
+                offloaded.push_back(std::move(op));
+            }
+        }
+    }
+
+    ORM::offloadDestroy(offloaded);
+}
+
+/**
+ * Get number of retired objects not released yet.
+ *
+ * @return number of objects.
+ */
+size_t
+ORM::getRetiredCount()
+{
+    std::lock_guard<std::mutex> lock(retiredMutex);
+
+    size_t count = 0;
+
+    for (auto &batch : retired)
+    {
+        count += batch.objects.size();
+    }
+
+    return count;
+}
+
+/**
+ * The constructor.
+ */
+ORM::Lock::Lock()
+{
+    this->locked = ORM::isConcurrent();
+
+    if (this->locked)
+    {
+        graphMutex.lock();
+    }
+}
+
+/**
+ * The destructor.
+ */
+ORM::Lock::~Lock()
+{
+    if (this->locked)
+    {
+        graphMutex.unlock();
+    }
+}
+
+/**
+ * The constructor.
+ */
+ORM::EpochGuard::EpochGuard()
+{
+    this->entered = ORM::isConcurrent();
+
+    if (!this->entered)
+    {
+        return;
+    }
+
+    if (!claimEpochSlot())
+    {
+        overflow++;
+        return;
+    }
+
+    if (epochSlot.depth++ > 0)
+    {
+        return;
+    }
+
+    uint64_t epoch;
+
+    /*
+     * Epoch must not advance between read and publish.
+     */
+    do
+    {
+        epoch = globalEpoch.load();
+        epochs[epochSlot.index].store(epoch);
+    }
+    while (globalEpoch.load() != epoch);
+}
+
+/**
+ * The destructor.
+ */
+ORM::EpochGuard::~EpochGuard()
+{
+    if (!this->entered)
+    {
+        return;
+    }
+
+    if (epochSlot.index >= ORM_EPOCH_SLOTS)
+    {
+        overflow--;
+        return;
+    }
+
+    if (--epochSlot.depth == 0)
+    {
+        epochs[epochSlot.index].store(0);
+    }
+}
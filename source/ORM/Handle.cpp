@@ -0,0 +1,229 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <ORM/Handle.h>
+#include <ORM/Object.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#define HANDLE_CAPACITY ((uint32_t) HANDLE_PAGES * HANDLE_PAGE_SLOTS)
+
+/**
+ * Handle table slot.
+ */
+struct HandleSlot {
+    std::atomic<Object *> object;
+    std::atomic<uint32_t> generation;
+};
+
+/*
+ * Pages are never freed nor moved, readers need no lock.
+ */
+static std::atomic<HandleSlot *> pages[HANDLE_PAGES];
+
+/*
+ * Slot 0 is never used, object without handle has index 0.
+ */
+static uint32_t nextIndex = 1;
+static std::vector<uint32_t> freeSlots;
+static std::mutex tableMutex;
+static std::atomic<size_t> handleCount(0);
+
+/**
+ * Get slot of index.
+ *
+ * @param index
+ * @return slot if its page exists, otherwise nullptr.
+ */
+static inline HandleSlot *
+getSlot(uint32_t index)
+{
+    if (index >= HANDLE_CAPACITY)
+    {
+        return nullptr;
+    }
+
+    HandleSlot *page = pages[index / HANDLE_PAGE_SLOTS].load(std::memory_order_acquire);
+
+    return page ? &page[index % HANDLE_PAGE_SLOTS] : nullptr;
+}
+
+/**
+ * Take unused slot, table mutex must be held.
+ *
+ * @return slot index, 0 if table is full.
+ */
+static uint32_t
+acquireSlot()
+{
+    if (!freeSlots.empty())
+    {
+        uint32_t index = freeSlots.back();
+        freeSlots.pop_back();
+
+        return index;
+    }
+
+    if (nextIndex >= HANDLE_CAPACITY)
+    {
+        return 0;
+    }
+
+    uint32_t index = nextIndex++;
+    std::atomic<HandleSlot *> &page = pages[index / HANDLE_PAGE_SLOTS];
+
+    if (!page.load(std::memory_order_relaxed))
+    {
+        auto *slots = new HandleSlot[HANDLE_PAGE_SLOTS];
+
+        for (size_t i = 0; i < HANDLE_PAGE_SLOTS; i++)
+        {
+            slots[i].object.store(nullptr, std::memory_order_relaxed);
+            slots[i].generation.store(1, std::memory_order_relaxed);
+        }
+
+        page.store(slots, std::memory_order_release);
+    }
+
+    return index;
+}
+
+/**
+ * Get handle of object, slot is taken on first use.
+ * Table mutex is taken only to take the slot.
+ *
+ * @param o - the object.
+ * @return handle, null handle if object is nullptr or table is full.
+ */
+ObjectHandle
+ORM::getHandle(Object *o)
+{
+    if (!o)
+    {
+        return ObjectHandle{0, 0};
+    }
+
+    uint32_t index = o->getHandleIndex();
+
+    if (index != 0)
+    {
+        return ObjectHandle{index, getSlot(index)->generation.load(std::memory_order_acquire)};
+    }
+
+    std::lock_guard<std::mutex> lock(tableMutex);
+
+    /*
+     * Other thread may have taken slot meanwhile.
+     */
+    index = o->getHandleIndex();
+
+    if (index == 0)
+    {
+        index = acquireSlot();
+
+        if (index == 0)
+        {
+            return ObjectHandle{0, 0};
+        }
+
+        getSlot(index)->object.store(o, std::memory_order_release);
+        o->setHandleIndex(index);
+        handleCount++;
+    }
+
+    return ObjectHandle{index, getSlot(index)->generation.load(std::memory_order_acquire)};
+}
+
+/**
+ * Resolve handle.
+ *
+ * @param handle
+ * @return object if alive, otherwise nullptr.
+ */
+Object *
+ORM::resolve(ObjectHandle handle)
+{
+    if (handle.generation == 0)
+    {
+        return nullptr;
+    }
+
+    HandleSlot *slot = getSlot(handle.index);
+
+    if (!slot || (slot->generation.load(std::memory_order_acquire) != handle.generation))
+    {
+        return nullptr;
+    }
+
+    Object *o = slot->object.load(std::memory_order_acquire);
+
+    /*
+     * Slot may be released and taken again meanwhile.
+     */
+    if (!o || (slot->generation.load(std::memory_order_acquire) != handle.generation))
+    {
+        return nullptr;
+    }
+
+    return o->getMarked() ? nullptr : o;
+}
+
+/**
+ * Release handle slot of object being freed.
+ * All handles of the object become stale.
+ *
+ * @param o - the object.
+ */
+void
+ORM::releaseHandle(Object *o)
+{
+    uint32_t index = o->getHandleIndex();
+
+    if (index == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(tableMutex);
+    HandleSlot *slot = getSlot(index);
+    uint32_t generation = slot->generation.load(std::memory_order_relaxed) + 1;
+
+    slot->generation.store((generation == 0) ? 1 : generation, std::memory_order_release);
+    slot->object.store(nullptr, std::memory_order_release);
+
+    o->setHandleIndex(0);
+    freeSlots.push_back(index);
+    handleCount--;
+}
+
+/**
+ * Get number of objects with a handle.
+ *
+ * @return number of handles.
+ */
+size_t
+ORM::getHandleCount()
+{
+    return handleCount.load();
+}
@@ -0,0 +1,258 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <ORM/Introspection.h>
+#include <ORM/ORM.h>
+#include <ORM/Object.h>
+#include <ORM/ObjectRepository.h>
+#include <ORM/Relationship.h>
+#include <ORM/MasterRelationships.h>
+#include <PersistenceBundle/BinaryStream.h>
+#include <algorithm>
+#include <cstdio>
+
+/*
+ * Dump is written to file in pieces of this size.
+ */
+#define HEAP_DUMP_FLUSH_SIZE (64 * 1024)
+
+#define HEAP_DUMP_MARKED (1)
+#define HEAP_DUMP_FROZEN (2)
+
+/**
+ * Get statistics of object type.
+ *
+ * @param type
+ * @return statistics if there are objects of type, otherwise nullptr.
+ */
+const TypeStats *
+HeapStats::getType(eObjectType type) const
+{
+    for (auto &stats : this->types)
+    {
+        if (stats.type == type)
+        {
+            return &stats;
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * Get number of slaves held by object through master relationships.
+ *
+ * @param o - the object.
+ * @return number of slaves.
+ */
+static size_t
+countSlaves(Object *o)
+{
+    size_t slaves = 0;
+
+    o->getMaster()->forEach([&](Relationship *r) {
+        slaves += r->size();
+    });
+
+    return slaves;
+}
+
+/**
+ * Get fan-out histogram bucket.
+ *
+ * @param slaves - number of slaves.
+ * @return bucket index.
+ */
+size_t
+ORM::getFanoutBucket(size_t slaves)
+{
+    size_t bucket = 0;
+
+    while (slaves > 0)
+    {
+        slaves >>= 1;
+        bucket++;
+    }
+
+    return std::min(bucket, (size_t) INTROSPECTION_FANOUT_BUCKETS - 1);
+}
+
+/**
+ * Collect statistics of all repositories: objects, bytes, marked
+ * objects not swept yet, fan-out of master relationships and
+ * masters holding the most slaves.
+ *
+ * @param topRetainers - number of retainers to report.
+ * @return statistics.
+ */
+HeapStats
+ORM::inspect(size_t topRetainers)
+{
+    ORM::Lock lock;
+    HeapStats heap;
+
+    heap.objects = 0;
+    heap.bytes = 0;
+    heap.marked = 0;
+
+    auto smaller = [](const Retainer &a, const Retainer &b) {
+        return a.slaves > b.slaves;
+    };
+
+    ORM::forEachRepository([&](eObjectType type, ObjectRepository *repository) {
+        TypeStats stats = {};
+
+        stats.type = type;
+
+        repository->scan([&](Object *o) {
+            size_t slaves = countSlaves(o);
+
+            stats.objects++;
+            stats.bytes += o->getFootprint();
+            stats.marked += o->getMarked() ? 1 : 0;
+            stats.frozen += o->isFrozen() ? 1 : 0;
+            stats.edges += slaves;
+            stats.fanout[ORM::getFanoutBucket(slaves)]++;
+
+            if ((topRetainers == 0) || (slaves == 0))
+            {
+                return false;
+            }
+
+            /*
+             * Retainers are kept in min heap of the largest ones.
+             */
+            if (heap.retainers.size() < topRetainers)
+            {
+                heap.retainers.push_back(Retainer{o, type, o->getId(), slaves});
+                std::push_heap(heap.retainers.begin(), heap.retainers.end(), smaller);
+            }
+            else if (heap.retainers.front().slaves < slaves)
+            {
+                std::pop_heap(heap.retainers.begin(), heap.retainers.end(), smaller);
+                heap.retainers.back() = Retainer{o, type, o->getId(), slaves};
+                std::push_heap(heap.retainers.begin(), heap.retainers.end(), smaller);
+            }
+
+            return false;
+        });
+
+        if (stats.objects == 0)
+        {
+            return;
+        }
+
+        heap.objects += stats.objects;
+        heap.bytes += stats.bytes;
+        heap.marked += stats.marked;
+        heap.types.push_back(stats);
+    });
+
+    std::sort_heap(heap.retainers.begin(), heap.retainers.end(), smaller);
+
+    return heap;
+}
+
+/**
+ * Write all objects and their master relationships to binary file.
+ *
+ * @param path - file path.
+ * @return true if written, otherwise false.
+ */
+bool
+ORM::dumpHeap(const std::string &path)
+{
+    FILE *fp = fopen(path.c_str(), "wb");
+
+    if (!fp)
+    {
+        return false;
+    }
+
+    ORM::Lock lock;
+    std::string buffer;
+    BinaryWriter writer(buffer);
+    uint64_t count = 0;
+    bool ok = true;
+
+    writer.putU32(HEAP_DUMP_MAGIC);
+    writer.putU32(HEAP_DUMP_VERSION);
+
+    /*
+     * Object count is written when known.
+     */
+    writer.putU64(0);
+
+    ORM::forEachRepository([&](eObjectType type, ObjectRepository *repository) {
+        repository->scan([&](Object *o) {
+            uint32_t relationships = 0;
+
+            o->getMaster()->forEach([&](Relationship *r) {
+                (void) r;
+                relationships++;
+            });
+
+            writer.putU64(reinterpret_cast<uintptr_t>(o));
+            writer.putU32(type);
+            writer.putString(o->getId());
+            writer.putU8((o->getMarked() ? HEAP_DUMP_MARKED : 0) | (o->isFrozen() ? HEAP_DUMP_FROZEN : 0));
+            writer.putU64(o->getFootprint());
+            writer.putU32(relationships);
+
+            o->getMaster()->forEach([&](Relationship *r) {
+                writer.putString(r->getName());
+                writer.putU8(r->getType());
+                writer.putU32(static_cast<uint32_t>(r->size()));
+
+                for (Object *slave : *r)
+                {
+                    writer.putU64(reinterpret_cast<uintptr_t>(slave));
+                }
+            });
+
+            count++;
+
+            if (buffer.size() >= HEAP_DUMP_FLUSH_SIZE)
+            {
+                ok = ok && (fwrite(buffer.data(), 1, buffer.size(), fp) == buffer.size());
+                buffer.clear();
+            }
+
+            return false;
+        });
+    });
+
+    ok = ok && (fwrite(buffer.data(), 1, buffer.size(), fp) == buffer.size());
+
+    /*
+     * Count follows magic and version.
+     */
+    buffer.clear();
+    writer.putU64(count);
+
+    ok = ok && (fseek(fp, 2 * sizeof(uint32_t), SEEK_SET) == 0);
+    ok = ok && (fwrite(buffer.data(), 1, buffer.size(), fp) == buffer.size());
+    ok = (fclose(fp) == 0) && ok;
+
+    return ok;
+}
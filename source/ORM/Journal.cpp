@@ -0,0 +1,103 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <ORM/Journal.h>
+
+/**
+ * @brief journal - attached journal, nullptr if none.
+ */
+static Journal *journal;
+
+/**
+ * @brief depth - number of journaled operations in progress on this thread.
+ */
+static thread_local size_t depth;
+
+/**
+ * Attach journal.
+ *
+ * @param j - journal, nullptr to detach.
+ */
+void
+ORM::setJournal(Journal *j)
+{
+    journal = j;
+}
+
+/**
+ * Get attached journal.
+ *
+ * @return journal if attached, otherwise nullptr.
+ */
+Journal *
+ORM::getJournal()
+{
+    return journal;
+}
+
+/**
+ * The constructor.
+ */
+ORM::JournalScope::JournalScope()
+{
+    this->journal = ::journal;
+    this->nested = false;
+
+    if (this->journal)
+    {
+        this->nested = depth++ > 0;
+    }
+}
+
+/**
+ * The destructor.
+ */
+ORM::JournalScope::~JournalScope()
+{
+    if (this->journal)
+    {
+        depth--;
+    }
+}
+
+/**
+ * Get journal attached when scope was entered.
+ *
+ * @return journal if attached, otherwise nullptr.
+ */
+Journal *
+ORM::JournalScope::getJournal()
+{
+    return this->journal;
+}
+
+/**
+ * Check if scope is inside another journaled operation.
+ *
+ * @return true if nested, otherwise false.
+ */
+bool
+ORM::JournalScope::isNested()
+{
+    return this->nested;
+}
@@ -20,7 +20,11 @@
  * THE SOFTWARE.
  */
 
+#include <ORM/ORM.h>
 #include <ORM/MasterRelationships.h>
+#include <ORM/Concurrency.h>
+#include <ORM/Journal.h>
+#include <ORM/Transaction.h>
 #include <ORM/SlaveRelationships.h>
 #include <ORM/Relationship.h>
 #include <ORM/Object.h>
@@ -33,35 +37,58 @@ MasterRelationships::MasterRelationships(Object *self) : Relationships(self)
 void
 MasterRelationships::clearObjects()
 {
-    for (auto &relationship : this->relationships)
+    ORM::Lock lock;
+    ORM::JournalScope scope;
+
+    /*
+     * Object being destroyed is let go even if claimed elsewhere.
+     */
+    if (ORM::checkFrozen(self) || (!self->getMarked() && !this->claimObjects(nullptr)))
+    {
+        return;
+    }
+
+    if (scope.getJournal())
     {
-        Relationship *r = relationship.second.get();
+        scope.getJournal()->onClear(self, nullptr, scope.isNested());
+    }
 
+    this->forEach([&](Relationship *r) {
         while (!r->empty())
         {
             Object *e = r->front();
 
             r->removeObject(e);
+            ORM::logRemove(self, r->getName(), e);
             e->getSlave()->remove(r->getName(), self);
         }
-    }
+    });
 }
 
 void
 MasterRelationships::clearObjects(std::string relationshipName)
 {
-    Relationship *r = this->get(std::move(relationshipName));
+    ORM::Lock lock;
+    ORM::JournalScope scope;
 
-    if (!r)
+    Relationship *r = this->find(relationshipName);
+
+    if (!r || ORM::checkFrozen(self) || !this->claimObjects(r))
     {
         return;
     }
 
+    if (scope.getJournal())
+    {
+        scope.getJournal()->onClear(self, r, scope.isNested());
+    }
+
     while (!r->empty())
     {
         Object *e = r->front();
 
         r->removeObject(e);
+        ORM::logRemove(self, r->getName(), e);
         e->getSlave()->remove(r->getName(), self);
     }
 }
@@ -69,6 +96,14 @@ MasterRelationships::clearObjects(std::string relationshipName)
 void
 MasterRelationships::add(std::string relationshipName, Object *o)
 {
+    ORM::Lock lock;
+    ORM::JournalScope scope;
+
+    if (ORM::checkFrozen(self))
+    {
+        return;
+    }
+
     Relationship *r = this->get(relationshipName);
 
     if (!r)
@@ -77,8 +112,22 @@ MasterRelationships::add(std::string relationshipName, Object *o)
         return;
     }
 
+    if (!ORM::claim(self, o))
+    {
+        return;
+    }
+
+    size_t count = r->size();
     r->addObject(o);
 
+    /*
+     * Refused object is not bound to this master either.
+     */
+    if (r->size() == count)
+    {
+        return;
+    }
+
     switch (r->getType())
     {
         case ONE_TO_MANY:
@@ -91,13 +140,76 @@ MasterRelationships::add(std::string relationshipName, Object *o)
             return;
     }
 
+    ORM::logAdd(self, relationshipName, o);
     o->getSlave()->add(std::move(relationshipName), self);
+
+    if (scope.getJournal())
+    {
+        scope.getJournal()->onAdd(self, r, o, scope.isNested());
+    }
+}
+
+/**
+ * Add many objects to relationship, relationship is looked up
+ * and its storage reserved once.
+ *
+ * @param relationshipName
+ * @param objects
+ */
+void
+MasterRelationships::addMany(const std::string &relationshipName, const std::vector<Object *> &objects)
+{
+    ORM::Lock lock;
+    ORM::JournalScope scope;
+
+    if (ORM::checkFrozen(self))
+    {
+        return;
+    }
+
+    Relationship *r = this->get(relationshipName);
+
+    if (!r)
+    {
+        ERROR_LOG_ADD(ERROR_ENTITY_UNKNOWN_RELATIONSHIP);
+        return;
+    }
+
+    r->reserve(objects.size());
+
+    for (Object *o : objects)
+    {
+        if (!o || !ORM::claim(self, o))
+        {
+            continue;
+        }
+
+        size_t count = r->size();
+        r->addObject(o);
+
+        if (r->size() == count)
+        {
+            continue;
+        }
+
+        o->getSlave()->init(relationshipName, r->getType());
+        ORM::logAdd(self, relationshipName, o);
+        o->getSlave()->add(relationshipName, self);
+
+        if (scope.getJournal())
+        {
+            scope.getJournal()->onAdd(self, r, o, scope.isNested());
+        }
+    }
 }
 
 void
 MasterRelationships::remove(std::string relationshipName, Object *o)
 {
-    Relationship *r = this->get(std::move(relationshipName));
+    ORM::Lock lock;
+    ORM::JournalScope scope;
+
+    Relationship *r = this->find(relationshipName);
 
     if (!r)
     {
@@ -109,10 +221,61 @@ MasterRelationships::remove(std::string relationshipName, Object *o)
         return;
     }
 
+    /*
+     * Slave being destroyed is still let go.
+     */
+    if (!o->getMarked() && (ORM::checkFrozen(self) || !ORM::claim(self, o)))
+    {
+        return;
+    }
+
+    if (scope.getJournal())
+    {
+        scope.getJournal()->onRemove(self, r, o, scope.isNested());
+    }
+
+    size_t count = r->size();
     r->removeObject(o);
+
+    if (r->size() == count)
+    {
+        return;
+    }
+
+    ORM::logRemove(self, r->getName(), o);
     o->getSlave()->remove(r->getName(), self);
 }
 
+/**
+ * Claim this object and its slaves for transaction about to clear them.
+ *
+ * @param r - relationship to clear, nullptr for all of them.
+ * @return true if all are claimed, otherwise false.
+ */
+bool
+MasterRelationships::claimObjects(Relationship *r)
+{
+    bool claimed = ORM::claim(self, nullptr);
+
+    auto claimSlaves = [&](Relationship *relationship) {
+        for (Object *e : *relationship)
+        {
+            claimed = claimed && ORM::claim(e, nullptr);
+        }
+    };
+
+    if (r)
+    {
+        claimSlaves(r);
+    }
+    else
+    {
+        this->forEach(claimSlaves);
+    }
+
+    return claimed;
+}
+
 MasterRelationships::~MasterRelationships()
 {
     this->clearObjects();
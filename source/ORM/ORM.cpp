@@ -20,10 +20,20 @@
  * THE SOFTWARE.
  */
 
+#include <atomic>
+#include <mutex>
 #include <utility>
+#include <vector>
 
 #include "ORM/ORM.h"
 #include "ORM/Object.h"
+#include "ORM/Relationship.h"
+#include "ORM/MasterRelationships.h"
+#include "ORM/Concurrency.h"
+#include "ORM/Journal.h"
+#include "ORM/SweepPool.h"
+#include "ORM/Transaction.h"
+#include "ErrorBundle/ErrorLog.h"
 
 using ObjectRepositoryPtr = std::unique_ptr<ObjectRepository>;
 
@@ -32,6 +42,115 @@ using ObjectRepositoryPtr = std::unique_ptr<ObjectRepository>;
  */
 static std::map<eObjectType, ObjectRepositoryPtr> repo;
 
+/**
+ * @brief repoMutex - guards repository map in concurrent mode.
+ */
+static std::recursive_mutex repoMutex;
+
+/**
+ * @brief repoSlots - repositories of built in types, indexed by type.
+ */
+static std::atomic<ObjectRepository *> repoSlots[OBJECT_TYPE_COUNT];
+
+/**
+ * @brief frozenViolations - refused mutations of frozen objects.
+ */
+static std::atomic<size_t> frozenViolations(0);
+
+/**
+ * @brief singletons - direct access slots of well known objects, indexed by type.
+ */
+static std::atomic<Object *> singletons[OBJECT_TYPE_COUNT];
+
+/**
+ * @brief singletonTypes - types that registered a singleton, only these are cached.
+ */
+static std::atomic<bool> singletonTypes[OBJECT_TYPE_COUNT];
+
+using RepoLock = std::unique_lock<std::recursive_mutex>;
+
+/**
+ * Lock repository map if ORM runs in concurrent mode.
+ *
+ * @return lock.
+ */
+static RepoLock
+lockRepo()
+{
+    RepoLock lock(repoMutex, std::defer_lock);
+
+    if (ORM::isConcurrent())
+    {
+        lock.lock();
+    }
+
+    return lock;
+}
+
+/**
+ * Count and report refused write to frozen data.
+ */
+static void
+refuseFrozen()
+{
+    frozenViolations++;
+    ERROR_LOG_ADD(ERROR_ENTITY_WRITING_FROZEN);
+}
+
+/**
+ * Release singleton slot of object.
+ *
+ * @param o - the object.
+ */
+static void
+releaseSingleton(Object *o)
+{
+    if (o->getObjectType() < OBJECT_TYPE_COUNT)
+    {
+        Object *expected = o;
+
+        singletons[o->getObjectType()].compare_exchange_strong(expected, nullptr);
+    }
+}
+
+/**
+ * Get first object of type that is not marked for sweep.
+ *
+ * @param type - object type.
+ * @return object if exists, otherwise nullptr.
+ */
+static Object *
+findUnmarked(eObjectType type)
+{
+    ObjectRepository *repository = ORM::findObjectRepository(type);
+
+    if (!repository)
+    {
+        return nullptr;
+    }
+
+    return repository->find([](Object *e) {
+        return !e->getMarked();
+    });
+}
+
+/**
+ * Release singleton slots that are about to be swept.
+ */
+static void
+releaseMarkedSingletons()
+{
+    for (auto &singleton : singletons)
+    {
+        Object *o = singleton.load();
+
+        if (o && o->getMarked())
+        {
+            singleton.store(nullptr);
+        }
+    }
+}
+
 /**
  * Find object repository.
  *
@@ -41,6 +160,12 @@ static std::map<eObjectType, ObjectRepositoryPtr> repo;
 ObjectRepository *
 ORM::findObjectRepository(eObjectType type)
 {
+    if (type < OBJECT_TYPE_COUNT)
+    {
+        return repoSlots[type].load();
+    }
+
+    RepoLock lock = lockRepo();
     auto it = repo.find(type);
 
     return (it != repo.end()) ? (it->second).get() : nullptr;
@@ -54,19 +179,29 @@ ORM::findObjectRepository(eObjectType type)
 void
 ORM::addObjectRepository(eObjectType type)
 {
+    RepoLock lock = lockRepo();
+
     if (ORM::findObjectRepository(type))
     {
         return;
     }
 
-    repo[type] = ObjectRepositoryPtr(new ObjectRepository());
+    size_t shards = ORM::isConcurrent() ? ORM_REPOSITORY_SHARDS : 1;
+
+    repo[type] = ObjectRepositoryPtr(new ObjectRepository(shards));
+
+    if (type < OBJECT_TYPE_COUNT)
+    {
+        repoSlots[type].store(repo[type].get());
+    }
 }
 
 /**
- * Add new object to repository.
+ * Add new object to repository. Object refused by frozen
+ * repository is deleted, every factory is checked here.
  *
  * @param o - object.
- * @return the object.
+ * @return the object, or nullptr if refused.
  */
 Object *
 ORM::create(Object *o)
@@ -84,10 +219,86 @@ ORM::create(Object *o)
         repository = ORM::findObjectRepository(o->getObjectType());
     }
 
+    if (repository->isFrozen())
+    {
+        refuseFrozen();
+        delete o;
+        return nullptr;
+    }
+
     repository->add(o);
+    ORM::logCreate(o);
+
+    if (Journal *journal = ORM::getJournal())
+    {
+        journal->onCreate(o);
+    }
+
     return o;
 }
 
+/**
+ * Add many new objects to their repositories. Repository is looked up
+ * and its storage reserved once per run of objects of same type.
+ * Objects refused by frozen repository are deleted and set to nullptr.
+ *
+ * @param objects - new objects.
+ */
+void
+ORM::createMany(std::vector<Object *> &objects)
+{
+    ObjectRepository *repository = nullptr;
+    eObjectType type = OBJECT_TYPE_COUNT;
+    Journal *journal = ORM::getJournal();
+
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        Object *o = objects[i];
+
+        if (!o)
+        {
+            continue;
+        }
+
+        if (!repository || (o->getObjectType() != type))
+        {
+            type = o->getObjectType();
+            repository = ORM::findObjectRepository(type);
+
+            if (!repository)
+            {
+                ORM::addObjectRepository(type);
+                repository = ORM::findObjectRepository(type);
+            }
+
+            size_t run = 1;
+
+            while ((i + run < objects.size()) && objects[i + run] && (objects[i + run]->getObjectType() == type))
+            {
+                run++;
+            }
+
+            repository->reserve(run);
+        }
+
+        if (repository->isFrozen())
+        {
+            refuseFrozen();
+            delete o;
+            objects[i] = nullptr;
+            continue;
+        }
+
+        repository->add(o);
+        ORM::logCreate(o);
+
+        if (journal)
+        {
+            journal->onCreate(o);
+        }
+    }
+}
+
 /**
  * Change object ID.
  *
@@ -97,7 +308,7 @@ ORM::create(Object *o)
 void
 ORM::changeId(Object *o, std::string new_id)
 {
-    if (!o)
+    if (!o || ORM::checkFrozen(o) || !ORM::claim(o, nullptr))
     {
         return;
     }
@@ -110,7 +321,15 @@ ORM::changeId(Object *o, std::string new_id)
         repository = ORM::findObjectRepository(o->getObjectType());
     }
 
+    std::string oldId = o->getId();
+
     repository->changeId(o, new_id);
+    ORM::logChangeId(o, oldId);
+
+    if (Journal *journal = ORM::getJournal())
+    {
+        journal->onChangeId(o, new_id);
+    }
 }
 
 /**
@@ -122,6 +341,11 @@ ORM::changeId(Object *o, std::string new_id)
 void
 ORM::destroy(Object *o)
 {
+    if (ORM::checkFrozen(o) || ORM::deferDestroy(o))
+    {
+        return;
+    }
+
     ObjectRepository *repository = ORM::findObjectRepository(o->getObjectType());
 
     if (!repository)
@@ -129,19 +353,122 @@ ORM::destroy(Object *o)
         return;
     }
 
+    ORM::Lock lock;
+    ORM::JournalScope scope;
+
+    if (scope.getJournal() && !scope.isNested())
+    {
+        scope.getJournal()->onDestroy(o);
+    }
+
+    releaseSingleton(o);
     repository->remove(o);
     ORM::sweep();
 }
 
+/**
+ * Destroy many objects and all their relationships, then sweep once.
+ *
+ * @param objects - objects to destroy.
+ */
+void
+ORM::destroyMany(const std::vector<Object *> &objects)
+{
+    ORM::Lock lock;
+    ORM::JournalScope scope;
+    ObjectRepository *repository = nullptr;
+    eObjectType type = OBJECT_TYPE_COUNT;
+
+    for (Object *o : objects)
+    {
+        if (!o || o->getMarked() || ORM::checkFrozen(o) || ORM::deferDestroy(o))
+        {
+            continue;
+        }
+
+        if (!repository || (o->getObjectType() != type))
+        {
+            type = o->getObjectType();
+            repository = ORM::findObjectRepository(type);
+        }
+
+        if (!repository)
+        {
+            continue;
+        }
+
+        if (scope.getJournal() && !scope.isNested())
+        {
+            scope.getJournal()->onDestroy(o);
+        }
+
+        releaseSingleton(o);
+        repository->remove(o);
+    }
+
+    ORM::sweep();
+}
+
 /**
  * Sweep all objects from all repositories.
  */
 void
 ORM::sweep()
 {
-    for (auto &it : repo)
+    /*
+     * Objects are freed only here, slots must not outlive them.
+     */
+    ORM::Lock lock;
+    ORM::JournalScope scope;
+
+    releaseMarkedSingletons();
+
+    std::vector<ObjectRepository *> repositories;
+    std::vector<std::vector<ObjectPtr>> swept;
+
     {
-        it.second->sweep();
+        RepoLock repoLock = lockRepo();
+
+        for (auto &it : repo)
+        {
+            repositories.push_back(it.second.get());
+        }
+
+        /*
+         * One task per repository, graph lock held here keeps
+         * the graph still while workers collect.
+         */
+        swept.resize(repositories.size());
+
+        ORM::parallelFor(repositories.size(), [&](size_t i) {
+            repositories[i]->collect(swept[i]);
+        });
+    }
+
+    for (auto &objects : swept)
+    {
+        if (scope.getJournal())
+        {
+            for (auto &op : objects)
+            {
+                scope.getJournal()->onRelease(op.get());
+            }
+        }
+
+        /*
+         * Other threads may still hold swept objects.
+         */
+        if (ORM::isConcurrent())
+        {
+            ORM::retire(objects);
+        }
+    }
+
+    swept.clear();
+
+    if (ORM::isConcurrent())
+    {
+        ORM::reclaim();
     }
 }
 
@@ -207,6 +534,80 @@ ORM::getFirst(eObjectType type)
     });
 }
 
+/**
+ * Get well known object of a type without repository lookup.
+ * Only types that registered a singleton are cached, first object of
+ * such type is taken if its slot is empty. Marked objects are skipped.
+ *
+ * @param type - object type.
+ * @return singleton if exists, otherwise nullptr.
+ */
+Object *
+ORM::getSingleton(eObjectType type)
+{
+    if ((type >= OBJECT_TYPE_COUNT) || !singletonTypes[type].load())
+    {
+        return findUnmarked(type);
+    }
+
+    Object *o = singletons[type].load();
+
+    if (o && o->getMarked())
+    {
+        singletons[type].compare_exchange_strong(o, nullptr);
+        o = nullptr;
+    }
+
+    if (!o)
+    {
+        o = findUnmarked(type);
+
+        if (o)
+        {
+            Object *expected = nullptr;
+
+            if (!singletons[type].compare_exchange_strong(expected, o))
+            {
+                o = expected;
+            }
+        }
+    }
+
+    return o;
+}
+
+/**
+ * Register object as singleton of its type if there is none.
+ *
+ * @param o - the object.
+ */
+void
+ORM::registerSingleton(Object *o)
+{
+    if (!o || o->getObjectType() >= OBJECT_TYPE_COUNT)
+    {
+        return;
+    }
+
+    Object *expected = nullptr;
+
+    singletonTypes[o->getObjectType()].store(true);
+    singletons[o->getObjectType()].compare_exchange_strong(expected, o);
+}
+
+/**
+ * Check if object is registered singleton of its type.
+ * Singleton is never orphaned, only destroyed explicitly.
+ *
+ * @param o - the object.
+ * @return true if singleton, otherwise false.
+ */
+bool
+ORM::isSingleton(Object *o)
+{
+    return (o->getObjectType() < OBJECT_TYPE_COUNT) && (singletons[o->getObjectType()].load() == o);
+}
+
 /**
  * Remove object repository.
  *
@@ -215,10 +616,17 @@ ORM::getFirst(eObjectType type)
 void
 ORM::removeObjectRepository(eObjectType type)
 {
+    RepoLock lock = lockRepo();
     auto it = repo.find(type);
 
     if (it != repo.end())
     {
+        if (type < OBJECT_TYPE_COUNT)
+        {
+            singletons[type].store(nullptr);
+            repoSlots[type].store(nullptr);
+        }
+
         repo.erase(it);
     }
 }
@@ -229,5 +637,177 @@ ORM::removeObjectRepository(eObjectType type)
 void
 ORM::removeAllRepositories()
 {
+    RepoLock lock = lockRepo();
+
+    for (auto &singleton : singletons)
+    {
+        singleton.store(nullptr);
+    }
+
+    for (auto &slot : repoSlots)
+    {
+        slot.store(nullptr);
+    }
+
+    /*
+     * Frozen objects may be slaves of objects in other repositories.
+     */
+    for (auto &it : repo)
+    {
+        it.second->thaw();
+    }
+
     repo.clear();
 }
+
+/**
+ * Call function for each repository.
+ *
+ * @param func - function taking object type and repository.
+ */
+void
+ORM::forEachRepository(const std::function<void(eObjectType, ObjectRepository *)> &func)
+{
+    RepoLock lock = lockRepo();
+
+    for (auto &it : repo)
+    {
+        func(it.first, it.second.get());
+    }
+}
+
+/**
+ * Freeze repository and everything its objects hold.
+ * Marked objects are swept first.
+ *
+ * @param type - object type.
+ * @return true if frozen, otherwise false.
+ */
+bool
+ORM::freeze(eObjectType type)
+{
+    ObjectRepository *repository = ORM::findObjectRepository(type);
+
+    if (!repository)
+    {
+        return false;
+    }
+
+    ORM::Lock lock;
+    ORM::sweep();
+
+    bool freezable = !repository->scan([&](Object *o) {
+        return !o->isFreezable();
+    });
+
+    if (!freezable)
+    {
+        return false;
+    }
+
+    repository->scan([&](Object *o) {
+        ORM::freeze(o);
+        return false;
+    });
+
+    repository->freeze();
+
+    return true;
+}
+
+/**
+ * Freeze object and all objects reachable through its master
+ * relationships. Frozen object is never marked nor swept, its master
+ * relationships are compacted and can be read without locks.
+ * Objects that are not freezable, and objects they hold, are skipped.
+ *
+ * @param root - the object.
+ * @return true if frozen, otherwise false.
+ */
+bool
+ORM::freeze(Object *root)
+{
+    if (!root || root->getMarked() || !root->isFreezable())
+    {
+        return false;
+    }
+
+    ORM::Lock lock;
+    std::vector<Object *> pending;
+
+    pending.push_back(root);
+
+    while (!pending.empty())
+    {
+        Object *o = pending.back();
+        pending.pop_back();
+
+        if (o->isFrozen() || o->getMarked() || !o->isFreezable())
+        {
+            continue;
+        }
+
+        o->setFrozen(true);
+        o->getMaster()->forEach([&](Relationship *r) {
+            r->shrink();
+
+            for (Object *slave : *r)
+            {
+                pending.push_back(slave);
+            }
+        });
+    }
+
+    return true;
+}
+
+/**
+ * Check object before mutation, mutation of frozen object is
+ * refused, counted and reported.
+ *
+ * @param o - the object.
+ * @return true if frozen, otherwise false.
+ */
+bool
+ORM::checkFrozen(Object *o)
+{
+    if (!o || !o->isFrozen())
+    {
+        return false;
+    }
+
+    refuseFrozen();
+    return true;
+}
+
+/**
+ * Check repository before object of its type is built, creation
+ * in frozen repository is refused, counted and reported.
+ *
+ * @param type - object type.
+ * @return true if object can be created, otherwise false.
+ */
+bool
+ORM::canCreate(eObjectType type)
+{
+    ObjectRepository *repository = ORM::findObjectRepository(type);
+
+    if (!repository || !repository->isFrozen())
+    {
+        return true;
+    }
+
+    refuseFrozen();
+    return false;
+}
+
+/**
+ * Get number of refused mutations of frozen objects.
+ *
+ * @return number of refused mutations.
+ */
+size_t
+ORM::getFrozenViolations()
+{
+    return frozenViolations.load();
+}
@@ -21,6 +21,8 @@
  */
 
 #include <ORM/Object.h>
+#include <ORM/Handle.h>
+#include <ORM/ObjectPool.h>
 #include <ORM/Relationship.h>
 #include <ErrorBundle/ErrorLog.h>
 #include <sstream>
@@ -32,13 +34,12 @@
  * @param type
  * @param id
  */
-Object::Object(const uint64_t id)
+Object::Object(const uint64_t id) : masterRelationships(this), slaveRelationships(this)
 {
     this->marked = false;
+    this->frozen = false;
+    this->handleIndex = 0;
     this->id = std::to_string(id);
-
-    this->masterRelationshipsPtr = MasterRelationshipsPtr(new MasterRelationships(this));
-    this->slaveRelationshipsPtr = SlaveRelationshipsPtr(new SlaveRelationships(this));
 }
 
 /**
@@ -47,13 +48,12 @@ Object::Object(const uint64_t id)
  * @param type
  * @param id
  */
-Object::Object(std::string id)
+Object::Object(std::string id) : masterRelationships(this), slaveRelationships(this)
 {
     this->marked = false;
+    this->frozen = false;
+    this->handleIndex = 0;
     this->id = std::move(id);
-
-    this->masterRelationshipsPtr = MasterRelationshipsPtr(new MasterRelationships(this));
-    this->slaveRelationshipsPtr = SlaveRelationshipsPtr(new SlaveRelationships(this));
 }
 
 /**
@@ -100,6 +100,51 @@ Object::setMarked(bool marked)
     this->marked = marked;
 }
 
+/**
+ * Check if object is frozen.
+ *
+ * @return true if frozen, otherwise false.
+ */
+bool
+Object::isFrozen()
+{
+    return this->frozen;
+}
+
+/**
+ * Set frozen.
+ *
+ * @param frozen
+ */
+void
+Object::setFrozen(bool frozen)
+{
+    this->frozen = frozen;
+}
+
+/**
+ * Check if object may be frozen.
+ *
+ * @return true by default.
+ */
+bool
+Object::isFreezable()
+{
+    return true;
+}
+
+/**
+ * Get number of bytes held by object.
+ *
+ * @return number of bytes.
+ */
+size_t
+Object::getFootprint()
+{
+    return sizeof(Object) + this->id.capacity() +
+           this->masterRelationships.getFootprint() + this->slaveRelationships.getFootprint();
+}
+
 /**
  * Get master relationships.
  *
@@ -108,7 +153,7 @@ Object::setMarked(bool marked)
 MasterRelationships *
 Object::getMaster()
 {
-    return this->masterRelationshipsPtr.get();
+    return &this->masterRelationships;
 }
 
 /**
@@ -119,5 +164,71 @@ Object::getMaster()
 SlaveRelationships *
 Object::getSlave()
 {
-    return this->slaveRelationshipsPtr.get();
-}
\ No newline at end of file
+    return &this->slaveRelationships;
+}
+
+/**
+ * Check if destructor has side effects visible outside of ORM,
+ * such objects are always destroyed by the sweeping thread.
+ *
+ * @return false by default.
+ */
+bool
+Object::hasObservableDestructor()
+{
+    return false;
+}
+
+/**
+ * Get index of handle table slot.
+ *
+ * @return slot index, 0 if object has no handle.
+ */
+uint32_t
+Object::getHandleIndex()
+{
+    return this->handleIndex.load(std::memory_order_acquire);
+}
+
+/**
+ * Set index of handle table slot.
+ *
+ * @param index
+ */
+void
+Object::setHandleIndex(uint32_t index)
+{
+    this->handleIndex.store(index, std::memory_order_release);
+}
+
+/**
+ * Allocate object from object pool.
+ *
+ * @param size - object size.
+ * @return storage.
+ */
+void *
+Object::operator new(size_t size)
+{
+    return ObjectPool::allocate(size);
+}
+
+/**
+ * Return object storage to object pool.
+ *
+ * @param p - storage.
+ * @param size - object size.
+ */
+void
+Object::operator delete(void *p, size_t size)
+{
+    ObjectPool::release(p, size);
+}
+
+/**
+ * The destructor, handles of object become stale.
+ */
+Object::~Object()
+{
+    ORM::releaseHandle(this);
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <ORM/ObjectPool.h>
+#include <atomic>
+#include <mutex>
+#include <new>
+
+#define OBJECT_POOL_CLASSES (OBJECT_POOL_MAX_SIZE / OBJECT_POOL_GRANULARITY)
+
+/*
+ * Free slot, linked through its own storage.
+ */
+struct FreeSlot {
+    FreeSlot *next;
+};
+
+/*
+ * Plain arrays, pools outlive repositories released at exit.
+ */
+static FreeSlot *freeSlots[OBJECT_POOL_CLASSES];
+static size_t freeCount[OBJECT_POOL_CLASSES];
+static std::mutex poolMutex[OBJECT_POOL_CLASSES];
+static std::atomic<bool> concurrent(false);
+
+/**
+ * Get pool class of object size.
+ *
+ * @param size - object size.
+ * @return pool class.
+ */
+static inline size_t
+poolClass(size_t size)
+{
+    return (size - 1) / OBJECT_POOL_GRANULARITY;
+}
+
+/**
+ * Allocate slab of slots and put them on free list.
+ *
+ * @param c - pool class.
+ */
+static void
+grow(size_t c)
+{
+    size_t slotSize = (c + 1) * OBJECT_POOL_GRANULARITY;
+    auto *slab = (char *) ::operator new(slotSize * OBJECT_POOL_SLAB_SLOTS);
+
+    for (size_t i = OBJECT_POOL_SLAB_SLOTS; i > 0; i--)
+    {
+        auto *slot = (FreeSlot *) (slab + (i - 1) * slotSize);
+
+        slot->next = freeSlots[c];
+        freeSlots[c] = slot;
+    }
+
+    freeCount[c] += OBJECT_POOL_SLAB_SLOTS;
+}
+
+/**
+ * Allocate object storage.
+ *
+ * @param size - object size.
+ * @return storage.
+ */
+void *
+ObjectPool::allocate(size_t size)
+{
+    if ((size == 0) || (size > OBJECT_POOL_MAX_SIZE))
+    {
+        return ::operator new(size);
+    }
+
+    size_t c = poolClass(size);
+    std::unique_lock<std::mutex> lock(poolMutex[c], std::defer_lock);
+
+    if (concurrent.load(std::memory_order_relaxed))
+    {
+        lock.lock();
+    }
+
+    if (!freeSlots[c])
+    {
+        grow(c);
+    }
+
+    FreeSlot *slot = freeSlots[c];
+
+    freeSlots[c] = slot->next;
+    freeCount[c]--;
+
+    return slot;
+}
+
+/**
+ * Release object storage back to its pool.
+ *
+ * @param p - storage.
+ * @param size - object size.
+ */
+void
+ObjectPool::release(void *p, size_t size)
+{
+    if (!p)
+    {
+        return;
+    }
+
+    if ((size == 0) || (size > OBJECT_POOL_MAX_SIZE))
+    {
+        ::operator delete(p);
+        return;
+    }
+
+    size_t c = poolClass(size);
+    auto *slot = (FreeSlot *) p;
+    std::unique_lock<std::mutex> lock(poolMutex[c], std::defer_lock);
+
+    if (concurrent.load(std::memory_order_relaxed))
+    {
+        lock.lock();
+    }
+
+    slot->next = freeSlots[c];
+    freeSlots[c] = slot;
+    freeCount[c]++;
+}
+
+/**
+ * Get number of free slots for object size.
+ *
+ * @param size - object size.
+ * @return number of free slots.
+ */
+size_t
+ObjectPool::getFreeCount(size_t size)
+{
+    if ((size == 0) || (size > OBJECT_POOL_MAX_SIZE))
+    {
+        return 0;
+    }
+
+    size_t c = poolClass(size);
+    std::lock_guard<std::mutex> lock(poolMutex[c]);
+
+    return freeCount[c];
+}
+
+/**
+ * Enable or disable pool locking.
+ *
+ * @param enabled
+ */
+void
+ObjectPool::setConcurrent(bool enabled)
+{
+    concurrent.store(enabled);
+}
@@ -20,11 +20,128 @@
  * THE SOFTWARE.
  */
 
+
 #include <algorithm>
+#include <cstdint>
+#include <iterator>
 #include <ORM/ObjectRepository.h>
 #include <ORM/Object.h>
 #include <ORM/MasterRelationships.h>
 #include <ORM/SlaveRelationships.h>
+#include <ORM/Journal.h>
+#include <ORM/Cascade.h>
+
+using ShardLock = std::unique_lock<std::recursive_mutex>;
+
+/**
+ * Lock shard if ORM runs in concurrent mode.
+ *
+ * @param shard
+ * @return lock.
+ */
+static ShardLock
+lockShard(ObjectRepositoryShard &shard)
+{
+    ShardLock lock(shard.mutex, std::defer_lock);
+
+    if (ORM::isConcurrent())
+    {
+        lock.lock();
+    }
+
+    return lock;
+}
+
+/**
+ * The constructor.
+ *
+ * @param shardCount - number of shards.
+ */
+ObjectRepository::ObjectRepository(size_t shardCount) : indexes(), indexed(false), frozen(false)
+{
+    this->shardCount = (shardCount > 0) ? shardCount : 1;
+    this->shards = std::unique_ptr<ObjectRepositoryShard[]>(new ObjectRepositoryShard[this->shardCount]);
+}
+
+/**
+ * Get shard of object. Objects are placed by address, so objects
+ * sharing an ID, like all values, are spread over shards too.
+ *
+ * @param o - the object.
+ * @return shard.
+ */
+ObjectRepositoryShard &
+ObjectRepository::getShard(Object *o)
+{
+    if (this->shardCount == 1)
+    {
+        return this->shards[0];
+    }
+
+    /*
+     * Fibonacci hashing, low bits of pooled addresses are alike.
+     */
+    uint64_t key = (uint64_t) (uintptr_t) o * 0x9E3779B97F4A7C15ULL;
+
+    return this->shards[(key >> 32) % this->shardCount];
+}
+
+/**
+ * Get shard holding ID index entries of an ID.
+ *
+ * @param id
+ * @return shard.
+ */
+ObjectRepositoryShard &
+ObjectRepository::getShard(const std::string &id)
+{
+    if (this->shardCount == 1)
+    {
+        return this->shards[0];
+    }
+
+    return this->shards[std::hash<std::string>()(id) % this->shardCount];
+}
+
+/**
+ * Append object to ID index under its current ID.
+ *
+ * @param o - the object.
+ */
+void
+ObjectRepository::indexId(Object *o)
+{
+    ObjectRepositoryShard &shard = this->getShard(o->getId());
+    ShardLock lock = lockShard(shard);
+
+    shard.idMap[o->getId()].push_back(o);
+}
+
+/**
+ * Remove object from ID index.
+ *
+ * @param o - the object.
+ * @param id - ID object is indexed under.
+ */
+void
+ObjectRepository::unindexId(Object *o, const std::string &id)
+{
+    ObjectRepositoryShard &shard = this->getShard(id);
+    ShardLock lock = lockShard(shard);
+    auto bucket = shard.idMap.find(id);
+
+    if (bucket == shard.idMap.end())
+    {
+        return;
+    }
+
+    bucket->second.erase(std::remove(bucket->second.begin(), bucket->second.end(), o), bucket->second.end());
+
+    if (bucket->second.empty())
+    {
+        shard.idMap.erase(bucket);
+    }
+}
 
 /**
  * Find object.
@@ -35,30 +152,42 @@
 Object *
 ObjectRepository::find(const std::function<bool(Object *)> &func)
 {
-    if (this->objectMap.empty())
+    if (this->frozen.load(std::memory_order_acquire))
     {
+        for (size_t i = 0; i < this->shardCount; i++)
+        {
+            for (Object *o : this->shards[i].objects)
+            {
+                if (func(o))
+                {
+                    return o;
+                }
+            }
+        }
+
         return nullptr;
     }
 
-    for (auto &it : this->objectMap)
+    for (size_t i = 0; i < this->shardCount; i++)
     {
-        if (it.second.empty())
-        {
-            continue;
-        }
+        ObjectRepositoryShard &shard = this->shards[i];
+        ShardLock lock = lockShard(shard);
 
-        for (const auto &op : it.second)
+        for (auto &it : shard.objectMap)
         {
-            Object *o = op.get();
-
-            if (func(o))
+            for (const auto &op : it.second)
             {
-                if (o->getMarked())
+                Object *o = op.get();
+
+                if (func(o))
                 {
-                    continue;
-                }
+                    if (o->getMarked())
+                    {
+                        continue;
+                    }
 
-                return o;
+                    return o;
+                }
             }
         }
     }
@@ -74,22 +203,62 @@ ObjectRepository::find(const std::function<bool(Object *)> &func)
 void
 ObjectRepository::add(Object *o)
 {
-    if (this->find([&](Object *a) { return a == o; }) != nullptr)
+    ObjectRepositoryShard &shard = this->getShard(o);
+
     {
-        return;
+        ShardLock lock = lockShard(shard);
+        auto &objects = shard.objectMap[o->getId()];
+
+        if (o->getMarked())
+        {
+            o->setMarked(false);
+        }
+
+        /*
+         * Object is always kept under its current ID.
+         */
+        for (const auto &op : objects)
+        {
+            if (op.get() == o)
+            {
+                return;
+            }
+        }
+
+        objects.push_back(ObjectPtr(o));
+        shard.objects.push_back(o);
     }
 
-    if (o->getMarked())
+    this->indexId(o);
+
+    if (this->indexed.load())
     {
-        o->setMarked(false);
+        ORM::Lock lock;
+
+        for (auto &it : this->indexes)
+        {
+            it.second->add(o);
+        }
     }
+}
+
+/**
+ * Reserve storage for objects about to be added.
+ *
+ * @param count - number of objects.
+ */
+void
+ObjectRepository::reserve(size_t count)
+{
+    size_t perShard = count / this->shardCount + 1;
 
-    if (this->objectMap.find(o->getId()) == this->objectMap.end())
+    for (size_t i = 0; i < this->shardCount; i++)
     {
-        this->objectMap[o->getId()] = std::vector<ObjectPtr>();
-    }
+        ObjectRepositoryShard &shard = this->shards[i];
+        ShardLock lock = lockShard(shard);
 
-    this->objectMap[o->getId()].push_back(ObjectPtr(o));
+        shard.objects.reserve(shard.objects.size() + perShard);
+    }
 }
 
 /**
@@ -100,9 +269,11 @@ ObjectRepository::add(Object *o)
 void
 ObjectRepository::remove(Object *o)
 {
+    ORM::Lock lock;
+
     o->setMarked(true);
 
-    o->getMaster()->clearObjects();
+    ORM::cascade(o);
     o->getSlave()->notifyDestroyed();
 }
 
@@ -115,42 +286,68 @@ ObjectRepository::remove(Object *o)
 void
 ObjectRepository::changeId(Object *o, std::string &newId)
 {
-    if (this->objectMap.find(o->getId()) == this->objectMap.end())
+    if (newId == o->getId())
     {
-        /*
-         * ID doesn't exist, create it and init Object.
-         */
-        o->setId(newId);
-        this->add(o);
         return;
     }
 
-    auto &objects = this->objectMap[o->getId()];
-    auto it = std::find_if(objects.begin(), objects.end(), [&](ObjectPtr &op) {
-        return op.get() == o;
-    });
+    std::string oldId = o->getId();
+    ObjectRepositoryShard &shard = this->getShard(o);
+    ShardLock lock = lockShard(shard);
+    auto bucket = shard.objectMap.find(oldId);
+    std::vector<ObjectPtr>::iterator it;
 
-    if (it == objects.end())
+    if (bucket != shard.objectMap.end())
+    {
+        it = std::find_if(bucket->second.begin(), bucket->second.end(), [&](ObjectPtr &op) {
+            return op.get() == o;
+        });
+    }
+
+    if ((bucket == shard.objectMap.end()) || (it == bucket->second.end()))
     {
         /*
          * Object is not inserted. Add Object.
          */
+        if (lock.owns_lock())
+        {
+            lock.unlock();
+        }
+
         o->setId(newId);
         this->add(o);
         return;
     }
 
-    if (this->objectMap.find(newId) == this->objectMap.end())
+    ObjectPtr op = std::move(*it);
+
+    bucket->second.erase(it);
+
+    if (bucket->second.empty())
     {
-        /*
-         * ID doesn't exist, create it.
-         */
-        this->objectMap[newId] = std::vector<ObjectPtr>();
+        shard.objectMap.erase(bucket);
     }
 
-    this->objectMap[newId].push_back(*it);
     o->setId(newId);
-    objects.erase(it);
+    shard.objectMap[newId].push_back(std::move(op));
+
+    if (lock.owns_lock())
+    {
+        lock.unlock();
+    }
+
+    this->unindexId(o, oldId);
+    this->indexId(o);
+
+    if (this->indexed.load())
+    {
+        ORM::Lock lock;
+
+        for (auto &index : this->indexes)
+        {
+            index.second->update(o);
+        }
+    }
 }
 
 /**
@@ -159,22 +356,106 @@ ObjectRepository::changeId(Object *o, std::string &newId)
 void
 ObjectRepository::sweep()
 {
-    for (auto &it : this->objectMap)
+    ORM::Lock graphLock;
+
+    /*
+     * Swept objects are released only after all buckets are visited,
+     * object destructors may still touch the repository.
+     */
+    std::vector<ObjectPtr> swept;
+
+    this->collect(swept);
+
+    if (Journal *journal = ORM::getJournal())
+    {
+        for (auto &op : swept)
+        {
+            journal->onRelease(op.get());
+        }
+    }
+
+    /*
+     * Other threads may still hold swept objects.
+     */
+    if (ORM::isConcurrent())
+    {
+        ORM::retire(swept);
+    }
+}
+
+/**
+ * Take marked objects out of repository and its indexes.
+ * Graph must not change meanwhile, caller holds graph lock.
+ * Repositories may be collected in parallel.
+ *
+ * @param swept - taken objects are appended.
+ */
+void
+ObjectRepository::collect(std::vector<ObjectPtr> &swept)
+{
+    /*
+     * Frozen objects are never marked.
+     */
+    if (this->frozen.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < this->shardCount; i++)
     {
-        auto &objects = it.second;
+        ObjectRepositoryShard &shard = this->shards[i];
+        ShardLock lock = lockShard(shard);
+
+        shard.objects.erase(std::remove_if(shard.objects.begin(), shard.objects.end(), [&](Object *o) {
+            if (!o->getMarked())
+            {
+                return false;
+            }
 
-        while (true)
+            for (auto &it : this->indexes)
+            {
+                it.second->remove(o);
+            }
+
+            return true;
+        }), shard.objects.end());
+
+        for (auto it = shard.objectMap.begin(); it != shard.objectMap.end();)
         {
-            auto it2 = std::find_if(objects.begin(), objects.end(), [&](ObjectPtr &op) {
-                return op->getMarked();
+            auto &objects = it->second;
+            auto marked = std::stable_partition(objects.begin(), objects.end(), [&](ObjectPtr &op) {
+                return !op->getMarked();
             });
 
-            if (it2 == objects.end())
+            std::move(marked, objects.end(), std::back_inserter(swept));
+            objects.erase(marked, objects.end());
+
+            if (objects.empty())
             {
-                break;
+                it = shard.objectMap.erase(it);
             }
+            else
+            {
+                it++;
+            }
+        }
 
-            objects.erase(it2);
+        for (auto it = shard.idMap.begin(); it != shard.idMap.end();)
+        {
+            auto &objects = it->second;
+
+            objects.erase(std::remove_if(objects.begin(), objects.end(), [](Object *o) {
+                return o->getMarked();
+            }), objects.end());
+
+            if (objects.empty())
+            {
+                it = shard.idMap.erase(it);
+            }
+            else
+            {
+                it++;
+            }
         }
     }
 }
@@ -183,36 +464,220 @@ ObjectRepository::sweep()
  * Get object.
  *
  * @param id
- * @return
+ * @return first inserted object of the ID if exists, otherwise nullptr.
  */
 Object *
 ObjectRepository::get(std::string &id)
 {
-    if (this->objectMap.find(id) == this->objectMap.end())
+    if (this->frozen.load(std::memory_order_acquire))
     {
-        return nullptr;
+        return this->getFrozen(id);
     }
 
-    auto &objects = this->objectMap[id];
+    ObjectRepositoryShard &shard = this->getShard(id);
+    ShardLock lock = lockShard(shard);
+    auto it = shard.idMap.find(id);
 
-    return !objects.empty() ? objects[0].get() : nullptr;
+    return ((it != shard.idMap.end()) && !it->second.empty()) ? it->second.front() : nullptr;
 }
 
 /**
- * The destructor.
+ * Get number of objects, including marked ones not swept yet.
+ *
+ * @return number of objects.
  */
-ObjectRepository::~ObjectRepository()
+size_t
+ObjectRepository::size()
+{
+    if (this->frozen.load(std::memory_order_acquire))
+    {
+        return this->frozenObjects.size();
+    }
+
+    size_t count = 0;
+
+    for (size_t i = 0; i < this->shardCount; i++)
+    {
+        ObjectRepositoryShard &shard = this->shards[i];
+        ShardLock lock = lockShard(shard);
+
+        count += shard.objects.size();
+    }
+
+    return count;
+}
+
+/**
+ * Get number of shards.
+ *
+ * @return number of shards.
+ */
+size_t
+ObjectRepository::getShardCount()
+{
+    return this->shardCount;
+}
+
+/**
+ * Get number of objects in shard, including marked ones not swept yet.
+ *
+ * @param index - shard index.
+ * @return number of objects.
+ */
+size_t
+ObjectRepository::getShardSize(size_t index)
+{
+    if (index >= this->shardCount)
+    {
+        return 0;
+    }
+
+    ObjectRepositoryShard &shard = this->shards[index];
+    ShardLock lock = lockShard(shard);
+
+    return shard.objects.size();
+}
+
+/**
+ * Add secondary index. Existing objects are indexed right away.
+ *
+ * @param name - index name.
+ * @param index - the index, repository takes ownership.
+ * @return the index.
+ */
+RepositoryIndex *
+ObjectRepository::addIndex(const std::string &name, RepositoryIndex *index)
+{
+    ORM::Lock lock;
+
+    this->scan([&](Object *o) {
+        index->add(o);
+        return false;
+    });
+
+    this->indexes[name] = RepositoryIndexPtr(index);
+    this->indexed.store(true);
+
+    return index;
+}
+
+/**
+ * Get secondary index.
+ *
+ * @param name - index name.
+ * @return the index if exists, otherwise nullptr.
+ */
+RepositoryIndex *
+ObjectRepository::getIndex(const std::string &name)
 {
-    for (auto &it : this->objectMap)
+    ORM::Lock lock;
+
+    auto it = this->indexes.find(name);
+
+    return it != this->indexes.end() ? it->second.get() : nullptr;
+}
+
+/**
+ * Freeze repository. Objects must be frozen already,
+ * from now on repository is read without locks.
+ */
+void
+ObjectRepository::freeze()
+{
+    if (this->frozen.load())
+    {
+        return;
+    }
+
+    this->frozenObjects.clear();
+
+    for (size_t i = 0; i < this->shardCount; i++)
     {
-        auto &objects = it.second;
+        ObjectRepositoryShard &shard = this->shards[i];
+        ShardLock lock = lockShard(shard);
+
+        /*
+         * Objects of an ID are listed in one shard in insertion order.
+         */
+        for (auto &it : shard.idMap)
+        {
+            for (Object *o : it.second)
+            {
+                this->frozenObjects.emplace_back(it.first, o);
+            }
+        }
+
+        shard.objects.shrink_to_fit();
+    }
+
+    std::stable_sort(this->frozenObjects.begin(), this->frozenObjects.end(), [](const std::pair<std::string, Object *> &a, const std::pair<std::string, Object *> &b) {
+        return a.first < b.first;
+    });
+
+    this->frozenObjects.shrink_to_fit();
+    this->frozen.store(true, std::memory_order_release);
+}
 
-        while (!objects.empty())
+/**
+ * Make repository and its objects mutable again.
+ * No other thread may read repository meanwhile.
+ */
+void
+ObjectRepository::thaw()
+{
+    this->frozen.store(false);
+    this->frozenObjects.clear();
+
+    for (size_t i = 0; i < this->shardCount; i++)
+    {
+        for (Object *o : this->shards[i].objects)
         {
-            auto &object = objects.front();
-            this->remove(object.get());
-            this->sweep();
+            o->setFrozen(false);
         }
     }
 }
 
+/**
+ * Check if repository is frozen.
+ *
+ * @return true if frozen, otherwise false.
+ */
+bool
+ObjectRepository::isFrozen()
+{
+    return this->frozen.load(std::memory_order_acquire);
+}
+
+/**
+ * Get object of frozen repository.
+ *
+ * @param id
+ * @return first object of the ID if exists, otherwise nullptr.
+ */
+Object *
+ObjectRepository::getFrozen(const std::string &id)
+{
+    auto it = std::lower_bound(this->frozenObjects.begin(), this->frozenObjects.end(), id, [](const std::pair<std::string, Object *> &e, const std::string &key) {
+        return e.first < key;
+    });
+
+    return ((it != this->frozenObjects.end()) && (it->first == id)) ? it->second : nullptr;
+}
+
+/**
+ * The destructor.
+ */
+ObjectRepository::~ObjectRepository()
+{
+    this->thaw();
+
+    for (size_t i = 0; i < this->shardCount; i++)
+    {
+        for (Object *o : this->shards[i].objects)
+        {
+            this->remove(o);
+        }
+    }
+
+    this->sweep();
+}
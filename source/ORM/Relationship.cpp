@@ -22,21 +22,271 @@
 
 #include <utility>
 #include <algorithm>
+#include <map>
+#include <mutex>
 
 #include <ORM/Relationship.h>
 #include <ORM/Object.h>
 #include <ErrorBundle/ErrorLog.h>
 
+#define NO_SLOT ((size_t) -1)
+
+/**
+ * The slots constructor.
+ */
+ObjSlots::ObjSlots()
+{
+    this->data = this->local;
+    this->length = 0;
+    this->allocated = RELATIONSHIP_INLINE_OBJECTS;
+}
+
+/**
+ * The slots destructor.
+ */
+ObjSlots::~ObjSlots()
+{
+    if (!this->isInline())
+    {
+        delete[] this->data;
+    }
+}
+
+/**
+ * Append object, growing the buffer if needed.
+ *
+ * @param o - the object.
+ */
+void
+ObjSlots::push_back(Object *o)
+{
+    if (this->length == this->allocated)
+    {
+        this->reallocate(this->allocated * 2);
+    }
+
+    this->data[this->length++] = o;
+}
+
+/**
+ * Drop last slot.
+ */
+void
+ObjSlots::pop_back()
+{
+    this->length--;
+}
+
+/**
+ * Drop slots in range, following slots are moved down.
+ *
+ * @param first - first slot to drop.
+ * @param last - slot past the last one to drop.
+ */
+void
+ObjSlots::erase(Object **first, Object **last)
+{
+    Object **end = this->end();
+
+    std::move(last, end, first);
+    this->length -= (uint32_t) (last - first);
+}
+
+/**
+ * Drop all slots and release the buffer.
+ */
+void
+ObjSlots::clear()
+{
+    this->length = 0;
+    this->reallocate(RELATIONSHIP_INLINE_OBJECTS);
+}
+
+/**
+ * Make room for number of slots.
+ *
+ * @param count - number of slots.
+ */
+void
+ObjSlots::reserve(size_t count)
+{
+    if (count > this->allocated)
+    {
+        this->reallocate(count);
+    }
+}
+
+/**
+ * Release spare capacity, moving back inline if slots fit.
+ */
+void
+ObjSlots::shrink_to_fit()
+{
+    this->reallocate(std::max<size_t>(this->length, RELATIONSHIP_INLINE_OBJECTS));
+}
+
+/**
+ * Move slots to a buffer of given capacity.
+ *
+ * @param count - new capacity, not less than number of slots.
+ */
+void
+ObjSlots::reallocate(size_t count)
+{
+    if (count == this->allocated)
+    {
+        return;
+    }
+
+    Object **buffer = (count <= RELATIONSHIP_INLINE_OBJECTS) ? this->local : new Object *[count];
+
+    if (buffer != this->data)
+    {
+        std::copy(this->data, this->data + this->length, buffer);
+    }
+
+    if (!this->isInline())
+    {
+        delete[] this->data;
+    }
+
+    this->data = buffer;
+    this->allocated = (uint32_t) std::max<size_t>(count, RELATIONSHIP_INLINE_OBJECTS);
+}
+
+/**
+ * The iterator constructor.
+ *
+ * @param slots - relationship slots.
+ * @param pos - first slot to check.
+ */
+Relationship::Iterator::Iterator(const ObjSlots *slots, size_t pos)
+{
+    this->slots = slots;
+    this->pos = pos;
+
+    while (this->pos < this->slots->size() && !(*this->slots)[this->pos])
+    {
+        this->pos++;
+    }
+}
+
+/**
+ * Get current object.
+ *
+ * @return current object.
+ */
+Object *
+Relationship::Iterator::operator*() const
+{
+    return (*this->slots)[this->pos];
+}
+
+/**
+ * Move to next occupied slot.
+ *
+ * @return this iterator.
+ */
+Relationship::Iterator &
+Relationship::Iterator::operator++()
+{
+    do
+    {
+        this->pos++;
+    }
+    while (this->pos < this->slots->size() && !(*this->slots)[this->pos]);
+
+    return *this;
+}
+
+/**
+ * Move to next occupied slot.
+ *
+ * @return iterator before increment.
+ */
+Relationship::Iterator
+Relationship::Iterator::operator++(int)
+{
+    Iterator it = *this;
+    ++(*this);
+
+    return it;
+}
+
+/**
+ * Compare iterators.
+ *
+ * @param it - another iterator.
+ * @return true if equal, otherwise false.
+ */
+bool
+Relationship::Iterator::operator==(const Iterator &it) const
+{
+    return this->slots == it.slots &&
+           std::min(this->pos, this->slots->size()) == std::min(it.pos, it.slots->size());
+}
+
+/**
+ * Compare iterators.
+ *
+ * @param it - another iterator.
+ * @return true if not equal, otherwise false.
+ */
+bool
+Relationship::Iterator::operator!=(const Iterator &it) const
+{
+    return !(*this == it);
+}
+
 /**
  * The constructor.
  *
+ * @param decl - interned relationship declaration.
+ */
+Relationship::Relationship(const RelationshipDecl *decl)
+{
+    this->decl = decl;
+    this->head = 0;
+    this->count = 0;
+}
+
+/**
+ * Get interned declaration of relationship.
+ * Declarations are never freed, threads cache them to avoid the lock.
+ *
  * @param relationshipName - relationship name.
  * @param type - relationship type.
+ * @return declaration.
  */
-Relationship::Relationship(std::string relationshipName, eRelationshipType type)
+const RelationshipDecl *
+Relationship::declare(const std::string &relationshipName, eRelationshipType type)
 {
-    this->name = std::move(relationshipName);
-    this->type = type;
+    using DeclKey = std::pair<std::string, eRelationshipType>;
+    using DeclMap = std::map<DeclKey, const RelationshipDecl *>;
+
+    static std::mutex mutex;
+    static DeclMap declarations;
+    thread_local DeclMap cache;
+
+    DeclKey key(relationshipName, type);
+    auto it = cache.find(key);
+
+    if (it != cache.end())
+    {
+        return it->second;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const RelationshipDecl *&decl = declarations[key];
+
+    if (!decl)
+    {
+        decl = new RelationshipDecl{relationshipName, type};
+    }
+
+    cache[key] = decl;
+
+    return decl;
 }
 
 /**
@@ -44,10 +294,10 @@ Relationship::Relationship(std::string relationshipName, eRelationshipType type)
  *
  * @return relationship name.
  */
-std::string &
+const std::string &
 Relationship::getName()
 {
-    return this->name;
+    return this->decl->name;
 }
 
 /**
@@ -58,7 +308,7 @@ Relationship::getName()
 eRelationshipType
 Relationship::getType()
 {
-    return this->type;
+    return this->decl->type;
 }
 
 /**
@@ -83,7 +333,13 @@ Relationship::find(const std::function<bool(Object *)> &func)
 void
 Relationship::sort(const std::function<bool(Object *, Object *)> &func)
 {
-    std::sort(this->begin(), this->end(), func);
+    this->compact();
+    std::sort(this->slots.begin(), this->slots.end(), func);
+
+    if (this->index)
+    {
+        this->buildIndex();
+    }
 }
 
 /**
@@ -94,28 +350,27 @@ Relationship::sort(const std::function<bool(Object *, Object *)> &func)
 void
 Relationship::forEach(const std::function<eForEachResult(Object *, Object *)> &func)
 {
-    for (auto it1 = this->begin(); it1 != this->end(); it1++)
+    /*
+     * Slots are addressed by position, removing an object during
+     * iteration only empties its slot and never moves the others.
+     */
+    for (size_t it1 = this->nextSlot(this->head); it1 < this->slots.size(); it1 = this->nextSlot(it1 + 1))
     {
-        auto it2 = it1;
-        it2++;
+        size_t it2 = this->nextSlot(it1 + 1);
 
-        while (it2 != this->end())
+        while (it2 < this->slots.size())
         {
-            eForEachResult result = func(*it1, *it2);
+            eForEachResult result = func(this->slots[it1], this->slots[it2]);
 
             switch (result)
             {
                 case FOREACH_CONTINUE:
-                    it1++;
-                    it2++;
-                    break;
-                case FOREACH_IT2_REMOVED:
-                    it2 = it1;
-                    it2++;
-                    break;
                 case FOREACH_IT1_REMOVED:
                     it1 = it2;
-                    it2++;
+                    it2 = this->nextSlot(it2 + 1);
+                    break;
+                case FOREACH_IT2_REMOVED:
+                    it2 = this->nextSlot(it1 + 1);
                     break;
                 default:
                     return;
@@ -132,7 +387,7 @@ Relationship::forEach(const std::function<eForEachResult(Object *, Object *)> &f
 void
 Relationship::addObject(Object *o)
 {
-    if (this->type == ONE_TO_ONE)
+    if (this->decl->type == ONE_TO_ONE)
     {
         if (!this->empty())
         {
@@ -141,8 +396,30 @@ Relationship::addObject(Object *o)
         }
     }
 
-    o->setMarked(false);
-    this->push_back(o);
+    /*
+     * Frozen objects are read without locks, don't write them.
+     */
+    if (o->getMarked())
+    {
+        o->setMarked(false);
+    }
+
+    if (this->slots.size() - this->count > this->count)
+    {
+        this->compact();
+    }
+
+    this->slots.push_back(o);
+    this->count++;
+
+    if (this->index)
+    {
+        this->index->emplace(o, this->slots.size() - 1);
+    }
+    else if (this->slots.size() > RELATIONSHIP_INDEX_THRESHOLD)
+    {
+        this->buildIndex();
+    }
 }
 
 /**
@@ -158,13 +435,30 @@ Relationship::removeObject(Object *o)
         return;
     }
 
-    for (auto it = this->begin(); it != this->end(); it++)
+    size_t pos = this->findSlot(o);
+
+    if (pos == NO_SLOT)
     {
-        if (*it == o)
-        {
-            this->erase(it);
-            break;
-        }
+        return;
+    }
+
+    this->slots[pos] = nullptr;
+    this->count--;
+
+    if (this->count == 0)
+    {
+        this->reset();
+        return;
+    }
+
+    /*
+     * Keep front() and back() on occupied slots.
+     */
+    this->head = this->nextSlot(this->head);
+
+    while (!this->slots.back())
+    {
+        this->slots.pop_back();
     }
 }
 
@@ -174,7 +468,7 @@ Relationship::removeObject(Object *o)
 Object *
 Relationship::front()
 {
-    return ObjVector::empty() ? nullptr : ObjVector::front();
+    return this->empty() ? nullptr : this->slots[this->head];
 }
 
 /**
@@ -183,7 +477,7 @@ Relationship::front()
 Object *
 Relationship::back()
 {
-    return ObjVector::empty() ? nullptr : ObjVector::back();
+    return this->empty() ? nullptr : this->slots.back();
 }
 
 Object *
@@ -199,3 +493,212 @@ Relationship::find(std::string id)
 
     return nullptr;
 }
+
+/**
+ * Get iterator to first object.
+ *
+ * @return iterator.
+ */
+Relationship::Iterator
+Relationship::begin() const
+{
+    return Iterator(&this->slots, this->head);
+}
+
+/**
+ * Get iterator past last object.
+ *
+ * @return iterator.
+ */
+Relationship::Iterator
+Relationship::end() const
+{
+    return Iterator(&this->slots, this->slots.size());
+}
+
+/**
+ * Get number of objects.
+ *
+ * @return number of objects.
+ */
+size_t
+Relationship::size() const
+{
+    return this->count;
+}
+
+/**
+ * Check if relationship has no objects.
+ *
+ * @return true if empty, otherwise false.
+ */
+bool
+Relationship::empty() const
+{
+    return this->count == 0;
+}
+
+/**
+ * Get first occupied slot starting from position.
+ *
+ * @param pos - starting position.
+ * @return slot position, or number of slots if there is none.
+ */
+size_t
+Relationship::nextSlot(size_t pos) const
+{
+    while (pos < this->slots.size() && !this->slots[pos])
+    {
+        pos++;
+    }
+
+    return pos;
+}
+
+/**
+ * Find slot of the object.
+ *
+ * @param o - the object.
+ * @return slot position if found, otherwise NO_SLOT.
+ */
+size_t
+Relationship::findSlot(Object *o)
+{
+    if (!this->index)
+    {
+        for (size_t i = this->head; i < this->slots.size(); i++)
+        {
+            if (this->slots[i] == o)
+            {
+                return i;
+            }
+        }
+
+        return NO_SLOT;
+    }
+
+    auto range = this->index->equal_range(o);
+
+    if (range.first == range.second)
+    {
+        return NO_SLOT;
+    }
+
+    /*
+     * Same object can be added more than once, remove the first one.
+     */
+    auto first = range.first;
+
+    for (auto it = range.first; it != range.second; it++)
+    {
+        if (it->second < first->second)
+        {
+            first = it;
+        }
+    }
+
+    size_t pos = first->second;
+    this->index->erase(first);
+
+    return pos;
+}
+
+/**
+ * Get number of bytes held by relationship.
+ *
+ * @return number of bytes.
+ */
+size_t
+Relationship::getFootprint() const
+{
+    size_t bytes = sizeof(Relationship);
+
+    if (!this->slots.isInline())
+    {
+        bytes += this->slots.capacity() * sizeof(Object *);
+    }
+
+    if (this->index)
+    {
+        bytes += this->index->bucket_count() * sizeof(void *) +
+                 this->index->size() * (sizeof(ObjIndex::value_type) + sizeof(void *));
+    }
+
+    return bytes;
+}
+
+/**
+ * Reserve slots for objects about to be added.
+ *
+ * @param count - number of objects.
+ */
+void
+Relationship::reserve(size_t count)
+{
+    this->slots.reserve(this->slots.size() + count);
+}
+
+/**
+ * Remove empty slots and release spare capacity.
+ */
+void
+Relationship::shrink()
+{
+    this->compact();
+    this->slots.shrink_to_fit();
+}
+
+/**
+ * Remove empty slots.
+ */
+void
+Relationship::compact()
+{
+    if (this->slots.size() == this->count)
+    {
+        return;
+    }
+
+    this->slots.erase(std::remove(this->slots.begin(), this->slots.end(), nullptr), this->slots.end());
+    this->head = 0;
+
+    if (this->index)
+    {
+        this->buildIndex();
+    }
+}
+
+/**
+ * Build object -> slot index.
+ */
+void
+Relationship::buildIndex()
+{
+    if (!this->index)
+    {
+        this->index = std::unique_ptr<ObjIndex>(new ObjIndex());
+    }
+
+    this->index->clear();
+    this->index->reserve(this->slots.size());
+
+    for (size_t i = this->head; i < this->slots.size(); i++)
+    {
+        if (this->slots[i])
+        {
+            this->index->emplace(this->slots[i], i);
+        }
+    }
+}
+
+/**
+ * Drop all slots.
+ */
+void
+Relationship::reset()
+{
+    this->slots.clear();
+    this->index.reset();
+    this->head = 0;
+    this->count = 0;
+}
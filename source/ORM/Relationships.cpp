@@ -22,80 +22,215 @@
 
 #include <ORM/Relationships.h>
 #include <ORM/Relationship.h>
+#include <ORM/Concurrency.h>
 #include <ErrorBundle/ErrorLog.h>
 
+/**
+ * Empty slot constructor.
+ */
+RelationshipSlot::RelationshipSlot() : decl(nullptr), relationship(nullptr)
+{
+}
+
+/**
+ * Copy constructor, used when slots move to the table.
+ *
+ * @param slot - slot to copy.
+ */
+RelationshipSlot::RelationshipSlot(const RelationshipSlot &slot) :
+    decl(slot.decl), relationship(slot.relationship.load(std::memory_order_acquire))
+{
+}
+
 Relationships::Relationships(Object *self)
 {
     this->self = self;
 }
 
+Relationships::~Relationships()
+{
+    this->forEach([](Relationship *r) {
+        delete r;
+    });
+}
 
-Relationship *
-Relationships::get(std::string relationshipName)
+/**
+ * Find declared slot.
+ *
+ * @param relationshipName - relationship name.
+ * @return slot if declared, otherwise nullptr.
+ */
+RelationshipSlot *
+Relationships::getSlot(const std::string &relationshipName)
 {
-    auto it = this->relationships.find(relationshipName);
+    RelationshipSlot *begin = this->table ? this->table->data() : this->inlined;
+    RelationshipSlot *end = this->table ? begin + this->table->size() : begin + RELATIONSHIPS_INLINE;
 
-    if (it != this->relationships.end())
+    for (RelationshipSlot *slot = begin; slot != end; slot++)
     {
-        return (*it).second.get();
+        if (slot->decl && (slot->decl->name == relationshipName))
+        {
+            return slot;
+        }
     }
 
     return nullptr;
 }
 
+/**
+ * Get relationship, create it if declared but not used yet.
+ *
+ * @param relationshipName - relationship name.
+ * @return relationship, or nullptr if it isn't declared.
+ */
+Relationship *
+Relationships::get(const std::string &relationshipName)
+{
+    RelationshipSlot *slot = this->getSlot(relationshipName);
+
+    if (!slot)
+    {
+        return nullptr;
+    }
+
+    Relationship *r = slot->relationship.load(std::memory_order_acquire);
+
+    if (r)
+    {
+        return r;
+    }
+
+    ORM::Lock lock;
+    r = slot->relationship.load(std::memory_order_acquire);
+
+    if (!r)
+    {
+        r = new Relationship(slot->decl);
+        slot->relationship.store(r, std::memory_order_release);
+    }
+
+    return r;
+}
+
+/**
+ * Get relationship only if it is already created.
+ * Readers use it so that an empty relationship stays unallocated.
+ *
+ * @param relationshipName - relationship name.
+ * @return relationship, or nullptr if it isn't created.
+ */
+Relationship *
+Relationships::find(const std::string &relationshipName)
+{
+    RelationshipSlot *slot = this->getSlot(relationshipName);
+
+    return slot ? slot->relationship.load(std::memory_order_acquire) : nullptr;
+}
+
+/**
+ * Declare relationship. Nothing is allocated until the relationship is used.
+ *
+ * @param relationshipName - relationship name.
+ * @param type - relationship type.
+ */
 void
-Relationships::init(std::string relationshipName, eRelationshipType type)
+Relationships::init(const std::string &relationshipName, eRelationshipType type)
 {
-    if (this->get(relationshipName))
+    ORM::Lock lock;
+
+    if (this->getSlot(relationshipName))
     {
         return;
     }
 
-    RelationshipPtr rp(new Relationship(relationshipName, type));
+    const RelationshipDecl *decl = Relationship::declare(relationshipName, type);
 
-    this->relationships[relationshipName] = rp;
+    if (!this->table)
+    {
+        for (auto &slot : this->inlined)
+        {
+            if (!slot.decl)
+            {
+                slot.decl = decl;
+                return;
+            }
+        }
+
+        /*
+         * No more inline space, move all to table.
+         */
+        this->table = std::unique_ptr<RelationshipTable>(new RelationshipTable());
+        this->table->reserve(RELATIONSHIPS_INLINE * 2);
+
+        for (auto &slot : this->inlined)
+        {
+            this->table->push_back(slot);
+            slot.decl = nullptr;
+            slot.relationship.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    this->table->emplace_back();
+    this->table->back().decl = decl;
 }
 
 Object *
 Relationships::front(std::string relationshipName)
 {
-    Relationship *r = this->get(std::move(relationshipName));
+    RelationshipSlot *slot = this->getSlot(relationshipName);
 
-    if (!r)
+    if (!slot)
     {
         ERROR_LOG_ADD(ERROR_ENTITY_UNKNOWN_RELATIONSHIP);
         return nullptr;
     }
 
-    return r->front();
+    Relationship *r = slot->relationship.load(std::memory_order_acquire);
+
+    return r ? r->front() : nullptr;
 }
 
 Object *
 Relationships::back(std::string relationshipName)
 {
-    Relationship *r = this->get(std::move(relationshipName));
+    RelationshipSlot *slot = this->getSlot(relationshipName);
 
-    if (!r)
+    if (!slot)
     {
         ERROR_LOG_ADD(ERROR_ENTITY_UNKNOWN_RELATIONSHIP);
         return nullptr;
     }
 
-    return r->back();
+    Relationship *r = slot->relationship.load(std::memory_order_acquire);
+
+    return r ? r->back() : nullptr;
 }
 
 bool
 Relationships::hasRelations()
 {
-    for (auto &relationship : this->relationships)
-    {
-        Relationship *r = relationship.second.get();
+    bool relations = false;
 
-        if (!r->empty())
-        {
-            return true;
-        }
-    }
+    this->forEach([&](Relationship *r) {
+        relations = relations || !r->empty();
+    });
+
+    return relations;
+}
+
+/**
+ * Get number of bytes held outside of the object.
+ *
+ * @return number of bytes.
+ */
+size_t
+Relationships::getFootprint()
+{
+    size_t bytes = this->table ? this->table->capacity() * sizeof(RelationshipSlot) : 0;
+
+    this->forEach([&](Relationship *r) {
+        bytes += r->getFootprint();
+    });
 
-    return false;
+    return bytes;
 }
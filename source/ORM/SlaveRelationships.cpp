@@ -20,11 +20,15 @@
  * THE SOFTWARE.
  */
 
+#include <ORM/ORM.h>
 #include <ORM/Object.h>
 #include <ORM/Relationship.h>
 #include <ORM/Relationships.h>
 #include <ORM/SlaveRelationships.h>
 #include <ORM/MasterRelationships.h>
+#include <ORM/Concurrency.h>
+#include <ORM/Cascade.h>
+#include <ORM/Transaction.h>
 #include <ErrorBundle/ErrorLog.h>
 
 SlaveRelationships::SlaveRelationships(Object *self) : Relationships(self)
@@ -39,6 +43,8 @@ SlaveRelationships::SlaveRelationships(Object *self) : Relationships(self)
 void
 SlaveRelationships::add(std::string relationshipName, Object *o)
 {
+    ORM::Lock lock;
+
     Relationship *r = this->get(std::move(relationshipName));
 
     if (!r)
@@ -53,7 +59,9 @@ SlaveRelationships::add(std::string relationshipName, Object *o)
 void
 SlaveRelationships::remove(std::string relationshipName, Object *o)
 {
-    Relationship *r = this->get(std::move(relationshipName));
+    ORM::Lock lock;
+
+    Relationship *r = this->find(relationshipName);
 
     if (!r)
     {
@@ -62,10 +70,14 @@ SlaveRelationships::remove(std::string relationshipName, Object *o)
 
     r->removeObject(o);
 
-    if (!this->hasRelations())
+    /*
+     * Frozen object and singleton are never orphaned, transaction decides on commit.
+     */
+    if (!this->hasRelations() && !this->self->isFrozen() && !ORM::isSingleton(this->self)
+        && !ORM::deferOrphan(this->self))
     {
         this->self->setMarked(true);
-        this->self->getMaster()->clearObjects();
+        ORM::cascade(this->self);
     }
 }
 
@@ -75,10 +87,9 @@ SlaveRelationships::remove(std::string relationshipName, Object *o)
 void
 SlaveRelationships::notifyDestroyed()
 {
-    for (auto &slaveRelationship : this->relationships)
-    {
-        Relationship *r = slaveRelationship.second.get();
+    ORM::Lock lock;
 
+    this->forEach([&](Relationship *r) {
         while (!r->empty())
         {
             /*
@@ -87,7 +98,7 @@ SlaveRelationships::notifyDestroyed()
             Object *e = r->front();
             e->getMaster()->remove(r->getName(), self);
         }
-    }
+    });
 }
 
 SlaveRelationships::~SlaveRelationships()
@@ -0,0 +1,286 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <ORM/SweepPool.h>
+#include <ORM/Object.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/**
+ * Parallel task, workers and caller take indexes until all are taken.
+ */
+struct SweepTask {
+    const std::function<void(size_t)> *task;
+    size_t count;
+    std::atomic<size_t> next;
+    std::atomic<size_t> done;
+    size_t active;
+};
+
+using ObjectBatch = std::vector<std::unique_ptr<Object>>;
+
+static std::vector<std::thread> workers;
+static std::mutex poolMutex;
+
+/*
+ * poolWake - workers wait for work.
+ * poolIdle - callers wait for workers.
+ */
+static std::condition_variable poolWake;
+static std::condition_variable poolIdle;
+
+static SweepTask *current = nullptr;
+static std::deque<ObjectBatch> destroyQueue;
+static size_t destroying = 0;
+static bool stopping = false;
+static std::atomic<size_t> offloaded(0);
+
+/**
+ * Run task indexes until all are taken.
+ *
+ * @param t - the task.
+ */
+static void
+runTask(SweepTask *t)
+{
+    size_t i;
+
+    while ((i = t->next++) < t->count)
+    {
+        (*t->task)(i);
+        t->done++;
+    }
+}
+
+/**
+ * Worker thread loop.
+ */
+static void
+workerLoop()
+{
+    std::unique_lock<std::mutex> lock(poolMutex);
+
+    while (true)
+    {
+        poolWake.wait(lock, []() {
+            return stopping || !destroyQueue.empty() || (current && (current->next.load() < current->count));
+        });
+
+        if (current && (current->next.load() < current->count))
+        {
+            SweepTask *t = current;
+
+            t->active++;
+            lock.unlock();
+            runTask(t);
+            lock.lock();
+            t->active--;
+
+            poolIdle.notify_all();
+            continue;
+        }
+
+        if (!destroyQueue.empty())
+        {
+            ObjectBatch batch = std::move(destroyQueue.front());
+
+            destroyQueue.pop_front();
+            destroying++;
+            lock.unlock();
+            batch.clear();
+            lock.lock();
+            destroying--;
+
+            poolIdle.notify_all();
+            continue;
+        }
+
+        if (stopping)
+        {
+            return;
+        }
+    }
+}
+
+/**
+ * Stop and join all workers, queued objects are destroyed first.
+ */
+static void
+stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        stopping = true;
+    }
+
+    poolWake.notify_all();
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    workers.clear();
+    stopping = false;
+}
+
+/**
+ * Stops workers at exit, defined last so it is destroyed first.
+ */
+static struct SweepPoolGuard {
+    ~SweepPoolGuard()
+    {
+        stopWorkers();
+    }
+} sweepPoolGuard;
+
+/**
+ * Set number of sweep workers, 0 sweeps on calling thread.
+ * Must not be called while sweep runs.
+ *
+ * @param count - number of workers.
+ */
+void
+ORM::setSweepWorkers(size_t count)
+{
+    stopWorkers();
+
+    for (size_t i = 0; i < count; i++)
+    {
+        workers.emplace_back(workerLoop);
+    }
+}
+
+/**
+ * Get number of sweep workers.
+ *
+ * @return number of workers.
+ */
+size_t
+ORM::getSweepWorkers()
+{
+    return workers.size();
+}
+
+/**
+ * Run task for each index in [0, count), calling thread takes part.
+ * Returns when all indexes are done.
+ *
+ * @param count - number of indexes.
+ * @param task - function taking index.
+ */
+void
+ORM::parallelFor(size_t count, const std::function<void(size_t)> &task)
+{
+    if (workers.empty() || (count < 2))
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            task(i);
+        }
+
+        return;
+    }
+
+    SweepTask t;
+
+    t.task = &task;
+    t.count = count;
+    t.next.store(0);
+    t.done.store(0);
+    t.active = 0;
+
+    std::unique_lock<std::mutex> lock(poolMutex);
+
+    current = &t;
+    poolWake.notify_all();
+
+    lock.unlock();
+    runTask(&t);
+    lock.lock();
+
+    poolIdle.wait(lock, [&t]() {
+        return (t.done.load() == t.count) && (t.active == 0);
+    });
+
+    current = nullptr;
+}
+
+/**
+ * Destroy objects on a worker, or right away if there are none.
+ * Object storage must be released thread safe, so it is used only
+ * in concurrent mode.
+ *
+ * @param objects - objects, ownership is taken.
+ */
+void
+ORM::offloadDestroy(std::vector<std::unique_ptr<Object>> &objects)
+{
+    if (objects.empty())
+    {
+        return;
+    }
+
+    if (workers.empty())
+    {
+        objects.clear();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+
+        offloaded += objects.size();
+        destroyQueue.push_back(std::move(objects));
+    }
+
+    objects.clear();
+    poolWake.notify_one();
+}
+
+/**
+ * Wait until all offloaded objects are destroyed.
+ */
+void
+ORM::waitDestroyed()
+{
+    std::unique_lock<std::mutex> lock(poolMutex);
+
+    poolIdle.wait(lock, []() {
+        return destroyQueue.empty() && (destroying == 0);
+    });
+}
+
+/**
+ * Get number of objects destroyed by workers.
+ *
+ * @return number of objects.
+ */
+size_t
+ORM::getOffloadedCount()
+{
+    return offloaded.load();
+}
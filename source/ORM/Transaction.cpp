@@ -0,0 +1,647 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <ORM/Transaction.h>
+#include <ORM/ORM.h>
+#include <ORM/Object.h>
+#include <ORM/MasterRelationships.h>
+#include <ORM/SlaveRelationships.h>
+#include <ORM/Cascade.h>
+#include <algorithm>
+#include <atomic>
+#include <unordered_set>
+
+/*
+ * Version of stripe claimed by a transaction is odd, writes
+ * outside of transactions add two and keep the claim bit.
+ */
+#define CLAIM_BIT (1u)
+#define VERSION_STEP (2u)
+
+/**
+ * @brief transaction - outermost transaction open on this thread, nullptr if none.
+ */
+thread_local ORM::Transaction *ORM::transaction = nullptr;
+
+/**
+ * @brief stripes - object version stripes, bumped on each committed write.
+ */
+static std::atomic<uint32_t> stripes[TRANSACTION_VERSION_STRIPES];
+
+/**
+ * @brief conflicts - transactions rolled back on commit.
+ */
+static std::atomic<size_t> conflicts(0);
+
+/**
+ * Get version stripe index of object.
+ *
+ * @param o - the object.
+ * @return stripe index.
+ */
+static size_t
+stripeIndex(Object *o)
+{
+    return (reinterpret_cast<uintptr_t>(o) >> 4) % TRANSACTION_VERSION_STRIPES;
+}
+
+/**
+ * Bump version of object written outside of transaction.
+ * Only concurrent mode has anyone to conflict with.
+ *
+ * @param o - the object.
+ */
+static void
+bump(Object *o)
+{
+    if (o && ORM::isConcurrent())
+    {
+        stripes[stripeIndex(o)] += VERSION_STEP;
+    }
+}
+
+/**
+ * Mark objects left without master, as a removal outside of transaction would.
+ *
+ * @param objects - objects that lost a master.
+ */
+static void
+orphan(const std::vector<Object *> &objects)
+{
+    for (Object *o : objects)
+    {
+        if (!o->getMarked() && !o->isFrozen() && !ORM::isSingleton(o) && !o->getSlave()->hasRelations())
+        {
+            o->setMarked(true);
+            ORM::cascade(o);
+        }
+    }
+}
+
+/**
+ * Begin transaction, or savepoint if one is already open on this thread.
+ */
+ORM::Transaction::Transaction()
+{
+    this->finished = false;
+    this->rollingBack = false;
+    this->conflicted = false;
+
+    if (ORM::transaction)
+    {
+        this->root = ORM::transaction;
+        this->savepoint = this->root->undoLog.size();
+        this->destroyedSavepoint = this->root->destroyed.size();
+        return;
+    }
+
+    this->root = this;
+    this->savepoint = 0;
+    this->destroyedSavepoint = 0;
+    ORM::transaction = this;
+}
+
+/**
+ * Commit transaction. Held destroys and orphan sweeps are applied.
+ * Savepoint commit only keeps its changes in enclosing transaction.
+ *
+ * @return true if committed, false if rolled back on conflict.
+ */
+bool
+ORM::Transaction::commit()
+{
+    if (this->finished)
+    {
+        return false;
+    }
+
+    if (this->root != this)
+    {
+        this->finished = true;
+        return true;
+    }
+
+    if (this->conflicted || !this->validate())
+    {
+        conflicts++;
+        this->rollback();
+        return false;
+    }
+
+    this->publish();
+
+    std::vector<Object *> orphaned = std::move(this->orphans);
+    std::vector<Object *> held = std::move(this->destroyed);
+
+    this->finish();
+    orphan(orphaned);
+
+    if (!held.empty())
+    {
+        ORM::destroyMany(held);
+    }
+
+    return true;
+}
+
+/**
+ * Roll back transaction, or changes made since savepoint.
+ */
+void
+ORM::Transaction::rollback()
+{
+    if (this->finished || this->root->finished)
+    {
+        return;
+    }
+
+    this->root->undo(this->savepoint, this->destroyedSavepoint);
+
+    if (this->root != this)
+    {
+        this->finished = true;
+        return;
+    }
+
+    this->publish();
+
+    std::vector<Object *> orphaned = std::move(this->orphans);
+
+    this->finish();
+    orphan(orphaned);
+}
+
+/**
+ * Add object to read set, commit fails if it is written meanwhile.
+ *
+ * @param o - the object.
+ */
+void
+ORM::Transaction::read(Object *o)
+{
+    if (o && !this->finished)
+    {
+        this->root->touch(o);
+    }
+}
+
+/**
+ * Check if transaction is savepoint of another one.
+ *
+ * @return true if nested, otherwise false.
+ */
+bool
+ORM::Transaction::isNested()
+{
+    return this->root != this;
+}
+
+/**
+ * Get number of recorded undo records.
+ *
+ * @return number of undo records.
+ */
+size_t
+ORM::Transaction::getUndoCount()
+{
+    return this->root->undoLog.size();
+}
+
+/**
+ * Claim stripe of object about to be written. Stripe claimed by
+ * another transaction, or written since transaction has read it,
+ * is a conflict and transaction will fail to commit.
+ *
+ * @param o - the object.
+ * @return true if claimed, false on conflict.
+ */
+bool
+ORM::Transaction::acquire(Object *o)
+{
+    if (!ORM::isConcurrent())
+    {
+        return true;
+    }
+
+    size_t index = stripeIndex(o);
+    auto it = this->versions.find(index);
+
+    if ((it != this->versions.end()) && it->second.written)
+    {
+        return true;
+    }
+
+    uint32_t version = stripes[index].load();
+    bool stale = (it != this->versions.end()) && (it->second.version != version);
+
+    if (stale || (version & CLAIM_BIT) || !stripes[index].compare_exchange_strong(version, version | CLAIM_BIT))
+    {
+        this->conflicted = true;
+        return false;
+    }
+
+    this->versions[index] = Version{version | CLAIM_BIT, true};
+    return true;
+}
+
+/**
+ * Remember version of object seen first time by transaction.
+ *
+ * @param o - the object.
+ */
+void
+ORM::Transaction::touch(Object *o)
+{
+    size_t index = stripeIndex(o);
+
+    if (this->versions.find(index) == this->versions.end())
+    {
+        this->versions.emplace(index, Version{stripes[index].load(), false});
+    }
+}
+
+/**
+ * Check that object is claimed and nobody wrote it since.
+ *
+ * @param o - the object.
+ * @return true if intact, otherwise false.
+ */
+bool
+ORM::Transaction::isIntact(Object *o)
+{
+    if (!o || !ORM::isConcurrent())
+    {
+        return true;
+    }
+
+    auto it = this->versions.find(stripeIndex(o));
+
+    return (it != this->versions.end()) && it->second.written &&
+           (stripes[it->first].load() == it->second.version);
+}
+
+/**
+ * Bump version of object written by rollback but not claimed,
+ * claimed ones are bumped when released.
+ *
+ * @param o - the object.
+ */
+void
+ORM::Transaction::bumpUnclaimed(Object *o)
+{
+    if (!o || !ORM::isConcurrent())
+    {
+        return;
+    }
+
+    auto it = this->versions.find(stripeIndex(o));
+
+    if ((it == this->versions.end()) || !it->second.written)
+    {
+        bump(o);
+    }
+}
+
+/**
+ * Play undo log backwards down to savepoint. Objects created
+ * since savepoint are destroyed, held destroys are dropped.
+ *
+ * Removed edges and ids are restored only if object wasn't
+ * written outside of transactions since, that write is kept.
+ * Objects left without master are held as orphans.
+ *
+ * @param savepoint - undo log size to return to.
+ * @param destroyedSavepoint - held destroys count to return to.
+ */
+void
+ORM::Transaction::undo(size_t savepoint, size_t destroyedSavepoint)
+{
+    std::vector<Object *> created;
+
+    /*
+     * Undone edits are not recorded.
+     */
+    this->rollingBack = true;
+
+    while (this->undoLog.size() > savepoint)
+    {
+        UndoRecord record = std::move(this->undoLog.back());
+        this->undoLog.pop_back();
+
+        /*
+         * Object destroyed by another thread meanwhile stays destroyed.
+         */
+        if (record.master->getMarked() || (record.slave && record.slave->getMarked()))
+        {
+            continue;
+        }
+
+        switch (record.type)
+        {
+            case UNDO_ADD:
+                record.master->getMaster()->remove(record.name, record.slave);
+                break;
+            case UNDO_REMOVE:
+                if (this->isIntact(record.master) && this->isIntact(record.slave))
+                {
+                    record.master->getMaster()->add(record.name, record.slave);
+                }
+
+                break;
+            case UNDO_CHANGE_ID:
+                if (this->isIntact(record.master))
+                {
+                    ORM::changeId(record.master, record.name);
+                }
+
+                break;
+            case UNDO_CREATE:
+                created.push_back(record.master);
+                break;
+        }
+    }
+
+    this->destroyed.resize(destroyedSavepoint);
+
+    if (!created.empty())
+    {
+        /*
+         * Destroyed objects are no orphans to sweep later.
+         */
+        std::unordered_set<Object *> dropped(created.begin(), created.end());
+
+        this->orphans.erase(std::remove_if(this->orphans.begin(), this->orphans.end(), [&](Object *o) {
+            return dropped.count(o) != 0;
+        }), this->orphans.end());
+
+        ORM::destroyMany(created);
+    }
+
+    this->rollingBack = false;
+}
+
+/**
+ * Check that no object seen by transaction was written by others.
+ *
+ * @return true if valid, otherwise false.
+ */
+bool
+ORM::Transaction::validate()
+{
+    if (!ORM::isConcurrent())
+    {
+        return true;
+    }
+
+    for (auto &it : this->versions)
+    {
+        uint32_t version = stripes[it.first].load();
+
+        if ((version != it.second.version) || (!it.second.written && (version & CLAIM_BIT)))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Release claimed stripes with new version, transactions
+ * that have seen them before will fail to commit.
+ */
+void
+ORM::Transaction::publish()
+{
+    for (auto &it : this->versions)
+    {
+        if (it.second.written)
+        {
+            stripes[it.first] += CLAIM_BIT;
+        }
+    }
+}
+
+/**
+ * Close transaction and drop its logs.
+ */
+void
+ORM::Transaction::finish()
+{
+    this->finished = true;
+    this->undoLog.clear();
+    this->orphans.clear();
+    this->destroyed.clear();
+    this->versions.clear();
+    ORM::transaction = nullptr;
+}
+
+/**
+ * The destructor. Transaction neither committed nor rolled back is rolled back.
+ */
+ORM::Transaction::~Transaction()
+{
+    this->rollback();
+}
+
+/**
+ * Claim objects about to be written by transaction open on this thread.
+ * Edit is refused if another transaction has claimed any of them.
+ *
+ * @param master - written object.
+ * @param slave - other written object, or nullptr.
+ * @return true if edit can go on, otherwise false.
+ */
+bool
+ORM::claim(Object *master, Object *slave)
+{
+    Transaction *t = ORM::transaction;
+
+    if (!t || t->rollingBack)
+    {
+        return true;
+    }
+
+    return t->acquire(master) && (!slave || t->acquire(slave));
+}
+
+/**
+ * Record added relationship edge.
+ *
+ * @param master
+ * @param name - relationship name.
+ * @param slave
+ */
+void
+ORM::logAdd(Object *master, const std::string &name, Object *slave)
+{
+    Transaction *t = ORM::transaction;
+
+    if (!t)
+    {
+        bump(master);
+        bump(slave);
+        return;
+    }
+
+    if (t->rollingBack)
+    {
+        t->bumpUnclaimed(master);
+        t->bumpUnclaimed(slave);
+        return;
+    }
+
+    /*
+     * Edit that skipped claim still fails commit on conflict.
+     */
+    t->acquire(master);
+    t->acquire(slave);
+    t->undoLog.push_back(UndoRecord{UNDO_ADD, master, slave, name});
+}
+
+/**
+ * Record removed relationship edge.
+ *
+ * @param master
+ * @param name - relationship name.
+ * @param slave
+ */
+void
+ORM::logRemove(Object *master, const std::string &name, Object *slave)
+{
+    Transaction *t = ORM::transaction;
+
+    if (!t)
+    {
+        bump(master);
+        bump(slave);
+        return;
+    }
+
+    if (t->rollingBack)
+    {
+        t->bumpUnclaimed(master);
+        t->bumpUnclaimed(slave);
+        return;
+    }
+
+    t->acquire(master);
+    t->acquire(slave);
+    t->undoLog.push_back(UndoRecord{UNDO_REMOVE, master, slave, name});
+}
+
+/**
+ * Record object id change.
+ *
+ * @param o - the object.
+ * @param oldId - id before change.
+ */
+void
+ORM::logChangeId(Object *o, const std::string &oldId)
+{
+    Transaction *t = ORM::transaction;
+
+    if (!t)
+    {
+        bump(o);
+        return;
+    }
+
+    if (t->rollingBack)
+    {
+        t->bumpUnclaimed(o);
+        return;
+    }
+
+    t->acquire(o);
+    t->undoLog.push_back(UndoRecord{UNDO_CHANGE_ID, o, nullptr, oldId});
+}
+
+/**
+ * Record created object.
+ *
+ * @param o - the object.
+ */
+void
+ORM::logCreate(Object *o)
+{
+    Transaction *t = ORM::transaction;
+
+    if (!t || t->rollingBack)
+    {
+        return;
+    }
+
+    t->undoLog.push_back(UndoRecord{UNDO_CREATE, o, nullptr, std::string()});
+}
+
+/**
+ * Hold destroy of object until commit.
+ *
+ * @param o - the object.
+ * @return true if held, false if object is to be destroyed now.
+ */
+bool
+ORM::deferDestroy(Object *o)
+{
+    Transaction *t = ORM::transaction;
+
+    if (!t || t->rollingBack)
+    {
+        return false;
+    }
+
+    t->acquire(o);
+    t->destroyed.push_back(o);
+    return true;
+}
+
+/**
+ * Hold orphan sweep of object that lost its last master until commit.
+ * Objects orphaned by rollback are held too, swept when it ends.
+ *
+ * @param o - the object.
+ * @return true if held, false if object is to be orphaned now.
+ */
+bool
+ORM::deferOrphan(Object *o)
+{
+    Transaction *t = ORM::transaction;
+
+    if (!t)
+    {
+        return false;
+    }
+
+    t->orphans.push_back(o);
+    return true;
+}
+
+/**
+ * Get number of transactions rolled back on commit because of conflict.
+ *
+ * @return number of conflicts.
+ */
+size_t
+ORM::getTransactionConflicts()
+{
+    return conflicts.load();
+}
@@ -34,7 +34,7 @@ ObjectField::ObjectField(std::string id, eVisibility visibility, Value *value) :
 
     if (value == nullptr)
     {
-        value = (Value *)ORM::getFirst(OBJECT_TYPE_NULL);
+        value = (Value *)ORM::getSingleton(OBJECT_TYPE_NULL);
     }
 
     master->add("Field", value);
@@ -0,0 +1,247 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <PersistenceBundle/BinaryStream.h>
+#include <cstring>
+
+/**
+ * The constructor.
+ *
+ * @param buffer - buffer to append to.
+ */
+BinaryWriter::BinaryWriter(std::string &buffer) : buffer(buffer)
+{}
+
+/**
+ * Append byte.
+ *
+ * @param value
+ */
+void
+BinaryWriter::putU8(uint8_t value)
+{
+    this->buffer.push_back((char) value);
+}
+
+/**
+ * Append 32 bit value.
+ *
+ * @param value
+ */
+void
+BinaryWriter::putU32(uint32_t value)
+{
+    this->putBytes(&value, sizeof(value));
+}
+
+/**
+ * Append 64 bit value.
+ *
+ * @param value
+ */
+void
+BinaryWriter::putU64(uint64_t value)
+{
+    this->putBytes(&value, sizeof(value));
+}
+
+/**
+ * Append raw bytes.
+ *
+ * @param data
+ * @param size
+ */
+void
+BinaryWriter::putBytes(const void *data, size_t size)
+{
+    this->buffer.append((const char *) data, size);
+}
+
+/**
+ * Append length prefixed string.
+ *
+ * @param value
+ */
+void
+BinaryWriter::putString(const std::string &value)
+{
+    this->putU32(static_cast<uint32_t>(value.size()));
+    this->putBytes(value.data(), value.size());
+}
+
+/**
+ * The constructor.
+ *
+ * @param data
+ * @param size
+ */
+BinaryReader::BinaryReader(const char *data, size_t size)
+{
+    this->data = data;
+    this->size = size;
+    this->position = 0;
+    this->ok = true;
+}
+
+/**
+ * Read byte.
+ *
+ * @return value, 0 if failed.
+ */
+uint8_t
+BinaryReader::getU8()
+{
+    uint8_t value = 0;
+
+    this->getBytes(&value, sizeof(value));
+
+    return value;
+}
+
+/**
+ * Read 32 bit value.
+ *
+ * @return value, 0 if failed.
+ */
+uint32_t
+BinaryReader::getU32()
+{
+    uint32_t value = 0;
+
+    this->getBytes(&value, sizeof(value));
+
+    return value;
+}
+
+/**
+ * Read 64 bit value.
+ *
+ * @return value, 0 if failed.
+ */
+uint64_t
+BinaryReader::getU64()
+{
+    uint64_t value = 0;
+
+    this->getBytes(&value, sizeof(value));
+
+    return value;
+}
+
+/**
+ * Read raw bytes.
+ *
+ * @param data - destination.
+ * @param size
+ * @return true if read, otherwise false.
+ */
+bool
+BinaryReader::getBytes(void *data, size_t size)
+{
+    if (!this->ok || (this->size - this->position < size))
+    {
+        this->ok = false;
+        return false;
+    }
+
+    memcpy(data, this->data + this->position, size);
+    this->position += size;
+
+    return true;
+}
+
+/**
+ * Read length prefixed string.
+ *
+ * @return value, empty if failed.
+ */
+std::string
+BinaryReader::getString()
+{
+    uint32_t length = this->getU32();
+
+    if (!this->ok || (this->size - this->position < length))
+    {
+        this->ok = false;
+        return std::string();
+    }
+
+    std::string value(this->data + this->position, length);
+    this->position += length;
+
+    return value;
+}
+
+/**
+ * Check if all reads succeeded.
+ *
+ * @return true if ok, otherwise false.
+ */
+bool
+BinaryReader::isOk()
+{
+    return this->ok;
+}
+
+/**
+ * Check if all data is read.
+ *
+ * @return true if at end, otherwise false.
+ */
+bool
+BinaryReader::isEnd()
+{
+    return this->position == this->size;
+}
+
+/**
+ * Get read position.
+ *
+ * @return position in bytes.
+ */
+size_t
+BinaryReader::getPosition()
+{
+    return this->position;
+}
+
+/**
+ * FNV-1a checksum.
+ *
+ * @param data
+ * @param size
+ * @return checksum.
+ */
+uint32_t
+binaryChecksum(const char *data, size_t size)
+{
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= (uint8_t) data[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <MemoryBundle/Memory.h>
+#include <VariableBundle/Primitive/Primitive.h>
+#include <VariableBundle/Collection/Collection.h>
+#include <PersistenceBundle/Codec.h>
+#include <PersistenceBundle/Persistence.h>
+#include <vector>
+
+/**
+ * Read memory payload into aligned buffer.
+ *
+ * @param reader
+ * @param buffer - aligned buffer, terminated with zeros.
+ * @return true if read, otherwise false.
+ */
+static bool
+readMemory(BinaryReader &reader, std::vector<uint64_t> &buffer)
+{
+    uint32_t size = reader.getU32();
+
+    if (!reader.isOk())
+    {
+        return false;
+    }
+
+    buffer.assign(size / sizeof(uint64_t) + 1, 0);
+
+    return reader.getBytes(buffer.data(), size);
+}
+
+/**
+ * The constructor.
+ *
+ * @param type - primitive type.
+ */
+PrimitiveCodec::PrimitiveCodec(eObjectType type)
+{
+    this->type = type;
+}
+
+/**
+ * @inherit
+ */
+void
+PrimitiveCodec::write(Object *o, BinaryWriter &writer, Persistence &persistence)
+{
+    (void) persistence;
+    Memory *mem = ((Primitive *) o)->getMemory();
+
+    if (!mem)
+    {
+        writer.putU32(0);
+        return;
+    }
+
+    writer.putU32(mem->getSize());
+    writer.putBytes(mem->getPointer<void *>(), mem->getSize());
+}
+
+/**
+ * @inherit
+ */
+Object *
+PrimitiveCodec::create(BinaryReader &reader)
+{
+    std::vector<uint64_t> buffer;
+
+    if (!readMemory(reader, buffer))
+    {
+        return nullptr;
+    }
+
+    return Primitive::create(this->type, buffer.data());
+}
+
+/**
+ * @inherit
+ */
+void
+PrimitiveCodec::restore(Object *o, BinaryReader &reader, Persistence &persistence)
+{
+    (void) persistence;
+    std::vector<uint64_t> buffer;
+
+    if (readMemory(reader, buffer))
+    {
+        (*(Value *) o) = (const void *) buffer.data();
+    }
+}
+
+/**
+ * @inherit
+ */
+void
+CollectionCodec::write(Object *o, BinaryWriter &writer, Persistence &persistence)
+{
+    auto &data = ((Collection *) o)->data_cache;
+
+    writer.putU32(static_cast<uint32_t>(data.size()));
+
+    for (auto &it : data)
+    {
+        writer.putString(it.first);
+        writer.putU64(persistence.getKey(it.second));
+    }
+}
+
+/**
+ * @inherit
+ */
+Object *
+CollectionCodec::create(BinaryReader &reader)
+{
+    (void) reader;
+
+    return Collection::create();
+}
+
+/**
+ * @inherit
+ */
+void
+CollectionCodec::restore(Object *o, BinaryReader &reader, Persistence &persistence)
+{
+    auto &data = ((Collection *) o)->data_cache;
+    uint32_t count = reader.getU32();
+
+    data.clear();
+
+    for (uint32_t i = 0; (i < count) && reader.isOk(); i++)
+    {
+        std::string index = reader.getString();
+        Object *element = persistence.getObject(reader.getU64());
+
+        if (element)
+        {
+            data[index] = (Value *) element;
+        }
+    }
+}
@@ -0,0 +1,1118 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <ORM/ORM.h>
+#include <ORM/Object.h>
+#include <ORM/Relationship.h>
+#include <ORM/MasterRelationships.h>
+#include <ORM/SlaveRelationships.h>
+#include <PersistenceBundle/Persistence.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#define CHECKPOINT_MAGIC (0x43584f42u)
+#define CHECKPOINT_VERSION (2)
+
+/*
+ * Record frame: u32 body length, body, u32 body checksum.
+ */
+#define RECORD_FRAME_SIZE (2 * sizeof(uint32_t))
+
+using PersistenceLock = std::lock_guard<std::recursive_mutex>;
+
+/**
+ * Read whole file.
+ *
+ * @param path
+ * @param data - file content.
+ * @return true if file exists, otherwise false.
+ */
+static bool
+readFile(const std::string &path, std::string &data)
+{
+    std::ifstream in(path, std::ios::binary);
+
+    if (!in)
+    {
+        return false;
+    }
+
+    data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+    return true;
+}
+
+/**
+ * Write all data to file descriptor.
+ *
+ * @param fd
+ * @param data
+ * @return true if written, otherwise false.
+ */
+static bool
+writeAll(int fd, const std::string &data)
+{
+    size_t written = 0;
+
+    while (written < data.size())
+    {
+        ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+
+        if (n < 0)
+        {
+            return false;
+        }
+
+        written += (size_t) n;
+    }
+
+    return true;
+}
+
+/**
+ * Flush directory entries of a directory.
+ *
+ * @param directory
+ */
+static void
+syncDirectory(const std::string &directory)
+{
+    int fd = ::open(directory.c_str(), O_RDONLY);
+
+    if (fd >= 0)
+    {
+        fsync(fd);
+        ::close(fd);
+    }
+}
+
+/**
+ * The constructor.
+ *
+ * @param directory - directory of checkpoint and log files.
+ */
+Persistence::Persistence(std::string directory)
+{
+    this->directory = std::move(directory);
+    this->fd = -1;
+    this->logSize = 0;
+    this->pendingRecords = 0;
+    this->commits = 0;
+    this->replaying = false;
+    this->lsn = 0;
+    this->checkpointLsn = 0;
+    this->nextKey = 1;
+
+    this->registerCodec(OBJECT_TYPE_BOOL, new PrimitiveCodec(OBJECT_TYPE_BOOL));
+    this->registerCodec(OBJECT_TYPE_CHAR, new PrimitiveCodec(OBJECT_TYPE_CHAR));
+    this->registerCodec(OBJECT_TYPE_INT, new PrimitiveCodec(OBJECT_TYPE_INT));
+    this->registerCodec(OBJECT_TYPE_FLOAT, new PrimitiveCodec(OBJECT_TYPE_FLOAT));
+    this->registerCodec(OBJECT_TYPE_STRING, new PrimitiveCodec(OBJECT_TYPE_STRING));
+    this->registerCodec(OBJECT_TYPE_COLLECTION, new CollectionCodec());
+}
+
+/**
+ * Recover persisted objects and start logging changes.
+ *
+ * @return true if success, otherwise false.
+ */
+bool
+Persistence::open()
+{
+    PersistenceLock lock(this->mutex);
+
+    if (this->fd >= 0)
+    {
+        return true;
+    }
+
+    mkdir(this->directory.c_str(), 0755);
+
+    /*
+     * Journal is attached while replaying to follow swept objects.
+     */
+    this->replaying = true;
+    ORM::setJournal(this);
+
+    bool ok = this->loadCheckpoint() && this->replayLog();
+
+    this->replaying = false;
+
+    if (ok)
+    {
+        this->fd = ::open(this->getPath(PERSISTENCE_LOG_FILE).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    }
+
+    /*
+     * Replay cut torn tail, log ends with last commit.
+     */
+    if (this->fd >= 0)
+    {
+        this->logSize = (size_t) lseek(this->fd, 0, SEEK_END);
+    }
+
+    if (this->fd < 0)
+    {
+        ORM::setJournal(nullptr);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Write pending records and dirty objects, then fsync once.
+ * Failed group stays pending and is written by next commit.
+ *
+ * @return true if durable, otherwise false.
+ */
+bool
+Persistence::commit()
+{
+    PersistenceLock lock(this->mutex);
+
+    if (this->fd < 0)
+    {
+        return false;
+    }
+
+    for (auto &it : this->dirty)
+    {
+        std::string body;
+        BinaryWriter writer(body);
+
+        writer.putU8(PERSISTENCE_RECORD_UPDATE);
+        writer.putU64(it.first);
+        this->writeObject(it.second, writer);
+
+        this->append(body);
+    }
+
+    this->dirty.clear();
+
+    if (this->pending.empty())
+    {
+        return true;
+    }
+
+    size_t size = this->pending.size();
+    size_t records = this->pendingRecords;
+    std::string body;
+    BinaryWriter writer(body);
+
+    writer.putU8(PERSISTENCE_RECORD_COMMIT);
+    writer.putU64(++this->lsn);
+    this->append(body);
+
+    if (!writeAll(this->fd, this->pending) || (fsync(this->fd) != 0))
+    {
+        this->pending.resize(size);
+        this->pendingRecords = records;
+        this->lsn--;
+
+        /*
+         * Replay stops at torn record, commits after it would be lost.
+         * Log that can not be cut back accepts no more commits.
+         */
+        if (ftruncate(this->fd, (off_t) this->logSize) != 0)
+        {
+            ::close(this->fd);
+            this->fd = -1;
+        }
+
+        return false;
+    }
+
+    this->logSize += this->pending.size();
+    this->pending.clear();
+    this->pendingRecords = 0;
+    this->commits++;
+
+    return true;
+}
+
+/**
+ * Write all persisted objects and relationships, then empty the log.
+ *
+ * @return true if success, otherwise false.
+ */
+bool
+Persistence::checkpoint()
+{
+    PersistenceLock lock(this->mutex);
+
+    if (!this->commit())
+    {
+        return false;
+    }
+
+    std::map<uint64_t, Object *> ordered(this->objects.begin(), this->objects.end());
+    std::string data;
+    BinaryWriter writer(data);
+
+    writer.putU32(CHECKPOINT_MAGIC);
+    writer.putU32(CHECKPOINT_VERSION);
+    writer.putU64(this->lsn);
+    writer.putU64(this->nextKey);
+    writer.putU64(ordered.size());
+
+    for (auto &it : ordered)
+    {
+        writer.putU64(it.first);
+        writer.putU32(it.second->getObjectType());
+        writer.putString(it.second->getId());
+        this->writeObject(it.second, writer);
+    }
+
+    std::string edges;
+    BinaryWriter edgeWriter(edges);
+    uint64_t edgeCount = 0;
+
+    for (auto &it : ordered)
+    {
+        it.second->getMaster()->forEach([&](Relationship *r) {
+            for (Object *slave : *r)
+            {
+                uint64_t slaveKey = this->getKey(slave);
+
+                if (slaveKey == 0)
+                {
+                    continue;
+                }
+
+                edgeWriter.putU64(it.first);
+                edgeWriter.putString(r->getName());
+                edgeWriter.putU8(r->getType());
+                edgeWriter.putU64(slaveKey);
+                edgeCount++;
+            }
+        });
+    }
+
+    writer.putU64(edgeCount);
+    writer.putBytes(edges.data(), edges.size());
+    writer.putU32(binaryChecksum(data.data(), data.size()));
+
+    std::string path = this->getPath(PERSISTENCE_CHECKPOINT_FILE);
+    std::string temporary = path + ".tmp";
+    int checkpointFd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (checkpointFd < 0)
+    {
+        return false;
+    }
+
+    bool ok = writeAll(checkpointFd, data) && (fsync(checkpointFd) == 0);
+
+    ::close(checkpointFd);
+
+    if (!ok || (rename(temporary.c_str(), path.c_str()) != 0))
+    {
+        return false;
+    }
+
+    syncDirectory(this->directory);
+    this->checkpointLsn = this->lsn;
+
+    /*
+     * Everything logged so far is in checkpoint, crash before
+     * truncate leaves log whose commits replay skips.
+     */
+    if (ftruncate(this->fd, 0) != 0)
+    {
+        return false;
+    }
+
+    this->logSize = 0;
+
+    return fsync(this->fd) == 0;
+}
+
+/**
+ * Commit and stop logging changes.
+ */
+void
+Persistence::close()
+{
+    PersistenceLock lock(this->mutex);
+
+    if (this->fd >= 0)
+    {
+        this->commit();
+        ::close(this->fd);
+        this->fd = -1;
+    }
+
+    if (ORM::getJournal() == this)
+    {
+        ORM::setJournal(nullptr);
+    }
+
+    this->keys.clear();
+    this->objects.clear();
+    this->dirty.clear();
+}
+
+/**
+ * Persist object created before persistence was opened,
+ * together with its relationships to persisted objects.
+ *
+ * @param o - the object.
+ */
+void
+Persistence::track(Object *o)
+{
+    PersistenceLock lock(this->mutex);
+
+    if (this->replaying || (this->fd < 0) || !o)
+    {
+        return;
+    }
+
+    if (!this->getCodec(o) || this->getKey(o))
+    {
+        return;
+    }
+
+    uint64_t key = this->nextKey++;
+    this->bind(o, key);
+
+    std::string body;
+    BinaryWriter writer(body);
+
+    writer.putU8(PERSISTENCE_RECORD_CREATE);
+    writer.putU64(key);
+    writer.putU32(o->getObjectType());
+    writer.putString(o->getId());
+    this->writeObject(o, writer);
+
+    this->record(body);
+    this->logEdges(o);
+}
+
+/**
+ * Mark object changed, its payload is written on next commit.
+ *
+ * @param o - the object.
+ */
+void
+Persistence::update(Object *o)
+{
+    PersistenceLock lock(this->mutex);
+
+    this->markDirty(o);
+}
+
+/**
+ * Register codec of object type.
+ *
+ * @param type - object type.
+ * @param codec - the codec, persistence takes ownership.
+ */
+void
+Persistence::registerCodec(eObjectType type, Codec *codec)
+{
+    this->codecs[type] = std::unique_ptr<Codec>(codec);
+}
+
+/**
+ * Get persistent key of object.
+ *
+ * @param o - the object.
+ * @return key if persisted, otherwise 0.
+ */
+uint64_t
+Persistence::getKey(Object *o)
+{
+    auto it = this->keys.find(o);
+
+    return (it != this->keys.end()) ? it->second : 0;
+}
+
+/**
+ * Get object by persistent key.
+ *
+ * @param key
+ * @return object if found, otherwise nullptr.
+ */
+Object *
+Persistence::getObject(uint64_t key)
+{
+    auto it = this->objects.find(key);
+
+    return (it != this->objects.end()) ? it->second : nullptr;
+}
+
+/**
+ * Get number of commits written to log.
+ *
+ * @return number of commits.
+ */
+size_t
+Persistence::getCommitCount()
+{
+    return this->commits;
+}
+
+/**
+ * @inherit
+ */
+void
+Persistence::onCreate(Object *o)
+{
+    this->track(o);
+}
+
+/**
+ * @inherit
+ */
+void
+Persistence::onDestroy(Object *o)
+{
+    PersistenceLock lock(this->mutex);
+    uint64_t key = this->getKey(o);
+
+    if (this->replaying || (key == 0))
+    {
+        return;
+    }
+
+    std::string body;
+    BinaryWriter writer(body);
+
+    writer.putU8(PERSISTENCE_RECORD_DESTROY);
+    writer.putU64(key);
+
+    this->record(body);
+}
+
+/**
+ * @inherit
+ */
+void
+Persistence::onChangeId(Object *o, const std::string &newId)
+{
+    PersistenceLock lock(this->mutex);
+    uint64_t key = this->getKey(o);
+
+    if (this->replaying || (key == 0))
+    {
+        return;
+    }
+
+    std::string body;
+    BinaryWriter writer(body);
+
+    writer.putU8(PERSISTENCE_RECORD_CHANGE_ID);
+    writer.putU64(key);
+    writer.putString(newId);
+
+    this->record(body);
+}
+
+/**
+ * @inherit
+ */
+void
+Persistence::onAdd(Object *master, Relationship *r, Object *slave, bool nested)
+{
+    PersistenceLock lock(this->mutex);
+    uint64_t masterKey = this->getKey(master);
+    uint64_t slaveKey = this->getKey(slave);
+
+    if (this->replaying || (masterKey == 0))
+    {
+        return;
+    }
+
+    /*
+     * Cascades are not logged, replay repeats them.
+     */
+    if (!nested && (slaveKey != 0))
+    {
+        std::string body;
+        BinaryWriter writer(body);
+
+        writer.putU8(PERSISTENCE_RECORD_ADD);
+        writer.putU64(masterKey);
+        writer.putString(r->getName());
+        writer.putU8(r->getType());
+        writer.putU64(slaveKey);
+
+        this->record(body);
+    }
+
+    this->markDirty(master);
+}
+
+/**
+ * @inherit
+ */
+void
+Persistence::onRemove(Object *master, Relationship *r, Object *slave, bool nested)
+{
+    PersistenceLock lock(this->mutex);
+    uint64_t masterKey = this->getKey(master);
+    uint64_t slaveKey = this->getKey(slave);
+
+    if (this->replaying || (masterKey == 0))
+    {
+        return;
+    }
+
+    if (!nested && (slaveKey != 0))
+    {
+        std::string body;
+        BinaryWriter writer(body);
+
+        writer.putU8(PERSISTENCE_RECORD_REMOVE);
+        writer.putU64(masterKey);
+        writer.putString(r->getName());
+        writer.putU64(slaveKey);
+
+        this->record(body);
+    }
+
+    this->markDirty(master);
+}
+
+/**
+ * @inherit
+ */
+void
+Persistence::onClear(Object *master, Relationship *r, bool nested)
+{
+    PersistenceLock lock(this->mutex);
+    uint64_t masterKey = this->getKey(master);
+
+    if (this->replaying || (masterKey == 0))
+    {
+        return;
+    }
+
+    if (!nested)
+    {
+        std::string body;
+        BinaryWriter writer(body);
+
+        writer.putU8(PERSISTENCE_RECORD_CLEAR);
+        writer.putU64(masterKey);
+        writer.putU8(r ? 0 : 1);
+        writer.putString(r ? r->getName() : std::string());
+
+        this->record(body);
+    }
+
+    this->markDirty(master);
+}
+
+/**
+ * @inherit
+ */
+void
+Persistence::onRelease(Object *o)
+{
+    PersistenceLock lock(this->mutex);
+    auto it = this->keys.find(o);
+
+    if (it == this->keys.end())
+    {
+        return;
+    }
+
+    this->objects.erase(it->second);
+    this->dirty.erase(it->second);
+    this->keys.erase(it);
+}
+
+/**
+ * The destructor.
+ */
+Persistence::~Persistence()
+{
+    this->close();
+}
+
+/**
+ * Get codec of object.
+ *
+ * @param o - the object.
+ * @return codec if registered, otherwise nullptr.
+ */
+Codec *
+Persistence::getCodec(Object *o)
+{
+    auto it = this->codecs.find(o->getObjectType());
+
+    return (it != this->codecs.end()) ? it->second.get() : nullptr;
+}
+
+/**
+ * Bind object to persistent key.
+ *
+ * @param o - the object.
+ * @param key
+ */
+void
+Persistence::bind(Object *o, uint64_t key)
+{
+    this->keys[o] = key;
+    this->objects[key] = o;
+
+    if (key >= this->nextKey)
+    {
+        this->nextKey = key + 1;
+    }
+}
+
+/**
+ * Append framed record to pending records.
+ *
+ * @param record - record body.
+ */
+void
+Persistence::append(std::string &record)
+{
+    BinaryWriter writer(this->pending);
+
+    writer.putU32(static_cast<uint32_t>(record.size()));
+    writer.putBytes(record.data(), record.size());
+    writer.putU32(binaryChecksum(record.data(), record.size()));
+
+    this->pendingRecords++;
+}
+
+/**
+ * Append record, commit when group is full.
+ *
+ * @param record - record body.
+ */
+void
+Persistence::record(std::string &record)
+{
+    this->append(record);
+
+    if (this->pendingRecords >= PERSISTENCE_GROUP_COMMIT)
+    {
+        this->commit();
+    }
+}
+
+/**
+ * Mark persisted object dirty.
+ *
+ * @param o - the object.
+ */
+void
+Persistence::markDirty(Object *o)
+{
+    uint64_t key = this->getKey(o);
+
+    if (key != 0)
+    {
+        this->dirty[key] = o;
+    }
+}
+
+/**
+ * Write length prefixed object payload.
+ *
+ * @param o - the object.
+ * @param writer
+ */
+void
+Persistence::writeObject(Object *o, BinaryWriter &writer)
+{
+    std::string payload;
+    BinaryWriter payloadWriter(payload);
+
+    this->getCodec(o)->write(o, payloadWriter, *this);
+    writer.putString(payload);
+}
+
+/**
+ * Log relationships of new persisted object to other persisted objects.
+ *
+ * @param o - the object.
+ */
+void
+Persistence::logEdges(Object *o)
+{
+    std::vector<std::pair<Relationship *, Object *>> masters;
+
+    o->getMaster()->forEach([&](Relationship *r) {
+        for (Object *slave : *r)
+        {
+            if (this->getKey(slave))
+            {
+                masters.emplace_back(r, slave);
+            }
+        }
+    });
+
+    for (auto &edge : masters)
+    {
+        this->onAdd(o, edge.first, edge.second, false);
+    }
+
+    std::vector<std::pair<Relationship *, Object *>> slaves;
+
+    o->getSlave()->forEach([&](Relationship *r) {
+        for (Object *master : *r)
+        {
+            if (this->getKey(master))
+            {
+                slaves.emplace_back(r, master);
+            }
+        }
+    });
+
+    for (auto &edge : slaves)
+    {
+        this->onAdd(edge.second, edge.first, o, false);
+    }
+}
+
+/**
+ * Load objects and relationships of last checkpoint.
+ *
+ * @return true if loaded or there is none, false if corrupted.
+ */
+bool
+Persistence::loadCheckpoint()
+{
+    std::string data;
+
+    if (!readFile(this->getPath(PERSISTENCE_CHECKPOINT_FILE), data))
+    {
+        return true;
+    }
+
+    if (data.size() < sizeof(uint32_t))
+    {
+        return false;
+    }
+
+    size_t size = data.size() - sizeof(uint32_t);
+    BinaryReader checksumReader(data.data() + size, sizeof(uint32_t));
+
+    if (checksumReader.getU32() != binaryChecksum(data.data(), size))
+    {
+        return false;
+    }
+
+    BinaryReader reader(data.data(), size);
+
+    if ((reader.getU32() != CHECKPOINT_MAGIC) || (reader.getU32() != CHECKPOINT_VERSION))
+    {
+        return false;
+    }
+
+    this->checkpointLsn = reader.getU64();
+    this->lsn = this->checkpointLsn;
+    this->nextKey = reader.getU64();
+
+    uint64_t count = reader.getU64();
+    std::vector<std::pair<Object *, std::string>> payloads;
+
+    for (uint64_t i = 0; (i < count) && reader.isOk(); i++)
+    {
+        uint64_t key = reader.getU64();
+        auto type = (eObjectType) reader.getU32();
+        std::string id = reader.getString();
+        std::string payload = reader.getString();
+
+        auto it = this->codecs.find(type);
+
+        if (!reader.isOk() || (it == this->codecs.end()))
+        {
+            continue;
+        }
+
+        BinaryReader payloadReader(payload.data(), payload.size());
+        Object *o = it->second->create(payloadReader);
+
+        if (!o)
+        {
+            continue;
+        }
+
+        if (o->getId() != id)
+        {
+            ORM::changeId(o, id);
+        }
+
+        this->bind(o, key);
+        payloads.emplace_back(o, std::move(payload));
+    }
+
+    uint64_t edgeCount = reader.getU64();
+
+    for (uint64_t i = 0; (i < edgeCount) && reader.isOk(); i++)
+    {
+        Object *master = this->getObject(reader.getU64());
+        std::string name = reader.getString();
+        auto type = (eRelationshipType) reader.getU8();
+        Object *slave = this->getObject(reader.getU64());
+
+        if (master && slave)
+        {
+            master->getMaster()->init(name, type);
+            master->getMaster()->add(name, slave);
+        }
+    }
+
+    for (auto &it : payloads)
+    {
+        BinaryReader payloadReader(it.second.data(), it.second.size());
+
+        this->getCodec(it.first)->restore(it.first, payloadReader, *this);
+    }
+
+    return reader.isOk();
+}
+
+/**
+ * Replay committed log records, drop torn tail.
+ *
+ * @return true if success, otherwise false.
+ */
+bool
+Persistence::replayLog()
+{
+    std::string path = this->getPath(PERSISTENCE_LOG_FILE);
+    std::string data;
+
+    if (!readFile(path, data))
+    {
+        return true;
+    }
+
+    std::vector<std::pair<size_t, size_t>> batch;
+    size_t position = 0;
+    size_t committed = 0;
+
+    while (data.size() - position >= RECORD_FRAME_SIZE)
+    {
+        BinaryReader frame(data.data() + position, data.size() - position);
+        uint32_t length = frame.getU32();
+
+        if (data.size() - position - RECORD_FRAME_SIZE < length)
+        {
+            break;
+        }
+
+        const char *body = data.data() + position + sizeof(uint32_t);
+        BinaryReader checksumReader(body + length, sizeof(uint32_t));
+
+        if ((length == 0) || (checksumReader.getU32() != binaryChecksum(body, length)))
+        {
+            break;
+        }
+
+        position += RECORD_FRAME_SIZE + length;
+
+        if (body[0] != PERSISTENCE_RECORD_COMMIT)
+        {
+            batch.emplace_back(body - data.data(), length);
+            continue;
+        }
+
+        BinaryReader commitReader(body + 1, length - 1);
+        uint64_t lsn = commitReader.getU64();
+
+        /*
+         * Only complete groups not yet in checkpoint are applied.
+         */
+        if (lsn > this->checkpointLsn)
+        {
+            for (auto &record : batch)
+            {
+                BinaryReader reader(data.data() + record.first, record.second);
+                this->applyRecord(reader);
+            }
+
+            this->lsn = lsn;
+        }
+
+        batch.clear();
+        committed = position;
+    }
+
+    if (committed < data.size())
+    {
+        return truncate(path.c_str(), (off_t) committed) == 0;
+    }
+
+    return true;
+}
+
+/**
+ * Apply log record.
+ *
+ * @param reader - record body.
+ */
+void
+Persistence::applyRecord(BinaryReader &reader)
+{
+    auto kind = (ePersistenceRecord) reader.getU8();
+
+    switch (kind)
+    {
+        case PERSISTENCE_RECORD_CREATE:
+        {
+            uint64_t key = reader.getU64();
+            auto type = (eObjectType) reader.getU32();
+            std::string id = reader.getString();
+            std::string payload = reader.getString();
+            auto it = this->codecs.find(type);
+
+            if (!reader.isOk() || (it == this->codecs.end()))
+            {
+                break;
+            }
+
+            BinaryReader payloadReader(payload.data(), payload.size());
+            Object *o = it->second->create(payloadReader);
+
+            if (!o)
+            {
+                break;
+            }
+
+            if (o->getId() != id)
+            {
+                ORM::changeId(o, id);
+            }
+
+            this->bind(o, key);
+            break;
+        }
+        case PERSISTENCE_RECORD_DESTROY:
+        {
+            Object *o = this->getObject(reader.getU64());
+
+            if (o)
+            {
+                ORM::destroy(o);
+            }
+
+            break;
+        }
+        case PERSISTENCE_RECORD_CHANGE_ID:
+        {
+            Object *o = this->getObject(reader.getU64());
+            std::string id = reader.getString();
+
+            if (o && reader.isOk())
+            {
+                ORM::changeId(o, id);
+            }
+
+            break;
+        }
+        case PERSISTENCE_RECORD_ADD:
+        {
+            Object *master = this->getObject(reader.getU64());
+            std::string name = reader.getString();
+            auto type = (eRelationshipType) reader.getU8();
+            Object *slave = this->getObject(reader.getU64());
+
+            if (master && slave)
+            {
+                master->getMaster()->init(name, type);
+                master->getMaster()->add(name, slave);
+            }
+
+            break;
+        }
+        case PERSISTENCE_RECORD_REMOVE:
+        {
+            Object *master = this->getObject(reader.getU64());
+            std::string name = reader.getString();
+            Object *slave = this->getObject(reader.getU64());
+
+            if (master && slave)
+            {
+                master->getMaster()->remove(name, slave);
+            }
+
+            break;
+        }
+        case PERSISTENCE_RECORD_CLEAR:
+        {
+            Object *master = this->getObject(reader.getU64());
+            bool all = reader.getU8() != 0;
+            std::string name = reader.getString();
+
+            if (!master)
+            {
+                break;
+            }
+
+            if (all)
+            {
+                master->getMaster()->clearObjects();
+            }
+            else
+            {
+                master->getMaster()->clearObjects(name);
+            }
+
+            break;
+        }
+        case PERSISTENCE_RECORD_UPDATE:
+        {
+            Object *o = this->getObject(reader.getU64());
+            std::string payload = reader.getString();
+
+            if (o && reader.isOk())
+            {
+                BinaryReader payloadReader(payload.data(), payload.size());
+                this->getCodec(o)->restore(o, payloadReader, *this);
+            }
+
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/**
+ * Get path of file in persistence directory.
+ *
+ * @param file - file name.
+ * @return path.
+ */
+std::string
+Persistence::getPath(const char *file)
+{
+    return this->directory + "/" + file;
+}
@@ -0,0 +1,483 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <ThreadBundle/Scheduler.h>
+#include <ThreadBundle/Thread.h>
+#include <ErrorBundle/ErrorLog.h>
+#include <algorithm>
+
+/*
+ * Scheduler and worker index of calling thread, if it is a worker.
+ */
+static thread_local Scheduler *currentScheduler = nullptr;
+static thread_local size_t currentWorker = 0;
+
+/**
+ * The constructor.
+ *
+ * @param workers - number of workers, 0 for one per core.
+ */
+Scheduler::Scheduler(size_t workers) : queued(0), steals(0), sleeping(0), nextWorker(0)
+{
+    this->pending = 0;
+    this->failed = 0;
+    this->stopping = false;
+    this->timerStopping = false;
+    this->epoch = std::chrono::steady_clock::now();
+
+    if (workers == 0)
+    {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (size_t i = 0; i < workers; i++)
+    {
+        this->workers.emplace_back(new Worker());
+    }
+
+    for (size_t i = 0; i < workers; i++)
+    {
+        this->workers[i]->thread = std::thread(&Scheduler::workerLoop, this, i);
+    }
+
+    this->timer = std::thread(&Scheduler::timerLoop, this);
+}
+
+/**
+ * The destructor, stops workers. Threads not finished are not run.
+ */
+Scheduler::~Scheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->timerMutex);
+        this->timerStopping = true;
+    }
+
+    this->timerWake.notify_all();
+    this->timer.join();
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+
+    this->wake.notify_all();
+
+    for (auto &worker : this->workers)
+    {
+        worker->thread.join();
+    }
+}
+
+/**
+ * Add thread to run. Worker adds to its own deque,
+ * other callers spread threads over workers.
+ *
+ * @param thread - the thread.
+ */
+void
+Scheduler::spawn(Thread *thread)
+{
+    size_t index;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        this->pending++;
+        index = (currentScheduler == this) ? currentWorker : (this->nextWorker++ % this->workers.size());
+    }
+
+    this->push(index, thread, false);
+}
+
+/**
+ * Queue thread on worker, sleeping worker is woken to steal it.
+ * Global mutex is taken only when some worker sleeps.
+ *
+ * @param index - worker index.
+ * @param thread - the thread.
+ * @param front - queue at the front, otherwise at the back.
+ */
+void
+Scheduler::push(size_t index, Thread *thread, bool front)
+{
+    Worker &worker = *this->workers[index];
+    std::deque<Thread *> &deque = worker.deques[thread->getPriority()];
+
+    {
+        std::lock_guard<std::mutex> dequeLock(worker.mutex);
+
+        if (front)
+        {
+            deque.push_front(thread);
+        }
+        else
+        {
+            deque.push_back(thread);
+        }
+
+        this->queued++;
+    }
+
+    /*
+     * Worker going to sleep counts itself before it checks queued,
+     * here queued is counted before sleeping is checked. Either side
+     * sees the other, mutex orders notify after worker waits.
+     */
+    if (this->sleeping.load() > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+        }
+
+        this->wake.notify_one();
+    }
+}
+
+/**
+ * Take thread from own deques, otherwise steal one. Thread of higher
+ * priority is taken first, also when stealing, unless own lower
+ * priority was passed over SCHEDULER_AGING times.
+ *
+ * @param index - worker index.
+ * @return thread if any, otherwise nullptr.
+ */
+Thread *
+Scheduler::take(size_t index)
+{
+    Thread *thread = nullptr;
+
+    {
+        Worker &own = *this->workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        int priority = THREAD_PRIORITY_COUNT - 1;
+
+        for (int aged = 0; aged < THREAD_PRIORITY_COUNT - 1; aged++)
+        {
+            if ((own.skipped[aged] >= SCHEDULER_AGING) && !own.deques[aged].empty())
+            {
+                priority = aged;
+                break;
+            }
+        }
+
+        for (; priority >= 0; priority--)
+        {
+            std::deque<Thread *> &deque = own.deques[priority];
+
+            if (!deque.empty())
+            {
+                thread = deque.back();
+                deque.pop_back();
+                this->queued--;
+                own.skipped[priority] = 0;
+
+                for (int lower = 0; lower < priority; lower++)
+                {
+                    own.skipped[lower] = own.deques[lower].empty() ? 0 : own.skipped[lower] + 1;
+                }
+
+                return thread;
+            }
+        }
+    }
+
+    for (int priority = THREAD_PRIORITY_COUNT - 1; priority >= 0; priority--)
+    {
+        for (size_t i = 1; i < this->workers.size(); i++)
+        {
+            Worker &victim = *this->workers[(index + i) % this->workers.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            std::deque<Thread *> &deque = victim.deques[priority];
+
+            if (!deque.empty())
+            {
+                thread = deque.front();
+                deque.pop_front();
+                this->queued--;
+                this->steals++;
+
+                return thread;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * Record finished thread.
+ *
+ * @param thread - the thread.
+ * @param failed - thread ended with error.
+ */
+void
+Scheduler::complete(Thread *thread, bool failed)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->finished.push_back(thread);
+    this->failed += failed;
+
+    if (--this->pending == 0)
+    {
+        this->idle.notify_all();
+    }
+}
+
+/**
+ * Worker loop, runs threads in quanta.
+ *
+ * @param index - worker index.
+ */
+void
+Scheduler::workerLoop(size_t index)
+{
+    currentScheduler = this;
+    currentWorker = index;
+
+    while (true)
+    {
+        Thread *thread = this->take(index);
+
+        if (!thread)
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+
+            this->sleeping++;
+            this->wake.wait(lock, [this]() {
+                return this->stopping || (this->queued.load() > 0);
+            });
+            this->sleeping--;
+
+            if (this->stopping)
+            {
+                return;
+            }
+
+            continue;
+        }
+
+        switch (thread->execute())
+        {
+            case THREAD_STATE_READY:
+                this->push(index, thread, true);
+                break;
+            case THREAD_STATE_SLEEPING:
+                this->park(thread);
+                break;
+            case THREAD_STATE_ERROR:
+                /*
+                 * Error belongs to thread, worker goes on clean.
+                 */
+                ERROR_LOG_CLEAR;
+                this->complete(thread, true);
+                break;
+            default:
+                this->complete(thread, false);
+                break;
+        }
+    }
+}
+
+/**
+ * Convert time to tick. Deadline is rounded up and current time down,
+ * so thread never wakes early.
+ *
+ * @param time - the time.
+ * @param roundUp - round up, otherwise down.
+ * @return tick.
+ */
+uint64_t
+Scheduler::toTick(std::chrono::steady_clock::time_point time, bool roundUp)
+{
+    if (time <= this->epoch)
+    {
+        return 0;
+    }
+
+    uint64_t elapsed = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(time - this->epoch).count();
+
+    return roundUp ? ((elapsed + 999999) / 1000000) : (elapsed / 1000000);
+}
+
+/**
+ * Park sleeping thread in timer wheel.
+ *
+ * @param thread - the thread.
+ */
+void
+Scheduler::park(Thread *thread)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->timerMutex);
+        this->wheel.add(thread, this->toTick(thread->getWakeTime(), true));
+    }
+
+    this->timerWake.notify_one();
+}
+
+/**
+ * Timer loop, queues threads whose wake time passed. Sleeps until
+ * next timer, without timers until thread is parked.
+ */
+void
+Scheduler::timerLoop()
+{
+    std::unique_lock<std::mutex> lock(this->timerMutex);
+    std::vector<Thread *> expired;
+
+    while (!this->timerStopping)
+    {
+        auto now = std::chrono::steady_clock::now();
+        this->wheel.advance(this->toTick(now, false), expired);
+
+        /*
+         * Thread whose wake time is not reached is parked again.
+         */
+        auto early = std::remove_if(expired.begin(), expired.end(), [this, now](Thread *thread) {
+            if (now >= thread->getWakeTime())
+            {
+                return false;
+            }
+
+            this->wheel.add(thread, this->toTick(thread->getWakeTime(), true));
+            return true;
+        });
+        expired.erase(early, expired.end());
+
+        if (!expired.empty())
+        {
+            lock.unlock();
+
+            for (Thread *thread : expired)
+            {
+                thread->wake();
+                this->push(this->nextWorker++ % this->workers.size(), thread, false);
+            }
+
+            expired.clear();
+            lock.lock();
+            continue;
+        }
+
+        uint64_t next = this->wheel.nextExpiry();
+
+        if (next == TIMER_WHEEL_NEVER)
+        {
+            this->timerWake.wait(lock);
+        }
+        else
+        {
+            this->timerWake.wait_until(lock, this->epoch + std::chrono::milliseconds(next));
+        }
+    }
+}
+
+/**
+ * Wait until all spawned threads are finished.
+ */
+void
+Scheduler::wait()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    this->idle.wait(lock, [this]() {
+        return this->pending == 0;
+    });
+}
+
+/**
+ * Take threads finished since last call.
+ *
+ * @return finished threads.
+ */
+std::vector<Thread *>
+Scheduler::takeFinished()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    std::vector<Thread *> threads;
+
+    threads.swap(this->finished);
+
+    return threads;
+}
+
+/**
+ * Get number of workers.
+ *
+ * @return number of workers.
+ */
+size_t
+Scheduler::getWorkerCount()
+{
+    return this->workers.size();
+}
+
+/**
+ * Get number of workers sleeping for lack of threads.
+ *
+ * @return number of workers.
+ */
+size_t
+Scheduler::getSleepingCount()
+{
+    return this->sleeping.load();
+}
+
+/**
+ * Get number of threads stolen from other workers.
+ *
+ * @return number of steals.
+ */
+size_t
+Scheduler::getStealCount()
+{
+    return this->steals.load();
+}
+
+/**
+ * Get number of threads finished with error.
+ *
+ * @return number of threads.
+ */
+size_t
+Scheduler::getFailedCount()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    return this->failed;
+}
+
+/**
+ * Get number of sleeping threads parked in timer wheel.
+ *
+ * @return number of threads.
+ */
+size_t
+Scheduler::getParkedCount()
+{
+    std::lock_guard<std::mutex> lock(this->timerMutex);
+
+    return this->wheel.size();
+}
@@ -21,11 +21,13 @@
  */
 
 #include <ORM/ORM.h>
+#include <ORM/Concurrency.h>
 #include <ORM/MasterRelationships.h>
 #include <ErrorBundle/ErrorLog.h>
 #include <MethodBundle/Method.h>
 #include <ThreadBundle/Thread.h>
 #include <InterpreterBundle/Interpreter.h>
+#include <algorithm>
 #include <thread>
 
 Thread::Thread(uint64_t id, Method *m) : Object(id)
@@ -33,21 +35,41 @@ Thread::Thread(uint64_t id, Method *m) : Object(id)
     this->getMaster()->init("Thread", ONE_TO_MANY);
     this->pushMethod(m);
 
-    this->pause = false;
+    this->state = THREAD_STATE_READY;
+    this->error = STATUS_OK;
+    this->priority = THREAD_PRIORITY_NORMAL;
+    this->budget = THREAD_BUDGET;
+    this->timeSlice = THREAD_TIME_SLICE;
 }
 
+/**
+ * Execute one instruction.
+ *
+ * @return true if thread can continue, otherwise false.
+ */
 bool
 Thread::step()
 {
-    if (this->pause)
+    if (this->state == THREAD_STATE_SLEEPING)
     {
-        return true;
+        if (std::chrono::steady_clock::now() < this->wakeTime)
+        {
+            return true;
+        }
+
+        this->wake();
+    }
+
+    if (this->state != THREAD_STATE_READY)
+    {
+        return false;
     }
 
     Method *current_method = this->methodStack.top();
 
     if (current_method == nullptr)
     {
+        this->state = THREAD_STATE_FINISHED;
         return false;
     }
 
@@ -56,14 +78,18 @@ Thread::step()
     switch (instruction_result)
     {
         case INSTRUCTION_OK:
-        case INSTRUCTION_FINISHED:
         {
             return true;
         }
+        case INSTRUCTION_FINISHED:
+        {
+            this->state = THREAD_STATE_FINISHED;
+            return false;
+        }
         case INSTRUCTION_ERROR:
         default:
         {
-            ERROR_LOG_ADD(ERROR_THREAD_INSTRUCTION_ERROR);
+            this->fail();
 
             return false;
         }
@@ -71,53 +97,285 @@ Thread::step()
 }
 
 /**
- * Run thread.
+ * Execute quantum of compiled method. Quantum ends when instruction
+ * budget or time slice runs out, clock is read only every
+ * THREAD_CLOCK_INTERVAL instructions.
+ *
+ * @return state of thread after quantum.
+ */
+eThreadState
+Thread::execute()
+{
+    if ((this->state == THREAD_STATE_SLEEPING) && (std::chrono::steady_clock::now() >= this->wakeTime))
+    {
+        this->wake();
+    }
+
+    if (this->state != THREAD_STATE_READY)
+    {
+        return this->state;
+    }
+
+    if (this->methodStack.empty() || (this->methodStack.top() == nullptr))
+    {
+        this->state = THREAD_STATE_FINISHED;
+        return this->state;
+    }
+
+    /*
+     * Objects swept by other threads stay alive until quantum ends.
+     */
+    ORM::EpochGuard guard;
+    Method *m = this->methodStack.top();
+    instruction_result result;
+
+    if (this->timeSlice == 0)
+    {
+        result = m->execute(this->budget);
+    }
+    else
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(this->timeSlice);
+        size_t budget = this->budget;
+
+        do
+        {
+            size_t chunk = std::min(budget, (size_t) THREAD_CLOCK_INTERVAL);
+
+            result = m->execute(chunk);
+            budget -= chunk;
+        }
+        while ((result == INSTRUCTION_OK) && (budget > 0) && (std::chrono::steady_clock::now() < deadline));
+    }
+
+    switch (result)
+    {
+        case INSTRUCTION_OK:
+            break;
+        case INSTRUCTION_FINISHED:
+            this->state = THREAD_STATE_FINISHED;
+            break;
+        case INSTRUCTION_ERROR:
+        default:
+            this->fail();
+            break;
+    }
+
+    return this->state;
+}
+
+/**
+ * Put thread in error state. Error logged by failing instruction is
+ * kept with thread, log of worker may be cleared afterwards.
+ */
+void
+Thread::fail()
+{
+    if (this->error == STATUS_OK)
+    {
+        this->error = ERROR_LOG_IS_EMPTY ? ERROR_THREAD_INSTRUCTION_ERROR : ERROR_LOG_LAST_ERROR;
+    }
+
+    ERROR_LOG_ADD(ERROR_THREAD_INSTRUCTION_ERROR);
+    this->state = THREAD_STATE_ERROR;
+}
+
+/**
+ * Get state of thread.
+ *
+ * @return thread state.
+ */
+eThreadState
+Thread::getState()
+{
+    return this->state;
+}
+
+/**
+ * Get first error thread failed with.
+ *
+ * @return error, STATUS_OK if thread did not fail.
+ */
+eErrorStatus
+Thread::getError()
+{
+    return this->error;
+}
+
+/**
+ * Set budget of quantum.
+ *
+ * @param instructions - number of instructions, at least 1.
+ * @param microseconds - wall time, 0 for no limit.
+ */
+void
+Thread::setBudget(size_t instructions, uint64_t microseconds)
+{
+    this->budget = std::max(instructions, (size_t) 1);
+    this->timeSlice = microseconds;
+}
+
+/**
+ * Get number of instructions of quantum.
+ *
+ * @return number of instructions.
+ */
+size_t
+Thread::getBudget()
+{
+    return this->budget;
+}
+
+/**
+ * Get wall time of quantum.
+ *
+ * @return microseconds, 0 for no limit.
+ */
+uint64_t
+Thread::getTimeSlice()
+{
+    return this->timeSlice;
+}
+
+/**
+ * Set priority, it takes effect when thread is queued next time.
+ *
+ * @param priority - the priority.
+ */
+void
+Thread::setPriority(eThreadPriority priority)
+{
+    this->priority = priority;
+}
+
+/**
+ * Get priority.
+ *
+ * @return priority.
+ */
+eThreadPriority
+Thread::getPriority()
+{
+    return this->priority;
+}
+
+/**
+ * Run thread, calling thread is blocked while it sleeps.
+ * OS thread is yielded whenever quantum runs out.
  */
 void
 Thread::run()
 {
-    while (this->step())
-    {}
+    bool running = true;
+    size_t executed = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(this->timeSlice);
+
+    while (running)
+    {
+        if ((++executed >= this->budget)
+            || ((this->timeSlice > 0) && (executed % THREAD_CLOCK_INTERVAL == 0)
+                && (std::chrono::steady_clock::now() >= deadline)))
+        {
+            std::this_thread::yield();
+            executed = 0;
+            deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(this->timeSlice);
+        }
+
+        if (this->state == THREAD_STATE_SLEEPING)
+        {
+            std::this_thread::sleep_until(this->wakeTime);
+            this->wake();
+        }
+
+        /*
+         * Objects swept by other threads stay alive until step ends.
+         */
+        ORM::EpochGuard guard;
+
+        running = this->step();
+    }
 }
 
+/**
+ * Put thread to sleep. Scheduler parks it until wake time,
+ * it is not executed meanwhile.
+ *
+ * @param milliseconds - wall time to sleep.
+ */
 void
 Thread::sleep(uint64_t milliseconds)
 {
-    clock_t start = clock();
-
-    this->pause = true;
+    if (this->state != THREAD_STATE_READY)
+    {
+        return;
+    }
 
-    std::thread t([&]() {
-        clock_t now;
+    this->wakeTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(milliseconds);
+    this->state = THREAD_STATE_SLEEPING;
+}
 
-        do
-        { now = clock(); }
-        while (now - start < milliseconds);
+/**
+ * Wake sleeping thread.
+ */
+void
+Thread::wake()
+{
+    if (this->state == THREAD_STATE_SLEEPING)
+    {
+        this->state = THREAD_STATE_READY;
+    }
+}
 
-        this->pause = false;
-    });
+/**
+ * Get time sleeping thread wakes at.
+ *
+ * @return wake time.
+ */
+std::chrono::steady_clock::time_point
+Thread::getWakeTime()
+{
+    return this->wakeTime;
+}
 
-    t.join();
+/**
+ * Push value to stack.
+ *
+ * @param v - the value.
+ */
+void
+Thread::pushStack(Value *v)
+{
+    this->valueStack.push_back(TaggedValue::fromObject(v));
 }
 
-Value *
-Thread::popStack()
+/**
+ * Pop value from stack without boxing.
+ *
+ * @return value, null if stack is empty.
+ */
+TaggedValue
+Thread::popTagged()
 {
     if (this->valueStack.empty())
     {
-        return (Value *) ORM::getFirst(OBJECT_TYPE_NULL);
+        return TaggedValue::fromObject((Value *) ORM::getSingleton(OBJECT_TYPE_NULL));
     }
 
-    Value *v = this->valueStack.top();
-    this->valueStack.pop();
+    TaggedValue v = this->valueStack.back();
+    this->valueStack.pop_back();
 
     return v;
 }
 
+/**
+ * Push value to stack without boxing.
+ *
+ * @param v - the value.
+ */
 void
-Thread::pushStack(Value *v)
+Thread::pushTagged(TaggedValue v)
 {
-    this->valueStack.push(v);
+    this->valueStack.push_back(v);
 }
 
 void
@@ -146,7 +404,7 @@ Thread::popMethod()
 Thread *
 Thread::create(uint64_t id, Method *m)
 {
-    return (Thread *)ORM::create(new Thread(id, m));
+    return ORM::create(new Thread(id, m));
 }
 
 eObjectType
@@ -0,0 +1,186 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <ThreadBundle/TimerWheel.h>
+
+/**
+ * The constructor.
+ *
+ * @param now - current tick.
+ */
+TimerWheel::TimerWheel(uint64_t now)
+{
+    this->current = now;
+    this->count = 0;
+}
+
+/**
+ * Add timer, deadline already passed expires on next tick.
+ *
+ * @param thread - sleeping thread.
+ * @param deadline - tick thread wakes at.
+ */
+void
+TimerWheel::add(Thread *thread, uint64_t deadline)
+{
+    if (deadline <= this->current)
+    {
+        deadline = this->current + 1;
+    }
+
+    this->place(Timer{thread, deadline});
+    this->count++;
+}
+
+/**
+ * Put timer in slot of level that covers its distance.
+ * Timer out of range is placed at the end of range.
+ *
+ * @param timer - the timer.
+ */
+void
+TimerWheel::place(const Timer &timer)
+{
+    uint64_t distance = timer.deadline - this->current;
+    uint64_t deadline = timer.deadline;
+
+    if (distance > TIMER_WHEEL_RANGE)
+    {
+        distance = TIMER_WHEEL_RANGE;
+        deadline = this->current + distance;
+    }
+
+    size_t level = 0;
+
+    while ((level < TIMER_WHEEL_LEVELS - 1) && (distance >= (1ULL << (TIMER_WHEEL_BITS * (level + 1)))))
+    {
+        level++;
+    }
+
+    this->slots[level][(deadline >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK].push_back(timer);
+}
+
+/**
+ * Move timers of current slot of level to levels below.
+ *
+ * @param level - the level.
+ */
+void
+TimerWheel::cascade(size_t level)
+{
+    std::vector<Timer> timers;
+
+    timers.swap(this->slots[level][(this->current >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK]);
+
+    for (const Timer &timer : timers)
+    {
+        this->place(timer);
+    }
+}
+
+/**
+ * Process ticks up to now.
+ *
+ * @param now - current tick.
+ * @param expired - threads whose deadline passed, appended.
+ */
+void
+TimerWheel::advance(uint64_t now, std::vector<Thread *> &expired)
+{
+    while (this->current < now)
+    {
+        if (this->count == 0)
+        {
+            this->current = now;
+            return;
+        }
+
+        this->current++;
+
+        /*
+         * Levels above are moved down first, they can fill level below.
+         */
+        for (size_t level = TIMER_WHEEL_LEVELS - 1; level > 0; level--)
+        {
+            if ((this->current & ((1ULL << (TIMER_WHEEL_BITS * level)) - 1)) == 0)
+            {
+                this->cascade(level);
+            }
+        }
+
+        std::vector<Timer> &slot = this->slots[0][this->current & TIMER_WHEEL_MASK];
+
+        for (const Timer &timer : slot)
+        {
+            expired.push_back(timer.thread);
+        }
+
+        this->count -= slot.size();
+        slot.clear();
+    }
+}
+
+/**
+ * Get tick by which advance must be called next. It is the next
+ * deadline, or earlier tick where levels above are moved down.
+ *
+ * @return tick, TIMER_WHEEL_NEVER if there are no timers.
+ */
+uint64_t
+TimerWheel::nextExpiry()
+{
+    if (this->count == 0)
+    {
+        return TIMER_WHEEL_NEVER;
+    }
+
+    for (uint64_t tick = this->current + 1;; tick++)
+    {
+        if (!this->slots[0][tick & TIMER_WHEEL_MASK].empty() || ((tick & TIMER_WHEEL_MASK) == 0))
+        {
+            return tick;
+        }
+    }
+}
+
+/**
+ * Get last processed tick.
+ *
+ * @return tick.
+ */
+uint64_t
+TimerWheel::getCurrent()
+{
+    return this->current;
+}
+
+/**
+ * Get number of timers.
+ *
+ * @return number of timers.
+ */
+size_t
+TimerWheel::size()
+{
+    return this->count;
+}
@@ -36,6 +36,7 @@
 #include <VariableBundle/Null/Null.h>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 #define MAX_SCAN_SIZE (8192)
 
@@ -104,6 +105,11 @@ Collection::operator[](std::string index)
 void
 Collection::insert(std::string index, Value *o)
 {
+    if (ORM::checkFrozen(this))
+    {
+        return;
+    }
+
     this->removeData(index);
     this->insertData(index, o);
 }
@@ -156,13 +162,12 @@ Collection::toString()
 void
 Collection::clear()
 {
-    Relationship *r = this->getMaster()->get("Collection");
-
-    while (!r->empty())
+    if (ORM::checkFrozen(this))
     {
-        this->removeData((Value *) r->front());
+        return;
     }
 
+    this->getMaster()->clearObjects("Collection");
     this->data_cache.clear();
 }
 
@@ -185,7 +190,7 @@ Collection::removeData(std::string index)
 void
 Collection::removeData(Value *o)
 {
-    if (!o)
+    if (!o || ORM::checkFrozen(this))
     {
         return;
     }
@@ -202,6 +207,11 @@ Collection::removeData(Value *o)
 void
 Collection::insertData(std::string index, Value *o)
 {
+    if (ORM::checkFrozen(this))
+    {
+        return;
+    }
+
     if (o == nullptr)
     {
         ERROR_LOG_ADD(ERROR_METHOD_ADDING_NULL_DATA);
@@ -235,7 +245,7 @@ Collection::insertData(std::string index, Value *o)
             default:
             case OBJECT_TYPE_NULL:
                 ERROR_LOG_ADD(ERROR_PRIMITIVE_DATA_INVALID_DATA_TYPE);
-                newData = (Null *) ORM::getFirst(OBJECT_TYPE_NULL);
+                newData = (Null *) ORM::getSingleton(OBJECT_TYPE_NULL);
         }
 
         o = newData;
@@ -262,7 +272,7 @@ Collection::~Collection()
 Collection *
 Collection::create(Collection *c)
 {
-    return (Collection *) ORM::create((Object *) new Collection(c));
+    return ORM::create(new Collection(c));
 }
 
 /**
@@ -414,9 +424,20 @@ Collection::operator--()
 void
 Collection::parseStream(std::wstring input)
 {
+    if (ORM::checkFrozen(this))
+    {
+        return;
+    }
+
     std::wstringstream wsstream(input);
     std::wstring str;
 
+    /*
+     * Parsed values are new, they are attached at once instead of copied.
+     */
+    std::vector<Object *> parsed;
+    auto index = static_cast<uint32_t>(this->data_cache.size());
+
     while (wsstream.good())
     {
         wsstream >> str;
@@ -443,7 +464,7 @@ Collection::parseStream(std::wstring input)
                 data = String::create(str.c_str());
                 break;
             case OBJECT_TYPE_NULL:
-                data = (Null *) ORM::getFirst(OBJECT_TYPE_NULL);
+                data = (Null *) ORM::getSingleton(OBJECT_TYPE_NULL);
                 break;
             default:
             case OBJECT_TYPE_COLLECTION:
@@ -456,8 +477,19 @@ Collection::parseStream(std::wstring input)
                 continue;
         }
 
-        this->insert(static_cast<uint32_t>(this->data_cache.size()), data);
+        std::string key = std::to_string(index++);
+
+        if (this->data_cache.find(key) != this->data_cache.end())
+        {
+            this->insert(key, data);
+            continue;
+        }
+
+        this->data_cache[key] = data;
+        parsed.push_back(data);
     }
+
+    this->getMaster()->addMany("Collection", parsed);
 }
 
 /**
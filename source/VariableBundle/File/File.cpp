@@ -150,7 +150,7 @@ File::close()
 File *
 File::create(eFileMode mode, const char *fileName)
 {
-    return (File *) ORM::create(new File(mode, fileName));
+    return ORM::create(new File(mode, fileName));
 }
 
 /**
@@ -161,7 +161,7 @@ File::create(eFileMode mode, const char *fileName)
 File *
 File::create()
 {
-    return (File *) ORM::create(new File());
+    return ORM::create(new File());
 }
 
 /**
@@ -270,6 +270,17 @@ File::~File()
     this->close();
 }
 
+/**
+ * File is closed and flushed by destructor.
+ *
+ * @return true.
+ */
+bool
+File::hasObservableDestructor()
+{
+    return true;
+}
+
 /**
  * @inherit
  */
@@ -144,7 +144,10 @@ Null::getString()
 Null *
 Null::create()
 {
-    return (Null *) ORM::create(new Null());
+    auto *null = ORM::create(new Null());
+    ORM::registerSingleton(null);
+
+    return null;
 }
 
 /**
@@ -69,7 +69,7 @@ Bool::Bool(bool value) : Primitive(OBJECT_TYPE_BOOL, &value)
 Bool *
 Bool::create(const void *value)
 {
-    return (Bool *) ORM::create((Object *) new Bool(value));
+    return ORM::create(new Bool(value));
 }
 
 /**
@@ -91,7 +91,7 @@ Bool::create(bool value)
 Bool *
 Bool::create(Bool &data)
 {
-    return (Bool *) ORM::create((Object *) new Bool(data));
+    return ORM::create(new Bool(data));
 }
 
 /**
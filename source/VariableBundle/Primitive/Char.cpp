@@ -60,7 +60,7 @@ Char::Char(Char &data) : Primitive::Primitive(data)
 Char *
 Char::create(const void *value)
 {
-    return (Char *) ORM::create((Object *) new Char(value));
+    return ORM::create(new Char(value));
 }
 
 /**
@@ -72,7 +72,7 @@ Char::create(const void *value)
 Char *
 Char::create(Char &data)
 {
-    return (Char *) ORM::create((Object *) new Char(data));
+    return ORM::create(new Char(data));
 }
 
 /**
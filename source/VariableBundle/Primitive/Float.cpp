@@ -68,7 +68,7 @@ Float::Float(Float &data) : Primitive(data)
 Float *
 Float::create(const void *value)
 {
-    return (Float *) ORM::create((Object *) new Float(value));
+    return ORM::create(new Float(value));
 }
 
 /**
@@ -80,7 +80,7 @@ Float::create(const void *value)
 Float *
 Float::create(Float &data)
 {
-    return (Float *) ORM::create((Object *) new Float(data));
+    return ORM::create(new Float(data));
 }
 
 /**
@@ -217,5 +217,5 @@ Primitive::isPrimitive(Value *data)
 VirtualMemory *
 Primitive::getVirtualMemory()
 {
-    return (VirtualMemory *) ORM::getFirst(OBJECT_TYPE_VIRTUAL_MEMORY);
+    return (VirtualMemory *) ORM::getSingleton(OBJECT_TYPE_VIRTUAL_MEMORY);
 }
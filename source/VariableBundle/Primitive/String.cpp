@@ -61,7 +61,7 @@ String::String(String &data) : Primitive::Primitive(data)
 String *
 String::create(const void *value)
 {
-    return (String *) ORM::create((Object *) new String(value));
+    return ORM::create(new String(value));
 }
 
 /**
@@ -72,7 +72,7 @@ String::create(const void *value)
 String *
 String::create(String &data)
 {
-    return (String *) ORM::create((Object *) new String(data));
+    return ORM::create(new String(data));
 }
 
 /**
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <VariableBundle/TaggedValue.h>
+#include <VariableBundle/Value.h>
+#include <VariableBundle/Primitive/Primitive.h>
+
+/**
+ * Unbox value, scalars are read out of their objects.
+ *
+ * @param value - the value.
+ * @return tagged value.
+ */
+TaggedValue
+TaggedValue::unbox(Value *value)
+{
+    switch (value->getObjectType())
+    {
+        case OBJECT_TYPE_INT:
+            return TaggedValue::fromInt(value->toInt());
+        case OBJECT_TYPE_FLOAT:
+            return TaggedValue::fromFloat(value->toFloat());
+        case OBJECT_TYPE_BOOL:
+            return TaggedValue::fromBool(value->toBool());
+        case OBJECT_TYPE_CHAR:
+            return TaggedValue::fromChar(value->toChar());
+        default:
+            return TaggedValue::fromObject(value);
+    }
+}
+
+/**
+ * Get type of value.
+ *
+ * @return object type, OBJECT_TYPE_NULL if empty.
+ */
+eObjectType
+TaggedValue::getType() const
+{
+    if (this->isFloat())
+    {
+        return OBJECT_TYPE_FLOAT;
+    }
+
+    if (this->isInt())
+    {
+        return OBJECT_TYPE_INT;
+    }
+
+    if (this->isBool())
+    {
+        return OBJECT_TYPE_BOOL;
+    }
+
+    if (this->isChar())
+    {
+        return OBJECT_TYPE_CHAR;
+    }
+
+    if (this->isObject())
+    {
+        return this->asObject()->getObjectType();
+    }
+
+    return OBJECT_TYPE_NULL;
+}
+
+/**
+ * Box value, scalar gets new object.
+ *
+ * @return value object, nullptr if empty.
+ */
+Value *
+TaggedValue::box() const
+{
+    if (this->isFloat())
+    {
+        double value = this->asFloat();
+        return Primitive::create(OBJECT_TYPE_FLOAT, &value);
+    }
+
+    if (this->isInt())
+    {
+        int32_t value = this->asInt();
+        return Primitive::create(OBJECT_TYPE_INT, &value);
+    }
+
+    if (this->isBool())
+    {
+        bool value = this->asBool();
+        return Primitive::create(OBJECT_TYPE_BOOL, &value);
+    }
+
+    if (this->isChar())
+    {
+        wchar_t value = this->asChar();
+        return Primitive::create(OBJECT_TYPE_CHAR, &value);
+    }
+
+    if (this->isObject())
+    {
+        return this->asObject();
+    }
+
+    return nullptr;
+}
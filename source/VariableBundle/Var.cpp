@@ -40,7 +40,7 @@ Var::Var(std::string id, Value *v) : Object::Object(std::move(id))
 
     if (v == nullptr)
     {
-        v = dynamic_cast<Value *>(ORM::getFirst(OBJECT_TYPE_NULL));
+        v = static_cast<Value *>(ORM::getSingleton(OBJECT_TYPE_NULL));
     }
 
     master->add("val", v);
@@ -55,7 +55,7 @@ Var::Var(std::string id, Value *v) : Object::Object(std::move(id))
 Var *
 Var::create(std::string id, Value *container)
 {
-    return dynamic_cast<Var *>(ORM::create(new Var(std::move(id), container)));
+    return ORM::create(new Var(std::move(id), container));
 }
 
 /**
@@ -66,7 +66,7 @@ Var::create(std::string id, Value *container)
 Value *
 Var::get()
 {
-    return dynamic_cast<Value *>(this->getMaster()->front("val"));
+    return static_cast<Value *>(this->getMaster()->front("val"));
 }
 
 /**
@@ -79,7 +79,7 @@ Var::set(Value *v)
 {
     if (v == nullptr)
     {
-        v = dynamic_cast<Value *>(ORM::getFirst(OBJECT_TYPE_NULL));
+        v = static_cast<Value *>(ORM::getSingleton(OBJECT_TYPE_NULL));
     }
 
     Value *v1 = this->get();
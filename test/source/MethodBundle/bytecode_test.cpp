@@ -0,0 +1,758 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <ORM/ORM.h>
+#include <ErrorBundle/ErrorLog.h>
+#include <MemoryBundle/VirtualMemory.h>
+#include <VariableBundle/Var.h>
+#include <VariableBundle/Null/Null.h>
+#include <VariableBundle/Primitive/Int.h>
+#include <VariableBundle/Primitive/Float.h>
+#include <VariableBundle/Primitive/String.h>
+#include <VariableBundle/TaggedValue.h>
+#include <MethodBundle/Instruction/CreateInstruction.h>
+#include <MethodBundle/Instruction/AssignInstruction.h>
+#include <MethodBundle/Instruction/PushConstantInstruction.h>
+#include <MethodBundle/Instruction/ArithmeticInstruction.h>
+#include <MethodBundle/Method.h>
+#include <ThreadBundle/Thread.h>
+#include <ORM/Repository.h>
+#include <ConstantBundle/Constants.h>
+#include "../../include/MethodBundle/bytecode_test.h"
+#include "../../test_assert.h"
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+static VirtualMemory *vm;
+
+/**
+ * bytecode test compile.
+ */
+static void
+bytecode_test_compile()
+{
+    ERROR_LOG_CLEAR;
+    std::vector<Instruction *> instructions;
+
+    instructions.push_back(CreateInstruction::create(L"int_name", L"int"));
+    instructions.push_back(CreateInstruction::create(L"collection_name", L"Collection"));
+    instructions.push_back(AssignInstruction::create(L"int_name"));
+
+    Method *foo = Method::create("foo", instructions);
+    Thread::create(0, foo);
+    ASSERT_FALSE(foo->isCompiled(), "method should not be compiled");
+    ASSERT_TRUE(foo->compile(), "method should compile");
+    ASSERT_TRUE(foo->isCompiled(), "method should be compiled");
+
+    ASSERT_EQUALS(foo->step(), INSTRUCTION_OK);
+    ASSERT_NOT_NULL(foo->getVar(L"int_name"));
+    ASSERT_VIRTUAL_MEMORY(*vm, DataType::SIZE[OBJECT_TYPE_INT]);
+
+    ASSERT_EQUALS(foo->step(), INSTRUCTION_OK);
+    ASSERT_NOT_NULL(foo->getVar(L"collection_name"));
+
+    /*
+     * Empty stack pops null.
+     */
+    ASSERT_EQUALS(foo->step(), INSTRUCTION_FINISHED);
+    ASSERT_EQUALS(foo->getVar(L"int_name")->get()->getObjectType(), OBJECT_TYPE_NULL);
+    ASSERT_OK;
+
+    ASSERT_EQUALS(foo->step(), INSTRUCTION_ERROR);
+
+    /*
+     * Cleared method runs again from the start.
+     */
+    foo->clear();
+    ASSERT_NULL(foo->getVar(L"int_name"));
+    ASSERT_EQUALS(foo->run(), INSTRUCTION_FINISHED);
+    ASSERT_NOT_NULL(foo->getVar(L"collection_name"));
+    ASSERT_OK;
+}
+
+/**
+ * bytecode test compile negative.
+ */
+static void
+bytecode_test_compile_negative()
+{
+    ERROR_LOG_CLEAR;
+    std::vector<Instruction *> instructions;
+    Method *foo;
+
+    instructions.push_back(CreateInstruction::create(L"int", L"int"));
+    foo = Method::create("foo", instructions);
+    ASSERT_FALSE(foo->compile(), "invalid name should not compile");
+    ASSERT_ERROR(ERROR_INSTRUCTION_INVALID_OBJECT_NAME);
+    ASSERT_FALSE(foo->isCompiled(), "method should not be compiled");
+    ORM_DESTROY(foo);
+    ERROR_LOG_CLEAR;
+
+    std::vector<std::wstring> arg;
+    arg.emplace_back(L"1x");
+    instructions.clear();
+    instructions.push_back(PushConstantInstruction::create(arg));
+    foo = Method::create("foo", instructions);
+    ASSERT_FALSE(foo->compile(), "invalid constant should not compile");
+    ASSERT_ERROR(ERROR_CONSTANT_UNDEFINED);
+    ERROR_LOG_CLEAR;
+
+    /*
+     * Interpreted instruction decodes constant number on validation.
+     */
+    ASSERT_NULL(instructions[0]->executeIt());
+    ASSERT_ERROR(ERROR_CONSTANT_UNDEFINED);
+    ORM_DESTROY(foo);
+    ERROR_LOG_CLEAR;
+
+    /*
+     * Constant pool is reached through thread.
+     */
+    arg.clear();
+    arg.emplace_back(L"0");
+    instructions.clear();
+    instructions.push_back(PushConstantInstruction::create(arg));
+    foo = Method::create("foo", instructions);
+    ASSERT_TRUE(foo->compile(), "method should compile");
+    ASSERT_EQUALS(foo->run(), INSTRUCTION_ERROR);
+    ASSERT_ERROR(ERROR_METHOD_NOT_PART_OF_THREAD);
+    ORM_DESTROY(foo);
+    ERROR_LOG_CLEAR;
+}
+
+/**
+ * bytecode test frame.
+ */
+static void
+bytecode_test_frame()
+{
+    ERROR_LOG_CLEAR;
+    std::vector<Instruction *> instructions;
+
+    instructions.push_back(CreateInstruction::create(L"a", L"int"));
+    instructions.push_back(CreateInstruction::create(L"b", L"float"));
+    instructions.push_back(AssignInstruction::create(L"a"));
+
+    Method *foo = Method::create("foo", instructions);
+    Thread::create(0, foo);
+    ASSERT_TRUE(foo->compile(), "method should compile");
+
+    /*
+     * Each name gets one slot, in order of first use.
+     */
+    FrameSlot *frame = foo->getFrame();
+    ASSERT_NULL(frame[0].var);
+    ASSERT_NULL(frame[1].var);
+
+    ASSERT_EQUALS(foo->run(), INSTRUCTION_FINISHED);
+    ASSERT_OK;
+
+    /*
+     * Scalar stays unboxed until assigned object or asked for variable.
+     */
+    frame = foo->getFrame();
+    ASSERT_NOT_NULL(frame[0].var);
+    ASSERT_NULL(frame[1].var);
+    ASSERT_TRUE(frame[1].value.isFloat(), "float should be unboxed");
+
+    Var *b = foo->getVar(std::string("b"));
+    ASSERT_EQUALS(frame[0].var, foo->getVar(L"a"));
+    ASSERT_EQUALS(frame[1].var, b);
+    ASSERT_TRUE(frame[1].value.isEmpty(), "float should be boxed");
+    ASSERT_EQUALS(frame[0].var->get()->getObjectType(), OBJECT_TYPE_NULL);
+    ASSERT_EQUALS(b->get()->getObjectType(), OBJECT_TYPE_FLOAT);
+
+    foo->clear();
+    ASSERT_NULL(foo->getFrame()[0].var);
+    ASSERT_NULL(foo->getVar(L"a"));
+    ASSERT_OK;
+}
+
+/**
+ * bytecode test quicken.
+ */
+static void
+bytecode_test_quicken()
+{
+    ERROR_LOG_CLEAR;
+    std::vector<Instruction *> instructions;
+
+    instructions.push_back(CreateInstruction::create(L"a", L"int"));
+    instructions.push_back(ArithmeticInstruction::create(OP_CODE_ADD, L"a"));
+    instructions.push_back(CreateInstruction::create(L"s", L"string"));
+    instructions.push_back(ArithmeticInstruction::create(OP_CODE_ADD, L"s"));
+
+    Method *foo = Method::create("foo", instructions);
+    Thread *thread = Thread::create(0, foo);
+    ASSERT_TRUE(foo->compile(), "method should compile");
+
+    Bytecode *bytecode = foo->getBytecode();
+    ASSERT_EQUALS(bytecode->at(1).op, OP_CODE_ADD);
+
+    /*
+     * Generic form rewrites itself for types it has seen.
+     */
+    thread->pushStack(String::create(L"ab"));
+    thread->pushStack(Int::create(5));
+    ASSERT_EQUALS(foo->run(), INSTRUCTION_FINISHED);
+    ASSERT_OK;
+    ASSERT_EQUALS(foo->getVar(L"a")->get()->toInt(), 5);
+    ASSERT_TRUE(foo->getVar(L"s")->get()->getString() == L"ab", "string should be concatenated");
+    ASSERT_EQUALS(bytecode->at(1).op, OP_CODE_INT_ADD);
+    ASSERT_EQUALS(bytecode->at(3).op, OP_CODE_STRING_CONCAT);
+    ASSERT_EQUALS(bytecode->getQuickenCount(), 2);
+
+    /*
+     * Specialized form runs while guard holds.
+     */
+    foo->clear();
+    thread->pushStack(String::create(L"cd"));
+    thread->pushStack(Int::create(7));
+    ASSERT_EQUALS(foo->run(), INSTRUCTION_FINISHED);
+    ASSERT_OK;
+    ASSERT_EQUALS(foo->getVar(L"a")->get()->toInt(), 7);
+    ASSERT_TRUE(foo->getVar(L"s")->get()->getString() == L"cd", "string should be concatenated");
+    ASSERT_EQUALS(bytecode->getDeoptCount(), 0);
+
+    /*
+     * Guard failure falls back to generic form.
+     */
+    foo->clear();
+    thread->pushStack(String::create(L"ef"));
+    thread->pushStack(Float::create(2.5));
+    ASSERT_EQUALS(foo->run(), INSTRUCTION_FINISHED);
+    ASSERT_OK;
+    ASSERT_EQUALS(foo->getVar(L"a")->get()->toInt(), 2);
+    ASSERT_EQUALS(bytecode->at(1).op, OP_CODE_ADD);
+    ASSERT_EQUALS(bytecode->getDeoptCount(), 1);
+
+    /*
+     * Interpreted instruction applies generic operation.
+     */
+    foo->clear();
+    ASSERT_EQUALS(foo->step(), INSTRUCTION_OK);
+    thread->pushStack(Int::create(3));
+    ASSERT_NOT_NULL(instructions[1]->executeIt());
+    ASSERT_EQUALS(foo->getVar(L"a")->get()->toInt(), 3);
+    ASSERT_OK;
+}
+
+#define BYTECODE_VARS (1000)
+
+/**
+ * bytecode test run.
+ */
+static void
+bytecode_test_run()
+{
+    ERROR_LOG_CLEAR;
+    std::vector<Instruction *> instructions;
+
+    for (int i = 0; i < BYTECODE_VARS; i++)
+    {
+        std::wstring name = L"var_" + std::to_wstring(i);
+
+        instructions.push_back(CreateInstruction::create(name, L"int"));
+    }
+
+    Method *foo = Method::create("foo", instructions);
+    ASSERT_EQUALS(foo->run(), INSTRUCTION_FINISHED);
+    ASSERT_OK;
+
+    /*
+     * Scalars are boxed into variables only when asked for.
+     */
+    ASSERT_EQUALS(ORM::Repository<Var>::count(), 0);
+    ASSERT_NOT_NULL(foo->getVar(L"var_0"));
+    ASSERT_NOT_NULL(foo->getVar(L"var_999"));
+    ASSERT_EQUALS(ORM::Repository<Var>::count(), 2);
+    ASSERT_OK;
+}
+
+#define BYTECODE_LOOP (1000)
+
+/**
+ * bytecode test tagged.
+ */
+static void
+bytecode_test_tagged()
+{
+    ERROR_LOG_CLEAR;
+
+    ASSERT_EQUALS(TaggedValue::fromInt(-7).asInt(), -7);
+    ASSERT_TRUE(TaggedValue::fromInt(-7).isInt(), "should be int");
+    ASSERT_EQUALS(TaggedValue::fromFloat(-2.5).asFloat(), -2.5);
+    ASSERT_TRUE(TaggedValue::fromFloat(-2.5).isFloat(), "should be float");
+    ASSERT_TRUE(TaggedValue::fromFloat(NAN).isFloat(), "NaN should be float");
+    ASSERT_TRUE(TaggedValue::fromBool(true).asBool(), "should be true");
+    ASSERT_EQUALS(TaggedValue::fromChar(L'x').asChar(), L'x');
+    ASSERT_EQUALS(TaggedValue().getType(), OBJECT_TYPE_NULL);
+
+    Value *boxed = TaggedValue::fromInt(42).box();
+    ASSERT_EQUALS(boxed->getObjectType(), OBJECT_TYPE_INT);
+    ASSERT_EQUALS(TaggedValue::unbox(boxed).asInt(), 42);
+    ASSERT_EQUALS(TaggedValue::fromObject(boxed).asObject(), boxed);
+    ORM::destroy(boxed);
+
+    /*
+     * Int loop runs without boxing.
+     */
+    std::vector<Instruction *> instructions;
+
+    instructions.push_back(CreateInstruction::create(L"i", L"int"));
+    instructions.push_back(CreateInstruction::create(L"s", L"string"));
+
+    for (int i = 0; i < BYTECODE_LOOP; i++)
+    {
+        instructions.push_back(ArithmeticInstruction::create(OP_CODE_ADD, L"i"));
+    }
+
+    Method *foo = Method::create("foo", instructions);
+    Thread *thread = Thread::create(0, foo);
+    ASSERT_TRUE(foo->compile(), "method should compile");
+
+    for (int i = 0; i < BYTECODE_LOOP; i++)
+    {
+        thread->pushTagged(TaggedValue::fromInt(2));
+    }
+
+    ASSERT_EQUALS(foo->step(), INSTRUCTION_OK);
+    ASSERT_EQUALS(foo->step(), INSTRUCTION_OK);
+    ASSERT_OK;
+
+    size_t vars = ORM::Repository<Var>::count();
+    size_t ints = ORM::Repository<Int>::count();
+
+    ASSERT_EQUALS(foo->run(), INSTRUCTION_FINISHED);
+    ASSERT_OK;
+    ASSERT_EQUALS(ORM::Repository<Var>::count(), vars);
+    ASSERT_EQUALS(ORM::Repository<Int>::count(), ints);
+    ASSERT_EQUALS(foo->getBytecode()->at(2).op, OP_CODE_INT_ADD);
+    ASSERT_TRUE(foo->getFrame()[0].value.isInt(), "int should be unboxed");
+
+    /*
+     * Variable escapes with its value.
+     */
+    ASSERT_EQUALS(foo->getVar(L"i")->get()->toInt(), 2 * BYTECODE_LOOP);
+    ASSERT_EQUALS(ORM::Repository<Int>::count(), ints + 1);
+
+    /*
+     * Boxed scalar on stack is read as value.
+     */
+    foo->clear();
+    thread->pushStack(Int::create(3));
+    ASSERT_EQUALS(foo->step(), INSTRUCTION_OK);
+    ASSERT_EQUALS(foo->step(), INSTRUCTION_OK);
+    ASSERT_EQUALS(foo->step(), INSTRUCTION_OK);
+    ASSERT_EQUALS(foo->getFrame()[0].value.asInt(), 3);
+    ASSERT_OK;
+
+    /*
+     * Instruction object boxes unboxed operand only for the operation.
+     */
+    ints = ORM::Repository<Int>::count();
+    thread->pushTagged(TaggedValue::fromInt(5));
+    ASSERT_NOT_NULL(instructions[2]->executeIt());
+    ASSERT_EQUALS(ORM::Repository<Int>::count(), ints);
+    ASSERT_OK;
+}
+
+/**
+ * bytecode test overflow.
+ */
+static void
+bytecode_test_overflow()
+{
+    ERROR_LOG_CLEAR;
+    std::vector<Instruction *> instructions;
+
+    instructions.push_back(CreateInstruction::create(L"a", L"int"));
+    instructions.push_back(AssignInstruction::create(L"a"));
+    instructions.push_back(ArithmeticInstruction::create(OP_CODE_ADD, L"a"));
+    instructions.push_back(ArithmeticInstruction::create(OP_CODE_SUB, L"a"));
+    instructions.push_back(ArithmeticInstruction::create(OP_CODE_MUL, L"a"));
+
+    Method *foo = Method::create("foo", instructions);
+    Thread *thread = Thread::create(0, foo);
+    ASSERT_TRUE(foo->compile(false), "method should compile");
+
+    /*
+     * Second run executes quickened int operations.
+     */
+    for (int run = 0; run < 2; run++)
+    {
+        foo->clear();
+        thread->pushTagged(TaggedValue::fromInt(2));
+        thread->pushTagged(TaggedValue::fromInt(1));
+        thread->pushTagged(TaggedValue::fromInt(1));
+        thread->pushTagged(TaggedValue::fromInt(INT32_MAX));
+        ASSERT_EQUALS(foo->run(), INSTRUCTION_FINISHED);
+        ASSERT_OK;
+    }
+
+    ASSERT_EQUALS(foo->getBytecode()->at(2).op, OP_CODE_INT_ADD);
+    ASSERT_EQUALS(foo->getBytecode()->at(3).op, OP_CODE_INT_SUB);
+    ASSERT_EQUALS(foo->getBytecode()->at(4).op, OP_CODE_INT_MUL);
+
+    /*
+     * Generic operations on boxed Int give the same result.
+     */
+    Int *boxed = Int::create(INT32_MAX);
+    Int *one = Int::create(1);
+    Int *two = Int::create(2);
+
+    ASSERT_TRUE(ArithmeticInstruction::apply(OP_CODE_ADD, *boxed, *one), "add should succeed");
+    ASSERT_EQUALS(boxed->toInt(), INT32_MIN);
+    ASSERT_TRUE(ArithmeticInstruction::apply(OP_CODE_SUB, *boxed, *one), "subtract should succeed");
+    ASSERT_TRUE(ArithmeticInstruction::apply(OP_CODE_MUL, *boxed, *two), "multiply should succeed");
+
+    /*
+     * Both wrap around, INT32_MAX + 1 - 1 is INT32_MAX again
+     * and doubled it is -2.
+     */
+    ASSERT_EQUALS(boxed->toInt(), -2);
+    ASSERT_EQUALS(foo->getVar(L"a")->get()->toInt(), boxed->toInt());
+    ASSERT_OK;
+}
+
+/**
+ * Create arithmetic program over constant pool.
+ * Each operation adds constant to variable.
+ *
+ * @param operations - number of operations.
+ * @return method.
+ */
+static Method *
+bytecode_test_program(int operations)
+{
+    std::vector<Instruction *> instructions;
+
+    instructions.push_back(CreateInstruction::create(L"i", L"int"));
+    instructions.push_back(CreateInstruction::create(L"f", L"float"));
+
+    for (int i = 0; i < operations; i++)
+    {
+        /*
+         * Instruction takes over its arguments.
+         */
+        std::vector<std::wstring> one;
+        std::vector<std::wstring> half;
+
+        one.emplace_back(L"0");
+        half.emplace_back(L"1");
+
+        instructions.push_back(PushConstantInstruction::create(one));
+        instructions.push_back(ArithmeticInstruction::create(OP_CODE_ADD, L"i"));
+        instructions.push_back(PushConstantInstruction::create(half));
+        instructions.push_back(ArithmeticInstruction::create(OP_CODE_ADD, L"f"));
+    }
+
+    return Method::create("program", instructions);
+}
+
+/**
+ * bytecode test register.
+ */
+static void
+bytecode_test_register()
+{
+    ERROR_LOG_CLEAR;
+    Constants *pool = Constants::create();
+    std::vector<std::wstring> one;
+
+    pool->add(Int::create(1));
+    pool->add(Float::create(0.5));
+    one.emplace_back(L"0");
+
+    /*
+     * Constant pushes become operands.
+     */
+    Method *foo = bytecode_test_program(2);
+    Thread *thread = Thread::create(0, foo);
+    ASSERT_TRUE(foo->compile(), "method should compile");
+    ASSERT_TRUE(foo->getBytecode()->link(pool), "method should link");
+    ASSERT_EQUALS(foo->getBytecode()->size(), 10);
+
+    ASSERT_TRUE(foo->setMode(EXECUTION_MODE_REGISTER), "mode should be set");
+    Bytecode *bytecode = foo->getBytecode();
+    ASSERT_EQUALS(bytecode->size(), 6);
+    ASSERT_EQUALS(bytecode->registerAt(2).op, OP_CODE_ADD);
+    ASSERT_EQUALS(bytecode->registerAt(2).source, REGISTER_SOURCE_CONSTANT);
+    ASSERT_EQUALS(bytecode->registerAt(3).b, 1);
+
+    ASSERT_EQUALS(foo->run(), INSTRUCTION_FINISHED);
+    ASSERT_OK;
+    ASSERT_EQUALS(bytecode->getExecutedCount(), 6);
+    ASSERT_EQUALS(foo->getFrame()[0].value.asInt(), 2);
+    ASSERT_EQUALS(foo->getFrame()[1].value.asFloat(), 1.0);
+    ASSERT_EQUALS(bytecode->registerAt(2).op, OP_CODE_INT_ADD);
+
+    /*
+     * Mode is changed only before method starts.
+     */
+    ASSERT_FALSE(foo->setMode(EXECUTION_MODE_STACK), "mode should not be set");
+    ASSERT_ERROR(ERROR_METHOD_INVALID_OPERATION);
+    ERROR_LOG_CLEAR;
+
+    foo->clear();
+    ASSERT_TRUE(foo->setMode(EXECUTION_MODE_STACK), "mode should be set");
+    ASSERT_EQUALS(foo->run(), INSTRUCTION_FINISHED);
+    ASSERT_OK;
+    ASSERT_EQUALS(bytecode->getExecutedCount(), 16);
+    ASSERT_EQUALS(foo->getFrame()[0].value.asInt(), 2);
+    ASSERT_EQUALS(foo->getFrame()[1].value.asFloat(), 1.0);
+
+    /*
+     * Value pushed before method is read from stack,
+     * constant left on stack is pushed.
+     */
+    std::vector<Instruction *> instructions;
+
+    instructions.push_back(CreateInstruction::create(L"a", L"int"));
+    instructions.push_back(AssignInstruction::create(L"a"));
+    instructions.push_back(PushConstantInstruction::create(one));
+
+    Method *bar = Method::create("bar", instructions);
+    thread = Thread::create(1, bar);
+    ASSERT_TRUE(bar->setMode(EXECUTION_MODE_REGISTER), "mode should be set");
+    ASSERT_TRUE(bar->getBytecode()->link(pool), "method should link");
+    ASSERT_EQUALS(bar->getBytecode()->registerAt(1).source, REGISTER_SOURCE_STACK);
+    ASSERT_EQUALS(bar->getBytecode()->registerAt(2).op, OP_CODE_PUSH_CONSTANT);
+
+    thread->pushTagged(TaggedValue::fromInt(9));
+    ASSERT_EQUALS(bar->run(), INSTRUCTION_FINISHED);
+    ASSERT_OK;
+    ASSERT_EQUALS(bar->getFrame()[0].value.asInt(), 9);
+    ASSERT_EQUALS(thread->popTagged().asInt(), 1);
+    ASSERT_OK;
+}
+
+/**
+ * Create push constant instruction.
+ *
+ * @param constNo - constant number.
+ * @return instruction.
+ */
+static Instruction *
+bytecode_test_push(const wchar_t *constNo)
+{
+    std::vector<std::wstring> arg;
+
+    arg.emplace_back(constNo);
+
+    return PushConstantInstruction::create(arg);
+}
+
+/**
+ * bytecode test fuse.
+ */
+static void
+bytecode_test_fuse()
+{
+    ERROR_LOG_CLEAR;
+    Constants *pool = Constants::create();
+    std::vector<Instruction *> instructions;
+
+    pool->add(Int::create(4));
+    pool->add(Float::create(1.5));
+
+    instructions.push_back(CreateInstruction::create(L"x", L"int"));
+    instructions.push_back(bytecode_test_push(L"0"));
+    instructions.push_back(AssignInstruction::create(L"x"));
+    instructions.push_back(CreateInstruction::create(L"y", L"float"));
+    instructions.push_back(bytecode_test_push(L"1"));
+    instructions.push_back(AssignInstruction::create(L"x"));
+    instructions.push_back(bytecode_test_push(L"1"));
+    instructions.push_back(AssignInstruction::create(L"y"));
+
+    /*
+     * Statement is one superinstruction.
+     */
+    Method *foo = Method::create("foo", instructions);
+    Thread::create(0, foo);
+    ASSERT_TRUE(foo->compile(), "method should compile");
+    Bytecode *bytecode = foo->getBytecode();
+    ASSERT_TRUE(bytecode->link(pool), "method should link");
+    ASSERT_EQUALS(bytecode->size(), 4);
+    ASSERT_EQUALS(bytecode->at(0).op, OP_CODE_CREATE_ASSIGN_CONSTANT);
+    ASSERT_EQUALS(bytecode->at(1).op, OP_CODE_CREATE);
+    ASSERT_EQUALS(bytecode->at(2).op, OP_CODE_ASSIGN_CONSTANT);
+    ASSERT_EQUALS(bytecode->at(2).a, 0);
+    ASSERT_EQUALS(bytecode->at(3).op, OP_CODE_ASSIGN_CONSTANT);
+
+    ASSERT_EQUALS(foo->run(), INSTRUCTION_FINISHED);
+    ASSERT_OK;
+    ASSERT_EQUALS(bytecode->getExecutedCount(), 4);
+    ASSERT_EQUALS(foo->getVar(L"x")->get()->toFloat(), 1.5);
+    ASSERT_EQUALS(foo->getVar(L"y")->get()->toFloat(), 1.5);
+
+    /*
+     * Superinstructions translate to register code.
+     */
+    foo->clear();
+    ASSERT_TRUE(foo->setMode(EXECUTION_MODE_REGISTER), "mode should be set");
+    ASSERT_EQUALS(bytecode->size(), 5);
+    ASSERT_EQUALS(foo->run(), INSTRUCTION_FINISHED);
+    ASSERT_OK;
+    ASSERT_EQUALS(foo->getFrame()[0].value.asFloat(), 1.5);
+
+    /*
+     * Profile driven fusion fuses only sequences that are hot.
+     */
+    BytecodeProfile profile;
+    instructions.clear();
+    instructions.push_back(CreateInstruction::create(L"x", L"int"));
+    instructions.push_back(bytecode_test_push(L"0"));
+    instructions.push_back(AssignInstruction::create(L"x"));
+    instructions.push_back(bytecode_test_push(L"0"));
+    instructions.push_back(AssignInstruction::create(L"x"));
+
+    Method *bar = Method::create("bar", instructions);
+    Thread::create(1, bar);
+    ASSERT_TRUE(bar->compile(false), "method should compile");
+    bytecode = bar->getBytecode();
+    ASSERT_TRUE(bytecode->link(pool), "method should link");
+    ASSERT_EQUALS(bytecode->size(), 5);
+
+    bytecode->setProfile(&profile);
+
+    for (int i = 0; i < 3; i++)
+    {
+        bar->clear();
+        ASSERT_EQUALS(bar->run(), INSTRUCTION_FINISHED);
+    }
+
+    bytecode->setProfile(nullptr);
+    ASSERT_OK;
+    ASSERT_EQUALS(profile.getCount(OP_CODE_PUSH_CONSTANT, OP_CODE_ASSIGN), 6);
+    ASSERT_EQUALS(profile.getCount(OP_CODE_CREATE, OP_CODE_PUSH_CONSTANT), 3);
+
+    ASSERT_FALSE(bar->fuse(&profile), "method should not be fused while running");
+    ASSERT_ERROR(ERROR_METHOD_INVALID_OPERATION);
+    ERROR_LOG_CLEAR;
+
+    bar->clear();
+    ASSERT_TRUE(bar->fuse(&profile, 4), "method should be fused");
+    ASSERT_EQUALS(bytecode->size(), 3);
+    ASSERT_EQUALS(bytecode->at(0).op, OP_CODE_CREATE);
+    ASSERT_EQUALS(bytecode->at(1).op, OP_CODE_ASSIGN_CONSTANT);
+
+    /*
+     * Superinstructions are not fused again.
+     */
+    ASSERT_TRUE(bar->fuse(), "method should be fused");
+    ASSERT_EQUALS(bytecode->size(), 3);
+
+    ASSERT_EQUALS(bar->run(), INSTRUCTION_FINISHED);
+    ASSERT_OK;
+    ASSERT_EQUALS(bar->getFrame()[0].value.asInt(), 4);
+}
+
+#define BYTECODE_BENCHMARK_OPERATIONS (1000)
+#define BYTECODE_BENCHMARK_RUNS (200)
+
+/**
+ * Run program in execution mode.
+ *
+ * @param m - method.
+ * @param mode - execution mode.
+ * @param instructions - number of executed instructions.
+ * @return wall time in microseconds.
+ */
+static long long
+bytecode_test_benchmark_run(Method *m, eExecutionMode mode, size_t &instructions)
+{
+    Bytecode *bytecode = m->getBytecode();
+    size_t executed = bytecode->getExecutedCount();
+
+    m->clear();
+    ASSERT_TRUE(m->setMode(mode), "mode should be set");
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < BYTECODE_BENCHMARK_RUNS; i++)
+    {
+        m->clear();
+        ASSERT_EQUALS(m->run(), INSTRUCTION_FINISHED);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    instructions = bytecode->getExecutedCount() - executed;
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+}
+
+/**
+ * bytecode test register benchmark.
+ * Same program is run in stack and register mode.
+ */
+static void
+bytecode_test_register_benchmark()
+{
+    ERROR_LOG_CLEAR;
+    Constants *pool = Constants::create();
+
+    pool->add(Int::create(1));
+    pool->add(Float::create(0.5));
+
+    Method *foo = bytecode_test_program(BYTECODE_BENCHMARK_OPERATIONS);
+    Thread::create(0, foo);
+    ASSERT_TRUE(foo->compile(), "method should compile");
+    ASSERT_TRUE(foo->getBytecode()->link(pool), "method should link");
+
+    size_t stackInstructions;
+    size_t registerInstructions;
+    long long stackTime = bytecode_test_benchmark_run(foo, EXECUTION_MODE_STACK, stackInstructions);
+    int32_t stackResult = foo->getFrame()[0].value.asInt();
+    long long registerTime = bytecode_test_benchmark_run(foo, EXECUTION_MODE_REGISTER, registerInstructions);
+    int32_t registerResult = foo->getFrame()[0].value.asInt();
+
+    printf("\t\t   stack: %zu instructions, %lld us\r\n", stackInstructions, stackTime);
+    printf("\t\tregister: %zu instructions, %lld us\r\n", registerInstructions, registerTime);
+
+    ASSERT_EQUALS(stackResult, BYTECODE_BENCHMARK_OPERATIONS);
+    ASSERT_EQUALS(registerResult, stackResult);
+    ASSERT_TRUE(registerInstructions < stackInstructions, "register mode should execute fewer instructions");
+    ASSERT_OK;
+}
+
+/**
+ * bytecode test.
+ */
+void bytecode_test()
+{
+    vm = (VirtualMemory *) ORM::getFirst(OBJECT_TYPE_VIRTUAL_MEMORY);
+    RUN_TEST_VM(bytecode_test_compile());
+    RUN_TEST_VM(bytecode_test_compile_negative());
+    RUN_TEST_VM(bytecode_test_frame());
+    RUN_TEST_VM(bytecode_test_quicken());
+    RUN_TEST_VM(bytecode_test_run());
+    RUN_TEST_VM(bytecode_test_tagged());
+    RUN_TEST_VM(bytecode_test_overflow());
+    RUN_TEST_VM(bytecode_test_register());
+    RUN_TEST_VM(bytecode_test_fuse());
+    RUN_TEST_VM(bytecode_test_register_benchmark());
+}
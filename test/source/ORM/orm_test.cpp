@@ -24,9 +24,27 @@
 #include <ORM/Relationship.h>
 #include <ORM/MasterRelationships.h>
 #include <ORM/SlaveRelationships.h>
+#include <ORM/Repository.h>
+#include <ORM/ObjectRepository.h>
+#include <ORM/ObjectPool.h>
+#include <ORM/Concurrency.h>
+#include <ORM/Handle.h>
+#include <ORM/Cascade.h>
+#include <ORM/SweepPool.h>
+#include <ORM/Introspection.h>
+#include <ORM/Transaction.h>
+#include <PersistenceBundle/BinaryStream.h>
+#include <VariableBundle/Primitive/Int.h>
+#include <MemoryBundle/Memory.h>
 #include <ErrorBundle/ErrorLog.h>
 #include "../../test_assert.h"
 #include "../../include/ORM/orm_test.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
 
 class class2;
 
@@ -106,6 +124,8 @@ public:
     }
 };
 
+ORM_TYPE_OF(class2, OBJECT_TYPE_CLASS2)
+
 /**
  * @brief orm_test_basic
  */
@@ -538,6 +558,1012 @@ static void orm_test_switch_relations2()
     ASSERT_EQUALS(r->size(), 0);
 }
 
+/**
+ * @brief orm_test_relationship_remove
+ */
+static void orm_test_relationship_remove()
+{
+    ERROR_LOG_CLEAR;
+
+    const int count = 4096;
+
+    class1 *c1 = (class1 *) ORM::create((Object *) new class1());
+    std::vector<class2 *> c2s;
+
+    for (int i = 0; i < count; i++)
+    {
+        class2 *c2 = (class2 *) ORM::create((Object *) new class2(i));
+        c1->addClass2(c2);
+        c2s.push_back(c2);
+    }
+
+    Relationship *r = c1->getMaster()->get("class1_class2");
+    ASSERT_EQUALS(r->size(), count);
+
+    /*
+     * Remove from the middle, order of the rest must stay the same.
+     */
+    for (int i = 1; i < count; i += 2)
+    {
+        c1->getMaster()->remove("class1_class2", c2s[i]);
+        ASSERT_TRUE(c2s[i]->getMarked(), "Orphaned object should be marked!");
+    }
+
+    ASSERT_EQUALS(r->size(), count / 2);
+    ASSERT_EQUALS(r->front(), c2s[0]);
+    ASSERT_EQUALS(r->back(), c2s[count - 2]);
+
+    int expected = 0;
+
+    for (Object *o : *r)
+    {
+        ASSERT_EQUALS(((class2 *) o)->number, expected);
+        expected += 2;
+    }
+
+    ASSERT_EQUALS(expected, count);
+
+    r->forEach([&](Object *e1, Object *e2) {
+        ASSERT_EQUALS(((class2 *) e2)->number, ((class2 *) e1)->number + 2);
+        return FOREACH_CONTINUE;
+    });
+
+    /*
+     * Adding after removal reuses the relationship.
+     */
+    class2 *last = (class2 *) ORM::create((Object *) new class2(count));
+    c1->addClass2(last);
+    ASSERT_EQUALS(r->size(), count / 2 + 1);
+    ASSERT_EQUALS(r->back(), last);
+
+    c1->getMaster()->clearObjects("class1_class2");
+    ASSERT_EQUALS(r->size(), 0);
+    ASSERT_NULL(r->front());
+    ASSERT_NULL(r->back());
+    ASSERT_TRUE(r->begin() == r->end(), "Empty relationship should not iterate!");
+
+    ORM_DESTROY(c1);
+
+    ASSERT_OK;
+    ASSERT_NULL(ORM::getFirst(OBJECT_TYPE_CLASS1));
+    ASSERT_NULL(ORM::getFirst(OBJECT_TYPE_CLASS2));
+}
+
+/**
+ * @brief orm_test_singleton
+ */
+static void orm_test_singleton()
+{
+    Object *null = ORM::getFirst(OBJECT_TYPE_NULL);
+    Object *vm = ORM::getFirst(OBJECT_TYPE_VIRTUAL_MEMORY);
+
+    ASSERT_NOT_NULL(null);
+    ASSERT_NOT_NULL(vm);
+    ASSERT_EQUALS(ORM::getSingleton(OBJECT_TYPE_NULL), null);
+    ASSERT_EQUALS(ORM::getSingleton(OBJECT_TYPE_VIRTUAL_MEMORY), vm);
+
+    /*
+     * Second object of the same type doesn't replace registered one.
+     */
+    Null *null2 = Null::create();
+    ASSERT_NOT_EQUALS((Object *) null2, null);
+    ASSERT_EQUALS(ORM::getSingleton(OBJECT_TYPE_NULL), null);
+
+    /*
+     * Destroyed singleton is released, next one is found on lookup.
+     */
+    ORM_DESTROY(null);
+    ASSERT_EQUALS(ORM::getSingleton(OBJECT_TYPE_NULL), (Object *) null2);
+
+    ORM_DESTROY(null2);
+    ASSERT_NULL(ORM::getSingleton(OBJECT_TYPE_NULL));
+
+    null = Null::create();
+    ASSERT_EQUALS(ORM::getSingleton(OBJECT_TYPE_NULL), null);
+
+    /*
+     * Marked object is not returned, even before it is swept.
+     */
+    null->setMarked(true);
+    null2 = Null::create();
+    ASSERT_EQUALS(ORM::getSingleton(OBJECT_TYPE_NULL), (Object *) null2);
+    null->setMarked(false);
+    ORM_DESTROY(null);
+    ASSERT_EQUALS(ORM::getSingleton(OBJECT_TYPE_NULL), (Object *) null2);
+    null = null2;
+
+    /*
+     * Type without registered singleton is looked up, not cached.
+     */
+    Int *n1 = Int::create(1);
+    Int *n2 = Int::create(2);
+    Object *first = ORM::getSingleton(OBJECT_TYPE_INT);
+    ASSERT_NOT_NULL(first);
+    first->setMarked(true);
+    ASSERT_NOT_EQUALS(ORM::getSingleton(OBJECT_TYPE_INT), first);
+    first->setMarked(false);
+    ORM_DESTROY(n1);
+    ORM_DESTROY(n2);
+
+    ORM::removeObjectRepository(OBJECT_TYPE_NULL);
+    ASSERT_NULL(ORM::getSingleton(OBJECT_TYPE_NULL));
+    ASSERT_EQUALS(ORM::getSingleton(OBJECT_TYPE_VIRTUAL_MEMORY), vm);
+}
+
+/**
+ * @brief orm_test_typed_repository
+ */
+static void orm_test_typed_repository()
+{
+    ASSERT_NULL(ORM::Repository<class2>::getFirst());
+    ASSERT_EQUALS(ORM::Repository<class2>::count(), 0);
+
+    for (int i = 0; i < 32; i++)
+    {
+        class2 *c2 = ORM::create(new class2(i));
+        ASSERT_EQUALS(c2->number, i);
+    }
+
+    ASSERT_EQUALS(ORM::Repository<class2>::count(), 32);
+    ASSERT_EQUALS(ORM::Repository<class2>::getFirst()->number, 0);
+
+    int limit = 20;
+    class2 *c2 = ORM::select<class2>([&](class2 *c) {
+        return c->number > limit;
+    });
+
+    ASSERT_NOT_NULL(c2);
+    ASSERT_EQUALS(c2->number, 21);
+
+    ORM_DESTROY(c2);
+
+    c2 = ORM::select<class2>([&](class2 *c) {
+        return c->number > limit;
+    });
+
+    ASSERT_NOT_NULL(c2);
+    ASSERT_EQUALS(c2->number, 22);
+    ASSERT_EQUALS(ORM::Repository<class2>::count(), 31);
+
+    int sum = 0;
+    ORM::forEach<class2>([&](class2 *c) {
+        sum += c->number;
+    });
+
+    ASSERT_EQUALS(sum, 31 * 32 / 2 - 21);
+
+    /*
+     * Built in types are looked up by slot.
+     */
+    ASSERT_EQUALS((Object *) ORM::Repository<Null>::getFirst(), ORM::getFirst(OBJECT_TYPE_NULL));
+    ASSERT_EQUALS((Object *) ORM::Repository<VirtualMemory>::getFirst(), ORM::getFirst(OBJECT_TYPE_VIRTUAL_MEMORY));
+}
+
+/**
+ * @brief orm_test_repository_index
+ */
+static void orm_test_repository_index()
+{
+    for (int i = 0; i < 32; i++)
+    {
+        ORM::create(new class2(i));
+    }
+
+    ObjectRepository *repository = ORM::findObjectRepository(OBJECT_TYPE_CLASS2);
+    ASSERT_NOT_NULL(repository);
+    ASSERT_NULL(repository->getIndex("remainder"));
+
+    auto *remainder = static_cast<HashIndex<int> *>(repository->addIndex("remainder", new HashIndex<int>([](Object *o) {
+        return ((class2 *) o)->number % 4;
+    })));
+    auto *ids = static_cast<OrderedIndex<std::string> *>(repository->addIndex("id", new OrderedIndex<std::string>([](Object *o) {
+        return o->getId();
+    })));
+
+    ASSERT_EQUALS(repository->getIndex("remainder"), (RepositoryIndex *) remainder);
+    ASSERT_EQUALS(remainder->size(), 32);
+    ASSERT_EQUALS(ids->size(), 32);
+
+    int count = 0;
+    remainder->forEach(3, [&](Object *o) {
+        ASSERT_EQUALS(((class2 *) o)->number % 4, 3);
+        count++;
+        return false;
+    });
+    ASSERT_EQUALS(count, 8);
+
+    /*
+     * Objects created after index are indexed too.
+     */
+    class2 *c2 = ORM::create(new class2(32));
+    ASSERT_EQUALS(remainder->size(), 33);
+    ASSERT_EQUALS(remainder->find(0) != nullptr, true);
+    ASSERT_EQUALS(ids->find("32"), (Object *) c2);
+
+    /*
+     * Change ID updates key.
+     */
+    std::string newId = "zz";
+    ORM::changeId(c2, newId);
+    ASSERT_NULL(ids->find("32"));
+    ASSERT_EQUALS(ids->find("zz"), (Object *) c2);
+    ASSERT_EQUALS(ids->lowerBound("z"), (Object *) c2);
+
+    count = 0;
+    ids->range("10", "2", [&](Object *) {
+        count++;
+        return false;
+    });
+    ASSERT_EQUALS(count, 10);
+
+    /*
+     * Destroyed objects are removed on sweep.
+     */
+    ORM_DESTROY(c2);
+    ASSERT_NULL(ids->find("zz"));
+    ASSERT_EQUALS(remainder->size(), 32);
+    ASSERT_EQUALS(ids->size(), 32);
+}
+
+/**
+ * @brief orm_test_object_pool
+ */
+static void orm_test_object_pool()
+{
+    class2 *c2 = ORM::create(new class2(1));
+    void *storage = c2;
+    size_t freeCount = ObjectPool::getFreeCount(sizeof(class2));
+
+    ORM_DESTROY(c2);
+    ASSERT_EQUALS(ObjectPool::getFreeCount(sizeof(class2)), freeCount + 1);
+
+    /*
+     * Released slot is reused by next object of same size.
+     */
+    c2 = ORM::create(new class2(2));
+    ASSERT_EQUALS((void *) c2, storage);
+    ASSERT_EQUALS(ObjectPool::getFreeCount(sizeof(class2)), freeCount);
+    ASSERT_EQUALS(c2->number, 2);
+    ASSERT_EQUALS(c2->getMaster()->get("class2_class3") != nullptr, true);
+
+    /*
+     * Pool grows when there are no free slots.
+     */
+    for (size_t i = 0; i <= freeCount; i++)
+    {
+        ORM::create(new class2(static_cast<int>(i + 3)));
+    }
+
+    ASSERT_EQUALS(ObjectPool::getFreeCount(sizeof(class2)), OBJECT_POOL_SLAB_SLOTS - 1);
+}
+
+/**
+ * @brief orm_test_relationship_table
+ */
+static void orm_test_relationship_table()
+{
+    class1 *c1 = ORM::create(new class1());
+    MasterRelationships *master = c1->getMaster();
+
+    /*
+     * Inline relationships are moved to table on third one.
+     */
+    ASSERT_NOT_NULL(master->get("class1_class2"));
+    ASSERT_NOT_NULL(master->get("class1_class1"));
+    ASSERT_NULL(master->get("class1_extra"));
+
+    master->init("class1_extra", ONE_TO_MANY);
+    master->init("class1_other", ONE_TO_ONE);
+
+    ASSERT_NOT_NULL(master->get("class1_class2"));
+    ASSERT_NOT_NULL(master->get("class1_class1"));
+    ASSERT_NOT_NULL(master->get("class1_extra"));
+    ASSERT_EQUALS(master->get("class1_other")->getType(), ONE_TO_ONE);
+
+    class2 *c2 = ORM::create(new class2(1));
+    class2 *extra = ORM::create(new class2(2));
+    class2 *other = ORM::create(new class2(3));
+
+    c1->addClass2(c2);
+    master->add("class1_extra", extra);
+    master->add("class1_other", other);
+
+    ASSERT_EQUALS(master->front("class1_extra"), (Object *) extra);
+    ASSERT_EQUALS(other->getSlave()->front("class1_other"), (Object *) c1);
+    ASSERT_TRUE(other->getSlave()->hasRelations(), "other should have relations!");
+
+    /*
+     * Destroy cascades through all relationships.
+     */
+    ORM_DESTROY(c1);
+
+    ASSERT_NULL(ORM::select(OBJECT_TYPE_CLASS2, "1"));
+    ASSERT_NULL(ORM::select(OBJECT_TYPE_CLASS2, "2"));
+    ASSERT_NULL(ORM::select(OBJECT_TYPE_CLASS2, "3"));
+}
+
+/**
+ * @brief orm_test_footprint
+ */
+static void orm_test_footprint()
+{
+    class1 *c1 = ORM::create(new class1());
+    class2 *c2 = ORM::create(new class2(1));
+    MasterRelationships *master = c1->getMaster();
+
+    /*
+     * Declared relationships aren't allocated until used.
+     */
+    ASSERT_EQUALS(master->getFootprint(), (size_t) 0);
+    ASSERT_EQUALS(c2->getSlave()->getFootprint(), (size_t) 0);
+    ASSERT_NULL(master->front("class1_class2"));
+    ASSERT_NULL(master->find("class1_class2"));
+    ASSERT_EQUALS(master->getFootprint(), (size_t) 0);
+
+    /*
+     * First objects are held inline by relationship.
+     */
+    c1->addClass2(c2);
+    c1->addClass2(ORM::create(new class2(2)));
+
+    ASSERT_EQUALS(master->getFootprint(), sizeof(Relationship));
+    ASSERT_EQUALS(c2->getSlave()->getFootprint(), sizeof(Relationship));
+
+    c1->addClass2(ORM::create(new class2(3)));
+
+    ASSERT_TRUE(master->getFootprint() > sizeof(Relationship), "relationship should allocate slots!");
+
+    ORM_DESTROY(c1);
+}
+
+/**
+ * @brief orm_test_handle
+ */
+static void orm_test_handle()
+{
+    ORM::Handle<class2> none;
+    ASSERT_NULL(none.get());
+    ASSERT_EQUALS(ORM::getHandle(nullptr).generation, 0);
+
+    class1 *c1 = ORM::create(new class1());
+    class2 *c2 = ORM::create(new class2(1));
+    c1->addClass2(c2);
+
+    ORM::Handle<class2> h(c2);
+    size_t handles = ORM::getHandleCount();
+
+    ASSERT_EQUALS(h.get(), c2);
+    ASSERT_EQUALS(h->number, 1);
+    ASSERT_TRUE(h == ORM::Handle<class2>(c2), "Object should have one handle!");
+    ASSERT_EQUALS(ORM::getHandleCount(), handles);
+
+    /*
+     * Handle becomes stale when object is freed through cascade.
+     */
+    ORM_DESTROY(c1);
+    ASSERT_NULL(h.get());
+    ASSERT_TRUE(!h, "Handle should be stale!");
+    ASSERT_EQUALS(ORM::getHandleCount(), handles - 1);
+
+    /*
+     * Slot and storage are reused, old handle stays stale.
+     */
+    class2 *reused = ORM::create(new class2(2));
+    ORM::Handle<class2> h2(reused);
+
+    ASSERT_EQUALS(h2.getRaw().index, h.getRaw().index);
+    ASSERT_TRUE(h2 != h, "Generation should differ!");
+    ASSERT_NULL(h.get());
+    ASSERT_EQUALS(h2->number, 2);
+
+    /*
+     * Threads asking for handle of same object share one slot.
+     */
+    class2 *shared = ORM::create(new class2(3));
+    ObjectHandle handlesOf[4];
+    std::vector<std::thread> threads;
+
+    handles = ORM::getHandleCount();
+
+    for (auto &handle : handlesOf)
+    {
+        threads.emplace_back([&handle, shared]() {
+            for (int i = 0; i < 1000; i++)
+            {
+                handle = ORM::getHandle(shared);
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_EQUALS(ORM::getHandleCount(), handles + 1);
+
+    for (auto &handle : handlesOf)
+    {
+        ASSERT_EQUALS(handle.index, handlesOf[0].index);
+        ASSERT_EQUALS(handle.generation, handlesOf[0].generation);
+    }
+
+    ASSERT_EQUALS(ORM::resolve(handlesOf[0]), shared);
+}
+
+#define CASCADE_CHAIN_LENGTH (100000)
+
+/**
+ * @brief orm_test_cascade
+ */
+static void orm_test_cascade()
+{
+    /*
+     * Chain is deep enough to overflow stack if destroyed recursively.
+     */
+    class2 *head = ORM::create(new class2(0));
+    class2 *tail = head;
+
+    for (int i = 1; i < CASCADE_CHAIN_LENGTH; i++)
+    {
+        class2 *next = ORM::create(new class2(i));
+
+        tail->getMaster()->init("class2_next", ONE_TO_ONE);
+        tail->getMaster()->add("class2_next", next);
+        tail = next;
+    }
+
+    ASSERT_EQUALS(ORM::Repository<class2>::count(), CASCADE_CHAIN_LENGTH);
+
+    size_t cascades = ORM::getCascadeCount();
+    ORM_DESTROY(head);
+
+    ORM::CascadeStats stats = ORM::getLastCascade();
+
+    ASSERT_EQUALS(ORM::getCascadeCount(), cascades + 1);
+    ASSERT_EQUALS(stats.objects, CASCADE_CHAIN_LENGTH);
+    ASSERT_EQUALS(stats.edges, CASCADE_CHAIN_LENGTH - 1);
+    ASSERT_EQUALS(stats.peakWorklist, 1);
+    ASSERT_EQUALS(ORM::Repository<class2>::count(), 0);
+}
+
+#define SWEEP_WORKERS (4)
+#define SWEEP_OBJECTS (1000)
+
+/**
+ * @brief orm_test_parallel_sweep
+ */
+static void orm_test_parallel_sweep()
+{
+    ERROR_LOG_CLEAR;
+    ORM::setSweepWorkers(SWEEP_WORKERS);
+    ASSERT_EQUALS(ORM::getSweepWorkers(), SWEEP_WORKERS);
+
+    /*
+     * Each repository is collected by its own task.
+     */
+    class1 *c1 = ORM::create(new class1());
+
+    for (int i = 0; i < SWEEP_OBJECTS; i++)
+    {
+        c1->addClass2(ORM::create(new class2(i)));
+        Int::create(i);
+    }
+
+    ORM_DESTROY(c1);
+    ASSERT_EQUALS(ORM::Repository<class2>::count(), 0);
+    ASSERT_NULL(ORM::getFirst(OBJECT_TYPE_CLASS1));
+
+    /*
+     * In concurrent mode reclaimed objects are destroyed by workers.
+     */
+    ORM::setConcurrent(true);
+
+    size_t offloaded = ORM::getOffloadedCount();
+    c1 = ORM::create(new class1());
+
+    for (int i = 0; i < SWEEP_OBJECTS; i++)
+    {
+        c1->addClass2(ORM::create(new class2(i)));
+    }
+
+    ORM::Handle<class2> h(static_cast<class2 *>(c1->getMaster()->front("class1_class2")));
+
+    ORM_DESTROY(c1);
+    ORM::waitDestroyed();
+
+    ASSERT_EQUALS(ORM::getRetiredCount(), 0);
+    ASSERT_EQUALS(ORM::getOffloadedCount(), offloaded + SWEEP_OBJECTS + 1);
+    ASSERT_NULL(h.get());
+
+    ORM::setConcurrent(false);
+    ORM::setSweepWorkers(0);
+    ASSERT_EQUALS(ORM::getSweepWorkers(), 0);
+    ASSERT_OK;
+}
+
+/**
+ * @brief orm_test_freeze
+ */
+static void orm_test_freeze()
+{
+    ERROR_LOG_CLEAR;
+    class1 *c1 = ORM::create(new class1());
+
+    for (int i = 0; i < 8; i++)
+    {
+        c1->addClass2(ORM::create(new class2(i)));
+    }
+
+    class2 *loose = ORM::create(new class2(100));
+    class2 *c2 = (class2 *) ORM::select(OBJECT_TYPE_CLASS2, "3");
+    size_t violations = ORM::getFrozenViolations();
+
+    /*
+     * Subgraph is frozen through master relationships.
+     */
+    ASSERT_TRUE(ORM::freeze(c1), "Subgraph should freeze!");
+    ASSERT_TRUE(c1->isFrozen(), "Root should be frozen!");
+    ASSERT_TRUE(c2->isFrozen(), "Slave should be frozen!");
+    ASSERT_TRUE(!loose->isFrozen(), "Unrelated object should not be frozen!");
+
+    c1->addClass2(loose);
+    c1->getMaster()->remove("class1_class2", c2);
+    ORM_DESTROY(c2);
+    ORM::changeId(c2, "changed");
+
+    ASSERT_EQUALS(ORM::getFrozenViolations(), violations + 4);
+    ASSERT_ERROR(ERROR_ENTITY_WRITING_FROZEN);
+    ERROR_LOG_CLEAR;
+    ASSERT_EQUALS(c1->getMaster()->get("class1_class2")->size(), 8);
+    ASSERT_EQUALS(ORM::select(OBJECT_TYPE_CLASS2, "3"), (Object *) c2);
+    ASSERT_TRUE(!loose->getSlave()->hasRelations(), "Loose object should not be added!");
+
+    /*
+     * Frozen repository is looked up in sorted array, sweep skips it.
+     */
+    ASSERT_TRUE(ORM::freeze(OBJECT_TYPE_CLASS2), "Repository should freeze!");
+    ASSERT_TRUE(loose->isFrozen(), "Repository objects should be frozen!");
+    ASSERT_NULL(ORM::create(new class2(200)));
+    ASSERT_EQUALS(ORM::getFrozenViolations(), violations + 5);
+    ASSERT_ERROR(ERROR_ENTITY_WRITING_FROZEN);
+    ERROR_LOG_CLEAR;
+
+    /*
+     * Callers can ask before building an object.
+     */
+    ASSERT_FALSE(ORM::canCreate(OBJECT_TYPE_CLASS2), "Frozen repository should refuse create!");
+    ASSERT_EQUALS(ORM::getFrozenViolations(), violations + 6);
+    ASSERT_ERROR(ERROR_ENTITY_WRITING_FROZEN);
+    ERROR_LOG_CLEAR;
+    ASSERT_TRUE(ORM::canCreate<Int>(), "Repository not frozen should allow create!");
+    ASSERT_EQUALS(ORM::Repository<class2>::count(), 9);
+    ASSERT_EQUALS(ORM::select(OBJECT_TYPE_CLASS2, "100"), (Object *) loose);
+    ASSERT_EQUALS(ORM::select(OBJECT_TYPE_CLASS2, "7")->getId(), std::string("7"));
+    ASSERT_NULL(ORM::select(OBJECT_TYPE_CLASS2, "8"));
+
+    ORM::sweep();
+    ASSERT_EQUALS(ORM::Repository<class2>::count(), 9);
+
+    /*
+     * Memory is moved by defragmentation, it is never frozen.
+     */
+    Int *n = Int::create(5);
+    ASSERT_TRUE(ORM::freeze(n), "Int should freeze!");
+    ASSERT_TRUE(!n->getMemory()->isFrozen(), "Memory should not be frozen!");
+    ASSERT_TRUE(!ORM::freeze(OBJECT_TYPE_MEMORY), "Memory repository should not freeze!");
+    ASSERT_OK;
+}
+
+#define BULK_OBJECTS (10000)
+
+/**
+ * @brief orm_test_bulk
+ */
+static void orm_test_bulk()
+{
+    ERROR_LOG_CLEAR;
+    std::vector<Object *> objects;
+
+    for (int i = 0; i < BULK_OBJECTS; i++)
+    {
+        objects.push_back(new class2(i));
+    }
+
+    objects.push_back(new class1());
+    ORM::createMany(objects);
+
+    ASSERT_EQUALS(ORM::Repository<class2>::count(), BULK_OBJECTS);
+    ASSERT_EQUALS(ORM::select(OBJECT_TYPE_CLASS2, "1234"), objects[1234]);
+
+    auto *c1 = (class1 *) objects.back();
+    objects.pop_back();
+
+    c1->getMaster()->addMany("class1_class2", objects);
+    ASSERT_EQUALS(c1->getMaster()->get("class1_class2")->size(), BULK_OBJECTS);
+    ASSERT_EQUALS(objects[10]->getSlave()->front("class1_class2"), (Object *) c1);
+
+    /*
+     * Destroying half of slaves and the master sweeps once.
+     */
+    std::vector<Object *> destroyed(objects.begin(), objects.begin() + BULK_OBJECTS / 2);
+
+    destroyed.push_back(c1);
+    ORM::destroyMany(destroyed);
+
+    ASSERT_NULL(ORM::getFirst(OBJECT_TYPE_CLASS1));
+    ASSERT_EQUALS(ORM::Repository<class2>::count(), 0);
+    ASSERT_OK;
+}
+
+/**
+ * @brief orm_test_transaction
+ */
+static void orm_test_transaction()
+{
+    ERROR_LOG_CLEAR;
+    auto *c1 = ORM::create(new class1());
+    auto *c2 = ORM::create(new class2(1));
+
+    c1->addClass2(c2);
+
+    /*
+     * Rollback restores edges and ids, drops created objects.
+     */
+    {
+        ORM::Transaction t;
+
+        c1->addClass2(ORM::create(new class2(2)));
+        c1->getMaster()->remove("class1_class2", c2);
+        ORM::changeId(c1, "renamed");
+        ORM::destroy(c1);
+
+        ASSERT_FALSE(c2->getMarked(), "orphan is held until commit");
+        ASSERT_FALSE(c1->getMarked(), "destroy is held until commit");
+        ASSERT_EQUALS(t.getUndoCount(), 4);
+
+        t.rollback();
+    }
+
+    ASSERT_EQUALS(ORM::select(OBJECT_TYPE_CLASS1, "class1"), (Object *) c1);
+    ASSERT_EQUALS(c1->getMaster()->get("class1_class2")->size(), 1);
+    ASSERT_EQUALS(c1->getMaster()->front("class1_class2"), (Object *) c2);
+    ASSERT_EQUALS(c2->getSlave()->front("class1_class2"), (Object *) c1);
+    ASSERT_EQUALS(ORM::Repository<class2>::count(), 1);
+    ASSERT_FALSE(ORM::inTransaction(), "transaction is closed");
+
+    /*
+     * Savepoint rollback keeps changes of enclosing transaction.
+     */
+    {
+        ORM::Transaction t;
+
+        c1->addClass2(ORM::create(new class2(3)));
+
+        {
+            ORM::Transaction savepoint;
+
+            ASSERT_TRUE(savepoint.isNested(), "savepoint is nested");
+            c1->addClass2(ORM::create(new class2(4)));
+        }
+
+        ASSERT_TRUE(t.commit(), "commit should pass");
+    }
+
+    ASSERT_EQUALS(c1->getMaster()->get("class1_class2")->size(), 2);
+    ASSERT_NOT_NULL(ORM::select(OBJECT_TYPE_CLASS2, "3"));
+    ASSERT_NULL(ORM::select(OBJECT_TYPE_CLASS2, "4"));
+
+    /*
+     * Commit applies held orphan sweep.
+     */
+    {
+        ORM::Transaction t;
+
+        c1->getMaster()->remove("class1_class2", c2);
+        ASSERT_TRUE(t.commit(), "commit should pass");
+    }
+
+    ASSERT_TRUE(c2->getMarked(), "orphan is marked on commit");
+    ORM::sweep();
+    ASSERT_EQUALS(ORM::Repository<class2>::count(), 1);
+
+    /*
+     * Object orphaned by rollback is marked.
+     */
+    auto *loose = ORM::create(new class2(7));
+
+    {
+        ORM::Transaction t;
+
+        c1->addClass2(loose);
+        t.rollback();
+    }
+
+    ASSERT_TRUE(loose->getMarked(), "orphan of rollback is marked");
+    ORM::sweep();
+    ASSERT_NULL(ORM::select(OBJECT_TYPE_CLASS2, "7"));
+
+    /*
+     * Object written by another thread fails commit.
+     */
+    ORM::setConcurrent(true);
+    size_t conflicts = ORM::getTransactionConflicts();
+
+    {
+        ORM::Transaction t;
+
+        t.read(c1);
+        c1->addClass2(ORM::create(new class2(5)));
+
+        std::thread([&]() {
+            c1->addClass2(ORM::create(new class2(6)));
+        }).join();
+
+        ASSERT_FALSE(t.commit(), "commit should fail");
+    }
+
+    ASSERT_EQUALS(ORM::getTransactionConflicts(), conflicts + 1);
+    ASSERT_NULL(ORM::select(OBJECT_TYPE_CLASS2, "5"));
+    ASSERT_NOT_NULL(ORM::select(OBJECT_TYPE_CLASS2, "6"));
+
+    /*
+     * Object written by transaction can't be written by another one,
+     * undo doesn't find its one to one slot filled.
+     */
+    auto *owner = ORM::create(new class1());
+    auto *first = ORM::create(new class1());
+    auto *second = ORM::create(new class1());
+
+    owner->addClass1(first);
+
+    {
+        ORM::Transaction t;
+        bool committed = true;
+
+        owner->getMaster()->remove("class1_class1", first);
+
+        std::thread([&]() {
+            ORM::Transaction other;
+
+            owner->addClass1(second);
+            committed = other.commit();
+        }).join();
+
+        ASSERT_FALSE(committed, "claimed object can't be written");
+        t.rollback();
+    }
+
+    ASSERT_EQUALS(owner->getMaster()->get("class1_class1")->size(), 1);
+    ASSERT_EQUALS(owner->getMaster()->front("class1_class1"), (Object *) first);
+    ASSERT_FALSE(second->getSlave()->hasRelations(), "refused edit is not applied");
+
+    /*
+     * Undo keeps write done outside of transactions.
+     */
+    {
+        ORM::Transaction t;
+
+        ORM::changeId(owner, "transaction");
+
+        std::thread([&]() {
+            ORM::changeId(owner, "outside");
+        }).join();
+
+        ASSERT_FALSE(t.commit(), "commit should fail");
+    }
+
+    ASSERT_TRUE(owner->getId() == "outside", "outside write is kept");
+
+    ORM::setConcurrent(false);
+    ASSERT_OK;
+}
+
+#define HEAP_DUMP_FILE "/tmp/boxvm_heap_dump.bin"
+
+/**
+ * @brief orm_test_introspection
+ */
+static void orm_test_introspection()
+{
+    class1 *big = ORM::create(new class1());
+    class1 *small = ORM::create(new class1());
+
+    for (int i = 0; i < 50; i++)
+    {
+        big->addClass2(ORM::create(new class2(i)));
+    }
+
+    for (int i = 50; i < 60; i++)
+    {
+        small->addClass2(ORM::create(new class2(i)));
+    }
+
+    /*
+     * Marked but not swept yet.
+     */
+    ORM::findObjectRepository(OBJECT_TYPE_CLASS2)->remove(ORM::create(new class2(100)));
+
+    HeapStats heap = ORM::inspect(1);
+    const TypeStats *class1Stats = heap.getType(OBJECT_TYPE_CLASS1);
+    const TypeStats *class2Stats = heap.getType(OBJECT_TYPE_CLASS2);
+
+    ASSERT_NOT_NULL(class1Stats);
+    ASSERT_NOT_NULL(class2Stats);
+    ASSERT_EQUALS(class1Stats->objects, 2);
+    ASSERT_EQUALS(class1Stats->edges, 60);
+    ASSERT_EQUALS(class1Stats->fanout[ORM::getFanoutBucket(50)], 1);
+    ASSERT_EQUALS(class1Stats->fanout[ORM::getFanoutBucket(10)], 1);
+    ASSERT_EQUALS(class2Stats->objects, 61);
+    ASSERT_EQUALS(class2Stats->marked, 1);
+    ASSERT_EQUALS(class2Stats->fanout[0], 61);
+    ASSERT_TRUE(class2Stats->bytes >= 61 * sizeof(Object), "Bytes should be counted!");
+
+    ASSERT_EQUALS(heap.retainers.size(), 1);
+    ASSERT_EQUALS(heap.retainers[0].object, (Object *) big);
+    ASSERT_EQUALS(heap.retainers[0].slaves, 50);
+
+    /*
+     * Dump has every object and master relationship.
+     */
+    ASSERT_TRUE(ORM::dumpHeap(HEAP_DUMP_FILE), "Heap dump should be written!");
+
+    std::ifstream in(HEAP_DUMP_FILE, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    BinaryReader reader(data.data(), data.size());
+
+    ASSERT_EQUALS(reader.getU32(), HEAP_DUMP_MAGIC);
+    ASSERT_EQUALS(reader.getU32(), HEAP_DUMP_VERSION);
+    ASSERT_EQUALS(reader.getU64(), heap.objects);
+
+    size_t edges = 0;
+
+    for (size_t i = 0; i < heap.objects; i++)
+    {
+        reader.getU64();
+        reader.getU32();
+        reader.getString();
+        reader.getU8();
+        reader.getU64();
+
+        uint32_t relationships = reader.getU32();
+
+        for (uint32_t j = 0; j < relationships; j++)
+        {
+            reader.getString();
+            reader.getU8();
+
+            uint32_t slaves = reader.getU32();
+
+            for (uint32_t k = 0; k < slaves; k++)
+            {
+                reader.getU64();
+                edges++;
+            }
+        }
+    }
+
+    ASSERT_TRUE(reader.isOk() && reader.isEnd(), "Dump should be complete!");
+    ASSERT_TRUE(edges >= 60, "Dump should have relationships!");
+
+    remove(HEAP_DUMP_FILE);
+}
+
+#define CONCURRENT_THREADS (8)
+#define CONCURRENT_ITERATIONS (512)
+
+/**
+ * @brief orm_test_concurrent
+ */
+static void orm_test_concurrent()
+{
+    ERROR_LOG_CLEAR;
+    ORM::setConcurrent(true);
+
+    std::atomic<int> failures(0);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < CONCURRENT_THREADS; t++)
+    {
+        threads.emplace_back([t, &failures]() {
+            std::vector<Int *> kept;
+
+            for (int i = 0; i < CONCURRENT_ITERATIONS; i++)
+            {
+                ORM::EpochGuard guard;
+                int value = t * CONCURRENT_ITERATIONS + i;
+
+                Int *n = Int::create(value);
+
+                if (n->toInt() != value)
+                {
+                    failures++;
+                }
+
+                class2 *c2 = ORM::create(new class2(value));
+
+                if (ORM::select(OBJECT_TYPE_CLASS2, std::to_string(value)) != c2)
+                {
+                    failures++;
+                }
+
+                if (i % 2)
+                {
+                    ORM_DESTROY(n);
+                    ORM_DESTROY(c2);
+                }
+                else
+                {
+                    kept.push_back(n);
+                }
+            }
+
+            for (Int *n : kept)
+            {
+                ORM::EpochGuard guard;
+
+                if (n->toInt() % 2 != 0)
+                {
+                    failures++;
+                }
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_EQUALS(failures.load(), 0);
+    ASSERT_EQUALS(ORM::Repository<Int>::count(), CONCURRENT_THREADS * CONCURRENT_ITERATIONS / 2);
+    ASSERT_EQUALS(ORM::Repository<class2>::count(), CONCURRENT_THREADS * CONCURRENT_ITERATIONS / 2);
+
+    /*
+     * Values share one ID, they are still spread over all shards.
+     */
+    ObjectRepository *ints = ORM::findObjectRepository(OBJECT_TYPE_INT);
+    size_t used = 0;
+
+    ASSERT_EQUALS(ints->getShardCount(), ORM_REPOSITORY_SHARDS);
+
+    for (size_t i = 0; i < ints->getShardCount(); i++)
+    {
+        used += ints->getShardSize(i) > 0;
+    }
+
+    ASSERT_EQUALS(used, ORM_REPOSITORY_SHARDS);
+
+    /*
+     * Lookup by ID returns first inserted object, whatever its shard.
+     */
+    std::vector<class2 *> same;
+
+    for (int i = 0; i < ORM_REPOSITORY_SHARDS; i++)
+    {
+        same.push_back(ORM::create(new class2(CONCURRENT_THREADS * CONCURRENT_ITERATIONS)));
+    }
+
+    std::string id = same[0]->getId();
+
+    ASSERT_EQUALS(ORM::select(OBJECT_TYPE_CLASS2, id), same[0]);
+    ORM::changeId(same[0], "renamed");
+    ASSERT_EQUALS(ORM::select(OBJECT_TYPE_CLASS2, id), same[1]);
+    ASSERT_EQUALS(ORM::select(OBJECT_TYPE_CLASS2, "renamed"), same[0]);
+    ORM_DESTROY(same[1]);
+    ORM::sweep();
+    ASSERT_EQUALS(ORM::select(OBJECT_TYPE_CLASS2, id), same[2]);
+
+    /*
+     * No thread is inside epoch, everything retired can go.
+     */
+    ORM::sweep();
+    ASSERT_EQUALS(ORM::getRetiredCount(), 0);
+
+    ORM::setConcurrent(false);
+    ASSERT_OK;
+}
+
 /**
  * Test ORM.
  */
@@ -551,4 +1577,19 @@ void orm_test()
     RUN_TEST(orm_test_change_id());
     RUN_TEST(orm_test_switch_relations1());
     RUN_TEST(orm_test_switch_relations2());
+    RUN_TEST(orm_test_relationship_remove());
+    RUN_TEST(orm_test_singleton());
+    RUN_TEST(orm_test_typed_repository());
+    RUN_TEST(orm_test_repository_index());
+    RUN_TEST(orm_test_object_pool());
+    RUN_TEST(orm_test_relationship_table());
+    RUN_TEST(orm_test_footprint());
+    RUN_TEST(orm_test_handle());
+    RUN_TEST(orm_test_cascade());
+    RUN_TEST(orm_test_parallel_sweep());
+    RUN_TEST(orm_test_freeze());
+    RUN_TEST(orm_test_introspection());
+    RUN_TEST(orm_test_bulk());
+    RUN_TEST(orm_test_transaction());
+    RUN_TEST(orm_test_concurrent());
 }
\ No newline at end of file
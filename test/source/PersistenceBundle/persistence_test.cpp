@@ -0,0 +1,455 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "ORM/ORM.h"
+#include "ErrorBundle/ErrorLog.h"
+#include <MemoryBundle/VirtualMemory.h>
+#include <VariableBundle/Null/Null.h>
+#include <VariableBundle/Collection/Collection.h>
+#include <VariableBundle/Primitive/String.h>
+#include <VariableBundle/Primitive/Int.h>
+#include <PersistenceBundle/Persistence.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+#include "../../include/PersistenceBundle/persistence_test.h"
+#include "../../test_assert.h"
+
+/**
+ * Create empty persistence directory.
+ *
+ * @return directory path.
+ */
+static std::string
+persistence_directory()
+{
+    char path[] = "/tmp/boxvm_persistence_XXXXXX";
+
+    return std::string(mkdtemp(path));
+}
+
+/**
+ * Remove persistence directory.
+ *
+ * @param directory
+ */
+static void
+persistence_remove(const std::string &directory)
+{
+    unlink((directory + "/" PERSISTENCE_CHECKPOINT_FILE).c_str());
+    unlink((directory + "/" PERSISTENCE_LOG_FILE).c_str());
+    rmdir(directory.c_str());
+}
+
+/**
+ * Drop all objects as if process restarted.
+ */
+static void
+persistence_restart()
+{
+    ORM::removeAllRepositories();
+    VirtualMemory::create();
+    Null::create();
+}
+
+/**
+ * Test that committed objects and collection contents are recovered from log.
+ */
+static void
+persistence_test_log_replay()
+{
+    ERROR_LOG_CLEAR;
+    std::string directory = persistence_directory();
+
+    {
+        Persistence persistence(directory);
+        ASSERT_TRUE(persistence.open(), "Persistence should open!");
+
+        Int *number = Int::create(42);
+        ORM::changeId(number, "answer");
+
+        Collection *c = Collection::create();
+        ORM::changeId(c, "people");
+        c->insert("name", String::create(L"Miljenko"));
+        c->insert("age", Int::create(33));
+
+        ASSERT_TRUE(persistence.commit(), "Commit should succeed!");
+        persistence.close();
+    }
+
+    persistence_restart();
+
+    {
+        Persistence persistence(directory);
+        ASSERT_TRUE(persistence.open(), "Persistence should open!");
+
+        auto *number = (Int *) ORM::select(OBJECT_TYPE_INT, "answer");
+        ASSERT_NOT_NULL(number);
+        ASSERT_EQUALS(number->toInt(), 42);
+
+        auto *c = (Collection *) ORM::select(OBJECT_TYPE_COLLECTION, "people");
+        ASSERT_NOT_NULL(c);
+        ASSERT_EQUALS(c->size(), 2);
+        ASSERT_TRUE((*c)["name"]->getString() == L"Miljenko", "Name should be recovered!");
+        ASSERT_EQUALS((*c)["age"]->toInt(), 33);
+
+        persistence.close();
+    }
+
+    persistence_remove(directory);
+    ASSERT_OK;
+}
+
+/**
+ * Test value updates, destroy and checkpoint followed by more changes.
+ */
+static void
+persistence_test_checkpoint()
+{
+    ERROR_LOG_CLEAR;
+    std::string directory = persistence_directory();
+
+    {
+        Persistence persistence(directory);
+        ASSERT_TRUE(persistence.open(), "Persistence should open!");
+
+        Int *kept = Int::create(1);
+        ORM::changeId(kept, "kept");
+        Int *destroyed = Int::create(2);
+        ORM::changeId(destroyed, "destroyed");
+
+        Collection *c = Collection::create();
+        ORM::changeId(c, "c");
+        c->insert("x", Int::create(10));
+
+        ASSERT_TRUE(persistence.checkpoint(), "Checkpoint should succeed!");
+
+        int32_t value = 7;
+        (*kept) = (const void *) &value;
+        persistence.update(kept);
+
+        ORM_DESTROY(destroyed);
+        c->insert("y", Int::create(20));
+
+        persistence.close();
+    }
+
+    persistence_restart();
+
+    {
+        Persistence persistence(directory);
+        ASSERT_TRUE(persistence.open(), "Persistence should open!");
+
+        auto *kept = (Int *) ORM::select(OBJECT_TYPE_INT, "kept");
+        ASSERT_NOT_NULL(kept);
+        ASSERT_EQUALS(kept->toInt(), 7);
+        ASSERT_NULL(ORM::select(OBJECT_TYPE_INT, "destroyed"));
+
+        auto *c = (Collection *) ORM::select(OBJECT_TYPE_COLLECTION, "c");
+        ASSERT_NOT_NULL(c);
+        ASSERT_EQUALS(c->size(), 2);
+        ASSERT_EQUALS((*c)["x"]->toInt(), 10);
+        ASSERT_EQUALS((*c)["y"]->toInt(), 20);
+
+        /*
+         * Recovered state survives another checkpoint.
+         */
+        ASSERT_TRUE(persistence.checkpoint(), "Checkpoint should succeed!");
+        persistence.close();
+    }
+
+    persistence_restart();
+
+    {
+        Persistence persistence(directory);
+        ASSERT_TRUE(persistence.open(), "Persistence should open!");
+
+        auto *c = (Collection *) ORM::select(OBJECT_TYPE_COLLECTION, "c");
+        ASSERT_NOT_NULL(c);
+        ASSERT_EQUALS(c->size(), 2);
+        ASSERT_EQUALS(((Int *) ORM::select(OBJECT_TYPE_INT, "kept"))->toInt(), 7);
+
+        persistence.close();
+    }
+
+    persistence_remove(directory);
+    ASSERT_OK;
+}
+
+/**
+ * Test that torn log tail and uncommitted records are ignored.
+ */
+static void
+persistence_test_torn_log()
+{
+    ERROR_LOG_CLEAR;
+    std::string directory = persistence_directory();
+
+    {
+        Persistence persistence(directory);
+        ASSERT_TRUE(persistence.open(), "Persistence should open!");
+
+        ORM::changeId(Int::create(5), "committed");
+        persistence.commit();
+
+        persistence.close();
+    }
+
+    FILE *fp = fopen((directory + "/" PERSISTENCE_LOG_FILE).c_str(), "ab");
+    ASSERT_NOT_NULL(fp);
+    fwrite("\x40\x00\x00\x00garbage", 1, 11, fp);
+    fclose(fp);
+
+    persistence_restart();
+
+    {
+        Persistence persistence(directory);
+        ASSERT_TRUE(persistence.open(), "Persistence should open!");
+        ASSERT_EQUALS(((Int *) ORM::select(OBJECT_TYPE_INT, "committed"))->toInt(), 5);
+
+        ORM::changeId(Int::create(6), "after");
+        persistence.close();
+    }
+
+    persistence_restart();
+
+    {
+        Persistence persistence(directory);
+        ASSERT_TRUE(persistence.open(), "Persistence should open!");
+        ASSERT_NOT_NULL(ORM::select(OBJECT_TYPE_INT, "committed"));
+        ASSERT_EQUALS(((Int *) ORM::select(OBJECT_TYPE_INT, "after"))->toInt(), 6);
+        persistence.close();
+    }
+
+    persistence_remove(directory);
+    ASSERT_OK;
+}
+
+/**
+ * Test that failed commit leaves no torn record in front of later commits.
+ */
+static void
+persistence_test_failed_commit()
+{
+    ERROR_LOG_CLEAR;
+    std::string directory = persistence_directory();
+    std::string path = directory + "/" PERSISTENCE_LOG_FILE;
+    struct rlimit limit;
+
+    getrlimit(RLIMIT_FSIZE, &limit);
+    signal(SIGXFSZ, SIG_IGN);
+
+    {
+        Persistence persistence(directory);
+        ASSERT_TRUE(persistence.open(), "Persistence should open!");
+
+        ORM::changeId(Int::create(1), "first");
+        ASSERT_TRUE(persistence.commit(), "Commit should succeed!");
+
+        struct stat st;
+        stat(path.c_str(), &st);
+
+        /*
+         * Log may grow by few bytes only, write of next group is torn.
+         */
+        struct rlimit small = limit;
+        small.rlim_cur = (rlim_t) st.st_size + 8;
+        setrlimit(RLIMIT_FSIZE, &small);
+
+        ORM::changeId(Int::create(2), "second");
+        ASSERT_FALSE(persistence.commit(), "Commit over file size limit should fail!");
+
+        setrlimit(RLIMIT_FSIZE, &limit);
+
+        struct stat after;
+        stat(path.c_str(), &after);
+        ASSERT_EQUALS(after.st_size, st.st_size);
+
+        /*
+         * Failed group is written by next commit.
+         */
+        ORM::changeId(Int::create(3), "third");
+        ASSERT_TRUE(persistence.commit(), "Commit should succeed!");
+        persistence.close();
+    }
+
+    signal(SIGXFSZ, SIG_DFL);
+    persistence_restart();
+
+    {
+        Persistence persistence(directory);
+        ASSERT_TRUE(persistence.open(), "Persistence should open!");
+        ASSERT_EQUALS(((Int *) ORM::select(OBJECT_TYPE_INT, "first"))->toInt(), 1);
+        ASSERT_EQUALS(((Int *) ORM::select(OBJECT_TYPE_INT, "second"))->toInt(), 2);
+        ASSERT_EQUALS(((Int *) ORM::select(OBJECT_TYPE_INT, "third"))->toInt(), 3);
+        persistence.close();
+    }
+
+    persistence_remove(directory);
+    ASSERT_OK;
+}
+
+/**
+ * Count objects of type with id.
+ *
+ * @param type
+ * @param id
+ * @return number of objects.
+ */
+static size_t
+persistence_count(eObjectType type, const std::string &id)
+{
+    size_t count = 0;
+
+    ORM::select(type, [&](Object *o) {
+        count += (o->getId() == id) ? 1 : 0;
+        return false;
+    });
+
+    return count;
+}
+
+/**
+ * Test crash after checkpoint is renamed and before log is emptied.
+ */
+static void
+persistence_test_checkpoint_crash()
+{
+    ERROR_LOG_CLEAR;
+    std::string directory = persistence_directory();
+    std::string logPath = directory + "/" PERSISTENCE_LOG_FILE;
+    std::string staleLog;
+
+    {
+        Persistence persistence(directory);
+        ASSERT_TRUE(persistence.open(), "Persistence should open!");
+
+        ORM::changeId(Int::create(1), "before");
+        Collection *c = Collection::create();
+        ORM::changeId(c, "c");
+        c->insert("x", Int::create(10));
+
+        ASSERT_TRUE(persistence.commit(), "Commit should succeed!");
+
+        std::ifstream in(logPath, std::ios::binary);
+        staleLog.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        ASSERT_FALSE(staleLog.empty(), "Log should hold the commit!");
+
+        ASSERT_TRUE(persistence.checkpoint(), "Checkpoint should succeed!");
+
+        ORM::changeId(Int::create(2), "after");
+        c->insert("y", Int::create(20));
+
+        persistence.close();
+    }
+
+    /*
+     * Log as if truncate never happened, commits already
+     * in checkpoint are followed by the later ones.
+     */
+    std::string log;
+    {
+        std::ifstream in(logPath, std::ios::binary);
+        log.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    {
+        std::ofstream out(logPath, std::ios::binary | std::ios::trunc);
+        out << staleLog << log;
+    }
+
+    persistence_restart();
+
+    {
+        Persistence persistence(directory);
+        ASSERT_TRUE(persistence.open(), "Persistence should open!");
+
+        ASSERT_EQUALS(persistence_count(OBJECT_TYPE_INT, "before"), (size_t) 1);
+        ASSERT_EQUALS(persistence_count(OBJECT_TYPE_INT, "after"), (size_t) 1);
+        ASSERT_EQUALS(persistence_count(OBJECT_TYPE_COLLECTION, "c"), (size_t) 1);
+
+        auto *c = (Collection *) ORM::select(OBJECT_TYPE_COLLECTION, "c");
+        ASSERT_EQUALS(c->size(), 2);
+        ASSERT_EQUALS((*c)["x"]->toInt(), 10);
+        ASSERT_EQUALS((*c)["y"]->toInt(), 20);
+
+        /*
+         * Commits after recovery are not taken for old ones.
+         */
+        ORM::changeId(Int::create(3), "recovered");
+        persistence.close();
+    }
+
+    persistence_restart();
+
+    {
+        Persistence persistence(directory);
+        ASSERT_TRUE(persistence.open(), "Persistence should open!");
+        ASSERT_EQUALS(persistence_count(OBJECT_TYPE_INT, "before"), (size_t) 1);
+        ASSERT_EQUALS(((Int *) ORM::select(OBJECT_TYPE_INT, "recovered"))->toInt(), 3);
+        persistence.close();
+    }
+
+    persistence_remove(directory);
+    ASSERT_OK;
+}
+
+/**
+ * Test that many changes share one commit.
+ */
+static void
+persistence_test_group_commit()
+{
+    ERROR_LOG_CLEAR;
+    std::string directory = persistence_directory();
+    Persistence persistence(directory);
+    ASSERT_TRUE(persistence.open(), "Persistence should open!");
+
+    for (int32_t i = 0; i < PERSISTENCE_GROUP_COMMIT * 2; i++)
+    {
+        Int::create(i);
+    }
+
+    ASSERT_TRUE(persistence.getCommitCount() >= 1, "Full group should be committed!");
+    ASSERT_TRUE(persistence.getCommitCount() <= 3, "Changes should share commits!");
+
+    persistence.close();
+    persistence_remove(directory);
+    ASSERT_OK;
+}
+
+void
+persistence_test()
+{
+    RUN_TEST(persistence_test_log_replay());
+    RUN_TEST(persistence_test_checkpoint());
+    RUN_TEST(persistence_test_torn_log());
+    RUN_TEST(persistence_test_failed_commit());
+    RUN_TEST(persistence_test_checkpoint_crash());
+    RUN_TEST(persistence_test_group_commit());
+}
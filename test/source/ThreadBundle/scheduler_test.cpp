@@ -0,0 +1,462 @@
+/*
+ * Copyright 2018 Duje Senta
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <ORM/ORM.h>
+#include <ORM/Concurrency.h>
+#include <ErrorBundle/ErrorLog.h>
+#include <MemoryBundle/VirtualMemory.h>
+#include <MethodBundle/Method.h>
+#include <MethodBundle/Instruction/CreateInstruction.h>
+#include <MethodBundle/Instruction/AssignInstruction.h>
+#include <MethodBundle/Instruction/ArithmeticInstruction.h>
+#include <ThreadBundle/Thread.h>
+#include <ThreadBundle/Scheduler.h>
+#include <ThreadBundle/TimerWheel.h>
+#include "../../include/ThreadBundle/scheduler_test.h"
+#include "../../test_assert.h"
+#include <chrono>
+#include <thread>
+
+static VirtualMemory *vm;
+
+#define SCHEDULER_THREADS (8)
+#define SCHEDULER_ADDS (THREAD_BUDGET + THREAD_BUDGET / 4)
+#define SCHEDULER_SLEEPERS (1000)
+
+/**
+ * Create thread adding its stack into variable.
+ *
+ * @param id - thread id.
+ * @param adds - number of additions.
+ * @return thread.
+ */
+static Thread *
+scheduler_test_thread(uint64_t id, int adds)
+{
+    std::vector<Instruction *> instructions;
+
+    instructions.push_back(CreateInstruction::create(L"i", L"int"));
+
+    for (int i = 0; i < adds; i++)
+    {
+        instructions.push_back(ArithmeticInstruction::create(OP_CODE_ADD, L"i"));
+    }
+
+    Method *m = Method::create("m" + std::to_string(id), instructions);
+    Thread *thread = Thread::create(id, m);
+
+    m->compile();
+
+    for (int i = 0; i < adds; i++)
+    {
+        thread->pushTagged(TaggedValue::fromInt((int32_t) id));
+    }
+
+    return thread;
+}
+
+/**
+ * scheduler test run.
+ */
+static void
+scheduler_test_run()
+{
+    ERROR_LOG_CLEAR;
+    std::vector<Thread *> threads;
+
+    for (uint64_t id = 0; id < SCHEDULER_THREADS; id++)
+    {
+        threads.push_back(scheduler_test_thread(id, SCHEDULER_ADDS));
+    }
+
+    ORM::setConcurrent(true);
+
+    {
+        Scheduler scheduler(4);
+        ASSERT_EQUALS(scheduler.getWorkerCount(), 4);
+
+        for (Thread *thread : threads)
+        {
+            scheduler.spawn(thread);
+        }
+
+        scheduler.wait();
+        ASSERT_EQUALS(scheduler.takeFinished().size(), SCHEDULER_THREADS);
+        ASSERT_TRUE(scheduler.takeFinished().empty(), "finished threads should be taken once");
+        ASSERT_EQUALS(scheduler.getFailedCount(), 0);
+
+        /*
+         * Workers without threads sleep.
+         */
+        for (int i = 0; (i < 1000) && (scheduler.getSleepingCount() < 4); i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        ASSERT_EQUALS(scheduler.getSleepingCount(), 4);
+    }
+
+    ORM::setConcurrent(false);
+
+    for (uint64_t id = 0; id < SCHEDULER_THREADS; id++)
+    {
+        Thread *thread = threads[id];
+        Method *m = (Method *) thread->getMaster()->front("Thread");
+
+        ASSERT_EQUALS(thread->getState(), THREAD_STATE_FINISHED);
+        ASSERT_EQUALS(m->getFrame()[0].value.asInt(), (int32_t) (id * SCHEDULER_ADDS));
+    }
+
+    ASSERT_OK;
+}
+
+/**
+ * scheduler test error.
+ */
+static void
+scheduler_test_error()
+{
+    ERROR_LOG_CLEAR;
+    std::vector<Instruction *> instructions;
+
+    instructions.push_back(AssignInstruction::create(L"undefined"));
+
+    Method *m = Method::create("m", instructions);
+    Thread *failing = Thread::create(0, m);
+    Thread *thread = scheduler_test_thread(1, 10);
+
+    Scheduler scheduler(2);
+    scheduler.spawn(failing);
+    scheduler.spawn(thread);
+    scheduler.wait();
+
+    /*
+     * Error stays with thread, it does not reach caller.
+     */
+    ASSERT_EQUALS(scheduler.getFailedCount(), 1);
+    ASSERT_EQUALS(failing->getState(), THREAD_STATE_ERROR);
+    ASSERT_EQUALS(failing->getError(), ERROR_INSTRUCTION_OBJECT_DOES_NOT_EXIST);
+    ASSERT_EQUALS(thread->getState(), THREAD_STATE_FINISHED);
+    ASSERT_EQUALS(thread->getError(), STATUS_OK);
+    ASSERT_OK;
+
+    /*
+     * Thread run on caller finishes without error.
+     */
+    Thread *direct = scheduler_test_thread(2, 10);
+    direct->run();
+    ASSERT_EQUALS(direct->getState(), THREAD_STATE_FINISHED);
+    ASSERT_FALSE(direct->step(), "finished thread should not step");
+    ASSERT_OK;
+}
+
+/**
+ * scheduler test timer wheel.
+ */
+static void
+scheduler_test_timer_wheel()
+{
+    uint64_t deadlines[] = {1, 255, 256, 257, 65535, 70000, 16777300};
+    std::vector<Thread *> expired;
+
+    for (uint64_t deadline : deadlines)
+    {
+        TimerWheel wheel;
+        Thread *thread = (Thread *) (uintptr_t) (deadline + 1);
+
+        wheel.add(thread, deadline);
+        ASSERT_EQUALS(wheel.size(), 1);
+        ASSERT_TRUE(wheel.nextExpiry() <= deadline, "next expiry should not be after deadline");
+
+        /*
+         * Timer is not expired before deadline, even across cascades.
+         */
+        wheel.advance(deadline - 1, expired);
+        ASSERT_TRUE(expired.empty(), "timer should not expire before deadline");
+        ASSERT_EQUALS(wheel.getCurrent(), deadline - 1);
+
+        wheel.advance(deadline, expired);
+        ASSERT_EQUALS(expired.size(), 1);
+        ASSERT_TRUE(expired[0] == thread, "expired timer should be the added one");
+        ASSERT_EQUALS(wheel.size(), 0);
+        ASSERT_EQUALS(wheel.nextExpiry(), TIMER_WHEEL_NEVER);
+        expired.clear();
+    }
+
+    /*
+     * Timer in past expires on next advance.
+     */
+    TimerWheel wheel(100);
+    wheel.add(nullptr, 10);
+    wheel.advance(101, expired);
+    ASSERT_EQUALS(expired.size(), 1);
+    ASSERT_EQUALS(wheel.size(), 0);
+}
+
+/**
+ * scheduler test sleep.
+ */
+static void
+scheduler_test_sleep()
+{
+    ERROR_LOG_CLEAR;
+    std::vector<Thread *> threads;
+
+    for (uint64_t id = 0; id < SCHEDULER_SLEEPERS; id++)
+    {
+        threads.push_back(scheduler_test_thread(SCHEDULER_THREADS + id, 1));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t id = 0; id < SCHEDULER_SLEEPERS; id++)
+    {
+        Thread *thread = threads[id];
+        thread->sleep(20 + id % 30);
+        ASSERT_EQUALS(thread->getState(), THREAD_STATE_SLEEPING);
+    }
+
+    ORM::setConcurrent(true);
+
+    {
+        Scheduler scheduler(4);
+
+        for (Thread *thread : threads)
+        {
+            scheduler.spawn(thread);
+        }
+
+        scheduler.wait();
+        auto now = std::chrono::steady_clock::now();
+
+        for (Thread *thread : threads)
+        {
+            ASSERT_TRUE(now >= thread->getWakeTime(), "thread should not wake early");
+        }
+
+        ASSERT_EQUALS(scheduler.takeFinished().size(), SCHEDULER_SLEEPERS);
+        ASSERT_EQUALS(scheduler.getParkedCount(), 0);
+        ASSERT_EQUALS(scheduler.getFailedCount(), 0);
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ORM::setConcurrent(false);
+
+    /*
+     * Sleeping threads do not occupy workers, all of them wake together.
+     */
+    ASSERT_TRUE(elapsed >= std::chrono::milliseconds(20), "threads should not wake early");
+
+    for (Thread *thread : threads)
+    {
+        ASSERT_EQUALS(thread->getState(), THREAD_STATE_FINISHED);
+    }
+
+    ASSERT_OK;
+}
+
+/**
+ * scheduler test budget.
+ */
+static void
+scheduler_test_budget()
+{
+    ERROR_LOG_CLEAR;
+    Thread *thread = scheduler_test_thread(1, SCHEDULER_ADDS);
+    Method *m = (Method *) thread->getMaster()->front("Thread");
+
+    ASSERT_EQUALS(thread->getBudget(), THREAD_BUDGET);
+    ASSERT_EQUALS(thread->getTimeSlice(), THREAD_TIME_SLICE);
+    ASSERT_EQUALS(thread->getPriority(), THREAD_PRIORITY_NORMAL);
+
+    /*
+     * Quantum ends after budget, create and 99 additions.
+     */
+    thread->setBudget(100, 0);
+    ASSERT_EQUALS(thread->execute(), THREAD_STATE_READY);
+    ASSERT_EQUALS(m->getFrame()[0].value.asInt(), 99);
+
+    thread->setBudget(0, 0);
+    ASSERT_EQUALS(thread->getBudget(), 1);
+    ASSERT_EQUALS(thread->execute(), THREAD_STATE_READY);
+    ASSERT_EQUALS(m->getFrame()[0].value.asInt(), 100);
+
+    /*
+     * Time slice ends quantum at clock read, before instruction budget.
+     */
+    thread->setBudget(SIZE_MAX, 1);
+    ASSERT_EQUALS(thread->execute(), THREAD_STATE_READY);
+
+    int32_t executed = m->getFrame()[0].value.asInt() - 100;
+    ASSERT_TRUE(executed > 0, "thread should execute in time slice");
+    ASSERT_TRUE(executed < SCHEDULER_ADDS - 100, "time slice should end quantum");
+    ASSERT_EQUALS(executed % THREAD_CLOCK_INTERVAL, 0);
+
+    thread->setBudget(SIZE_MAX, 0);
+    ASSERT_EQUALS(thread->execute(), THREAD_STATE_FINISHED);
+    ASSERT_EQUALS(m->getFrame()[0].value.asInt(), SCHEDULER_ADDS);
+    ASSERT_OK;
+}
+
+/**
+ * scheduler test priority.
+ */
+static void
+scheduler_test_priority()
+{
+    ERROR_LOG_CLEAR;
+    Thread *interactive = scheduler_test_thread(1, 10);
+    Thread *batch[] = {
+        scheduler_test_thread(2, SCHEDULER_ADDS),
+        scheduler_test_thread(3, SCHEDULER_ADDS)
+    };
+
+    interactive->setPriority(THREAD_PRIORITY_HIGH);
+
+    for (Thread *thread : batch)
+    {
+        thread->setPriority(THREAD_PRIORITY_LOW);
+        thread->setBudget(THREAD_BUDGET / 8, 0);
+    }
+
+    std::vector<Thread *> finished;
+
+    {
+        Scheduler scheduler(1);
+
+        scheduler.spawn(interactive);
+        scheduler.spawn(batch[0]);
+        scheduler.spawn(batch[1]);
+        scheduler.wait();
+
+        finished = scheduler.takeFinished();
+    }
+
+    /*
+     * Interactive thread does not wait behind batch threads.
+     */
+    ASSERT_EQUALS(finished.size(), 3);
+    ASSERT_TRUE(finished[0] == interactive, "thread of high priority should finish first");
+
+    for (int i = 0; i < 2; i++)
+    {
+        Method *m = (Method *) batch[i]->getMaster()->front("Thread");
+        ASSERT_EQUALS(batch[i]->getState(), THREAD_STATE_FINISHED);
+        ASSERT_EQUALS(m->getFrame()[0].value.asInt(), (i + 2) * SCHEDULER_ADDS);
+    }
+
+    ASSERT_OK;
+}
+
+/**
+ * scheduler test aging.
+ */
+static void
+scheduler_test_aging()
+{
+    ERROR_LOG_CLEAR;
+    Thread *batch = scheduler_test_thread(1, 10);
+    std::vector<Thread *> interactive;
+    std::vector<Thread *> finished;
+    size_t spawned = 0;
+
+    batch->setPriority(THREAD_PRIORITY_LOW);
+
+    for (uint64_t id = 2; id < 2 + SCHEDULER_THREADS; id++)
+    {
+        Thread *thread = scheduler_test_thread(id, SCHEDULER_ADDS);
+
+        thread->setPriority(THREAD_PRIORITY_HIGH);
+        thread->setBudget(1, 0);
+        interactive.push_back(thread);
+    }
+
+    ORM::setConcurrent(true);
+
+    {
+        Scheduler scheduler(1);
+
+        /*
+         * Worker waits for graph lock in first quantum, so low thread
+         * is queued behind high threads before any of them runs.
+         */
+        {
+            ORM::Lock lock;
+
+            while (spawned < interactive.size() / 2)
+            {
+                scheduler.spawn(interactive[spawned++]);
+            }
+
+            scheduler.spawn(batch);
+        }
+
+        /*
+         * More high threads keep arriving, each runs for many quanta.
+         */
+        while (spawned < interactive.size())
+        {
+            scheduler.spawn(interactive[spawned++]);
+
+            for (Thread *thread : scheduler.takeFinished())
+            {
+                finished.push_back(thread);
+            }
+        }
+
+        scheduler.wait();
+
+        for (Thread *thread : scheduler.takeFinished())
+        {
+            finished.push_back(thread);
+        }
+    }
+
+    ORM::setConcurrent(false);
+
+    ASSERT_EQUALS(finished.size(), interactive.size() + 1);
+    ASSERT_TRUE(finished[0] == batch, "thread of low priority should finish before high threads");
+
+    for (Thread *thread : interactive)
+    {
+        ASSERT_EQUALS(thread->getState(), THREAD_STATE_FINISHED);
+    }
+
+    ASSERT_OK;
+}
+
+/**
+ * scheduler test.
+ */
+void scheduler_test()
+{
+    vm = (VirtualMemory *) ORM::getFirst(OBJECT_TYPE_VIRTUAL_MEMORY);
+    RUN_TEST_VM(scheduler_test_run());
+    RUN_TEST_VM(scheduler_test_error());
+    RUN_TEST_VM(scheduler_test_timer_wheel());
+    RUN_TEST_VM(scheduler_test_sleep());
+    RUN_TEST_VM(scheduler_test_budget());
+    RUN_TEST_VM(scheduler_test_priority());
+    RUN_TEST_VM(scheduler_test_aging());
+}
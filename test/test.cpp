@@ -27,8 +27,11 @@
 #include "include/MemoryBundle/virtual_memory_test.h"
 #include "include/VariableBundle/file/file_test.h"
 #include "include/MethodBundle/Instruction/create_instruction_test.h"
+#include "include/MethodBundle/bytecode_test.h"
+#include "include/ThreadBundle/scheduler_test.h"
 #include "include/VariableBundle/Primitive/data_type_test.h"
 #include "include/VariableBundle/Primitive/primitive_data_test.h"
+#include "include/PersistenceBundle/persistence_test.h"
 #include <cstdio>
 
 #define RUN_TEST_SECTION(__test__) \
@@ -51,6 +54,9 @@ void run_tests()
     RUN_TEST_SECTION(collection_test);
     RUN_TEST_SECTION(file_test);
     RUN_TEST_SECTION(create_instruction_test);
+    RUN_TEST_SECTION(bytecode_test);
+    RUN_TEST_SECTION(scheduler_test);
+    RUN_TEST_SECTION(persistence_test);
 
     printf("TESTS ARE OK!\n");
 }